@@ -0,0 +1,180 @@
+// DSPTest.c
+// Runs on Linux
+// Unit tests of the kernels in inc/DSP.c, compiled unchanged,
+// against direct references computed with 64-bit sums:
+//  - DSP_Dot, DSP_Sum and DSP_SumSquares on even and odd
+//    lengths, including 0 and full-scale samples
+//  - DSP_FIR over blocks of changing size, so the state kept
+//    between blocks is checked, and in place (out = in)
+//  - DSP_Biquad with a low-pass section and with full-scale
+//    inputs and coefficients, where a 32-bit sum would overflow
+//  - DSP_Decimate
+// Build the plain C path, and the SIMD path with the C models
+// of the Cortex-M4 intrinsics in SimdModel.h:
+//   gcc -O2 -fno-strict-aliasing -I../inc -o DSPTest DSPTest.c
+//       ../inc/DSP.c
+//   gcc -O2 -fno-strict-aliasing -I../inc -DDSP_SIMD
+//       -include SimdModel.h -o DSPTestSimd DSPTest.c ../inc/DSP.c
+// Usage:
+//   DSPTest
+//   DSPTestSimd
+// The exit status is 1 if any kernel differs from its reference.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "DSP.h"
+
+#define N 1000
+#define TAPS 16
+#define MAXBLOCK 64
+int16_t X[N] __attribute__((aligned(4)));
+int16_t Y[N] __attribute__((aligned(4)));
+int16_t Coef[TAPS] __attribute__((aligned(4)));
+int16_t State[TAPS+MAXBLOCK] __attribute__((aligned(4)));
+int16_t Out[N] __attribute__((aligned(4)));
+uint32_t Errors;
+
+static void expect(const char *name, uint32_t i, int64_t result, int64_t ref){
+  if(result != ref){
+    if(Errors < 10){
+      printf("%s %u: %lld, should be %lld\n", name, i, (long long)result, (long long)ref);
+    }
+    Errors = Errors + 1;
+  }
+}
+static int32_t sat16(int64_t x){
+  if(x > 32767) return 32767;
+  if(x < -32768) return -32768;
+  return (int32_t)x;
+}
+static int16_t random16(int32_t range){  // -range to range-1
+  return (int16_t)(rand()%(2*range) - range);
+}
+
+static void testsums(void){ uint32_t n, i;
+  int64_t dot, sum;
+  uint64_t sq;
+  for(i=0; i<N; i=i+1){
+    X[i] = random16(32768);
+    Y[i] = random16(32);      // |X[i]*Y[i]| < 2^20, DSP_Dot can not overflow
+  }
+  X[0] = -32768;              // full scale at both ends of the pairs
+  X[1] = -32768;
+  for(n=0; n<N; n=(n < 8) ? n+1 : n+37){
+    dot = sum = 0;
+    sq = 0;
+    for(i=0; i<n; i=i+1){
+      dot = dot + X[i]*Y[i];
+      sum = sum + X[i];
+      sq = sq + (uint64_t)((int64_t)X[i]*X[i]);
+    }
+    expect("DSP_Dot n", n, DSP_Dot(X, Y, n), dot);
+    expect("DSP_Sum n", n, DSP_Sum(X, n), sum);
+    expect("DSP_SumSquares n", n, (int64_t)DSP_SumSquares(X, n), (int64_t)sq);
+  }
+}
+
+// reference output for input t: Coef is reversed, Coef[TAPS-1] is h[0]
+static int32_t firref(const int16_t *x, int32_t t){ int64_t acc = 0x4000;
+  int32_t k;
+  for(k=0; k<TAPS; k=k+1){
+    if(t - k >= 0){
+      acc = acc + (int64_t)Coef[TAPS-1-k]*x[t-k];
+    }
+  }
+  return sat16(acc>>15);
+}
+static void testfir(void){ firType f;
+  uint32_t i, n, pos = 0, b = 0;
+  for(i=0; i<TAPS; i=i+1){
+    Coef[i] = random16(3000); // sum of |Coef| under 65,536, no overflow
+  }
+  for(i=0; i<N; i=i+1){
+    X[i] = random16(32768);
+  }
+  DSP_FIR_Init(&f, Coef, State, TAPS, MAXBLOCK);
+  while(1){
+    n = 2 + 2*(b%(MAXBLOCK/2));
+    if(pos + n > N) break;
+    DSP_FIR(&f, &X[pos], &Out[pos], n);
+    pos = pos + n;
+    b = b + 1;
+  }
+  for(i=0; i<pos; i=i+1){
+    expect("DSP_FIR output", i, Out[i], firref(X, i));
+  }
+  for(i=0; i<N; i=i+1){
+    Y[i] = X[i];
+  }
+  DSP_FIR_Init(&f, Coef, State, TAPS, MAXBLOCK);
+  for(i=0; i+MAXBLOCK<=N; i=i+MAXBLOCK){
+    DSP_FIR(&f, &Y[i], &Y[i], MAXBLOCK); // in place
+  }
+  for(i=0; i<(N/MAXBLOCK)*MAXBLOCK; i=i+1){
+    expect("DSP_FIR in place output", i, Y[i], firref(X, i));
+  }
+}
+
+// biquad of x[0] to x[n-1] with a 64-bit accumulator
+static void biquadref(const int16_t *c, const int16_t *x, int16_t *y, uint32_t n){
+  int64_t x1 = 0, x2 = 0, y1 = 0, y2 = 0, acc;
+  uint32_t i;
+  for(i=0; i<n; i=i+1){
+    acc = 0x2000 + c[0]*(int64_t)x[i] + c[1]*x1 + c[2]*x2 - c[3]*y1 - c[4]*y2;
+    x2 = x1;
+    x1 = x[i];
+    y2 = y1;
+    y1 = sat16(acc>>14);
+    y[i] = (int16_t)y1;
+  }
+}
+static void testbiquad(void){ biquadType f;
+  static const int16_t lowpass[5] = {1024, 2048, 1024, -24000, 9500};
+  static const int16_t extreme[5] = {32767, 32767, 32767, -32768, 32767};
+  const int16_t *c;
+  uint32_t i, j;
+  for(j=0; j<2; j=j+1){
+    c = j ? extreme : lowpass;
+    for(i=0; i<N; i=i+1){
+      X[i] = j ? ((i&4) ? 32767 : -32768) : random16(32768);
+    }
+    biquadref(c, X, Y, N);
+    DSP_Biquad_Init(&f, c[0], c[1], c[2], c[3], c[4]);
+    DSP_Biquad(&f, X, Out, 300);         // two calls, state carried over
+    DSP_Biquad(&f, &X[300], &Out[300], N-300);
+    for(i=0; i<N; i=i+1){
+      expect(j ? "DSP_Biquad full scale output" : "DSP_Biquad low-pass output", i, Out[i], Y[i]);
+    }
+  }
+}
+
+static void testdecimate(void){ uint32_t i, k, n;
+  int32_t sum;
+  for(i=0; i<N; i=i+1){
+    X[i] = random16(32768);
+  }
+  n = DSP_Decimate(X, Out, 800, 8);
+  expect("DSP_Decimate count", 0, n, 100);
+  for(i=0; i<100; i=i+1){
+    sum = 0;
+    for(k=0; k<8; k=k+1){
+      sum = sum + X[8*i+k];
+    }
+    expect("DSP_Decimate output", i, Out[i], sum/8);
+  }
+}
+
+int main(void){
+  srand(2);
+  testsums();
+  testfir();
+  testbiquad();
+  testdecimate();
+#ifdef DSP_SIMD
+  printf("SIMD path: %u errors\n", Errors);
+#else
+  printf("C path: %u errors\n", Errors);
+#endif
+  return Errors != 0;
+}
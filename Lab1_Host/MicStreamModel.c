@@ -0,0 +1,166 @@
+// MicStreamModel.c
+// Runs on Linux
+// Host model and test of the ping-pong handoff between DMA
+// channel 7 and DMA_INT1_IRQHandler() in inc/BSP.c, used by
+// BSP_Microphone_StartStream().  The model DMA controller moves
+// one numbered sample per ADC request into the structure in use,
+// like the uDMA in ping-pong mode:
+//  - when a structure finishes, its CYCLE_CTRL becomes 0 (stop),
+//    the controller switches to the other structure and the done
+//    interrupt is pended
+//  - a request that finds the structure in use stopped disables
+//    the channel, and samples are lost until DMA_ENASET
+// The interrupt runs a random number of sample periods after it
+// is pended, up to a maximum latency.  dmaisr() below is the body
+// of DMA_INT1_IRQHandler(); keep the two the same.
+// Checks, for buffer sizes 1, 8 and 100:
+//  - every block holds consecutive samples and blocks arrive in
+//    order, with no block delivered twice
+//  - with latency under one buffer no sample is lost
+//  - with longer latency samples are lost only between blocks,
+//    and the stream keeps running to the end
+// Build:
+//   gcc -O2 -o MicStreamModel MicStreamModel.c
+// Usage:
+//   MicStreamModel
+// The exit status is 1 if any check fails.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MICDMACH 7           // as in inc/BSP.c
+#define MAXN 100
+#define SAMPLES 1000000      // ADC requests per run
+
+// model of the DMA controller
+uintptr_t DMATable[64];      // primary structures, then alternate
+uintptr_t *DMAPrimary = &DMATable[0];
+uintptr_t *DMAAlternate = &DMATable[32];
+uint32_t UseAlt;             // 1 if the alternate structure is in use
+uint32_t Enabled;            // channel enable, DMA_ENASET sets it
+uint32_t Pending;            // DMA_INT1 pended
+uint16_t Sample;             // number of the next ADC result
+uint32_t Lost;               // ADC results not moved
+
+// state of inc/BSP.c
+uint16_t Buf0[MAXN], Buf1[MAXN];
+uint16_t *MicBuf[2];
+uint32_t MicN, MicNext, MicControl;
+
+// what the user task saw
+uint32_t Blocks, Errors;
+uint16_t Expect;             // sample after the last one delivered
+
+// user task: each block must be consecutive samples after the last
+void task(uint16_t *buf, uint32_t n){ uint32_t i;
+  if((Blocks > 0) && ((uint16_t)(buf[0] - Expect) >= 0x8000)){
+    if(Errors < 5) printf("block %u starts at %u, before %u\n", Blocks, buf[0], Expect);
+    Errors = Errors + 1;
+  }
+  for(i=1; i<n; i=i+1){
+    if(buf[i] != (uint16_t)(buf[0] + i)){
+      if(Errors < 5) printf("block %u has a gap at %u\n", Blocks, i);
+      Errors = Errors + 1;
+      break;
+    }
+  }
+  Expect = buf[n-1] + 1;
+  Blocks = Blocks + 1;
+}
+
+// DMA_INT1_IRQHandler() of inc/BSP.c, DMA_ENASET as Enabled
+void dmaisr(void){ uintptr_t *done;
+  done = MicNext ? DMAAlternate : DMAPrimary;
+  while((done[4*MICDMACH+2]&0x07) == 0){
+    done[4*MICDMACH+1] = (uintptr_t)&MicBuf[MicNext][MicN-1];
+    done[4*MICDMACH+2] = MicControl;  // re-arm for the next time around
+    task(MicBuf[MicNext], MicN);
+    MicNext = MicNext^1;
+    done = MicNext ? DMAAlternate : DMAPrimary;
+  }
+  Enabled = 1;                     // restart if both buffers had filled
+}
+
+// one ADC conversion requests one DMA transfer
+void dmarequest(void){ uintptr_t *s;
+  uint32_t left;
+  s = UseAlt ? DMAAlternate : DMAPrimary;
+  if(Enabled && ((s[4*MICDMACH+2]&0x07) == 0)){
+    Enabled = 0;               // stopped structure disables the channel
+  }
+  if(Enabled == 0){
+    Lost = Lost + 1;
+    Sample = Sample + 1;
+    return;
+  }
+  left = (s[4*MICDMACH+2]>>4)&0x3FF; // transfers left minus one
+  ((uint16_t *)s[4*MICDMACH+1])[-(int32_t)left] = Sample;
+  Sample = Sample + 1;
+  if(left == 0){
+    s[4*MICDMACH+2] = s[4*MICDMACH+2]&~0x3FF7; // CYCLE_CTRL stop
+    UseAlt = UseAlt^1;
+    Pending = 1;
+  } else{
+    s[4*MICDMACH+2] = s[4*MICDMACH+2] - 0x10;
+  }
+}
+
+// BSP_Microphone_StartStream() then SAMPLES requests with the
+// interrupt running 0 to maxlatency sample periods after it is
+// pended.  Returns the number of errors.
+uint32_t run(uint32_t n, uint32_t maxlatency){ uint32_t i, wait = 0;
+  MicBuf[0] = Buf0;
+  MicBuf[1] = Buf1;
+  MicN = n;
+  MicNext = 0;
+  MicControl = 0x5D000003|((n - 1)<<4);
+  DMAPrimary[4*MICDMACH+1] = (uintptr_t)&Buf0[n-1];
+  DMAPrimary[4*MICDMACH+2] = MicControl;
+  DMAAlternate[4*MICDMACH+1] = (uintptr_t)&Buf1[n-1];
+  DMAAlternate[4*MICDMACH+2] = MicControl;
+  UseAlt = 0;
+  Enabled = 1;
+  Pending = 0;
+  Sample = 0;
+  Lost = 0;
+  Blocks = 0;
+  Errors = 0;
+  for(i=0; i<SAMPLES; i=i+1){
+    dmarequest();
+    if(Pending){
+      if(wait == 0){
+        wait = 1 + rand()%(maxlatency + 1);
+      }
+      wait = wait - 1;
+      if(wait == 0){
+        Pending = 0;
+        dmaisr();
+      }
+    }
+  }
+  if((maxlatency < n) && (Lost != 0)){
+    printf("n %u latency %u: %u samples lost\n", n, maxlatency, Lost);
+    Errors = Errors + 1;
+  }
+  if((uint16_t)(Sample - Expect) > maxlatency + 2*n){
+    printf("n %u latency %u: stream stopped after %u blocks\n", n, maxlatency, Blocks);
+    Errors = Errors + 1;
+  }
+  printf("n %3u, latency up to %3u samples: %6u blocks, %6u samples lost, %u errors\n",
+         n, maxlatency, Blocks, Lost, Errors);
+  return Errors;
+}
+
+int main(void){ uint32_t errors = 0;
+  static const uint32_t sizes[3] = {1, 8, MAXN};
+  int i;
+  srand(5);
+  for(i=0; i<3; i=i+1){
+    errors = errors + run(sizes[i], 0);
+    errors = errors + run(sizes[i], sizes[i] - 1);
+    errors = errors + run(sizes[i], 3*sizes[i]);
+  }
+  printf("%u errors\n", errors);
+  return errors != 0;
+}
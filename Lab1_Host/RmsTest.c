@@ -0,0 +1,143 @@
+// RmsTest.c
+// Runs on Linux
+// Test and benchmark of the running RMS in inc/FixedMath.c,
+// compiled unchanged.  RMS_Get() is checked against the exact
+// floor(sqrt(variance)) of each block and of the sliding window,
+// computed from 64-bit sums of the samples, and the block results
+// are compared with the Task0 rescan the labs used before.
+// The rescan subtracted the mean truncated to an integer, which
+// adds (mean - truncated mean)^2 to the variance, so it can be
+// one larger than the exact value just above a perfect square.
+// RMS_Get() is exact; that difference is intended and counted.
+// Build:
+//   gcc -O2 -I../inc -o RmsTest RmsTest.c ../inc/FixedMath.c -lm
+// Usage:
+//   RmsTest
+// The exit status is 1 if RMS_Get() differs from the exact value.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "FixedMath.h"
+
+#define N 1000               // SOUNDRMSLENGTH
+#define BLOCKS 2000
+int16_t Samples[BLOCKS*N];
+int16_t Window[N];
+int16_t Big[65535];          // longest block RMS_Init() allows
+
+static double seconds(void){ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+// floor(sqrt(v)) of a 64-bit number
+static uint64_t isqrt64(uint64_t v){ uint64_t r;
+  r = (uint64_t)sqrt((double)v);
+  while(r*r > v) r = r - 1;
+  while((r+1)*(r+1) <= v) r = r + 1;
+  return r;
+}
+// exact floor of the RMS about the mean of x[0] to x[n-1]
+static uint32_t exact(const int16_t *x, uint32_t n){ uint32_t i;
+  int64_t sum = 0;
+  uint64_t sumsq = 0, v;
+  for(i=0; i<n; i=i+1){
+    sum = sum + x[i];
+    sumsq = sumsq + (int64_t)x[i]*x[i];
+  }
+  v = n*sumsq - (uint64_t)(sum*sum); // n^2 times the variance
+  return isqrt64(v)/n;       // floor(floor(sqrt(v))/n) = floor(sqrt(v)/n)
+}
+// Task0 before running sums: truncated mean, then rescan
+static uint32_t rescan(const int16_t *x){ int32_t sum = 0, avg;
+  int i;
+  for(i=0; i<N; i=i+1){
+    sum = sum + x[i];
+  }
+  avg = sum/N;
+  sum = 0;
+  for(i=0; i<N; i=i+1){
+    sum = sum + (x[i] - avg)*(x[i] - avg);
+  }
+  return sqrt32(sum/N);
+}
+
+int main(void){ rmsType block, slide;
+  uint32_t i, b, errors = 0, changed = 0, larger = 0, r, e;
+  int32_t d, maxd = 0;
+  double start, put, scan;
+  srand(1);
+  for(b=0; b<BLOCKS; b=b+1){  // 10-bit microphone: tone, offset and noise
+    int amp = rand()%500, off = 400 + rand()%200, noise = 1 + rand()%60;
+    for(i=0; i<N; i=i+1){
+      d = off + (int)(amp*sin(i*0.05*(1 + b%7))) + rand()%noise;
+      Samples[b*N + i] = (d < 0) ? 0 : (d > 1023) ? 1023 : d;
+    }
+  }
+  RMS_Init(&block, 0, N);
+  RMS_Init(&slide, Window, N);
+  for(b=0; b<BLOCKS; b=b+1){
+    for(i=0; i<N; i=i+1){
+      r = RMS_Put(&block, Samples[b*N + i]);
+      RMS_Put(&slide, Samples[b*N + i]);
+      if((b > 0) && ((i%97) == 0)){
+        e = exact(&Samples[b*N + i + 1 - N], N);
+        if(RMS_Get(&slide) != e){
+          if(errors < 5) printf("sliding block %u sample %u: %u, should be %u\n", b, i, RMS_Get(&slide), e);
+          errors = errors + 1;
+        }
+      }
+    }
+    e = exact(&Samples[b*N], N);
+    if((r != 1) || (RMS_Get(&block) != e)){
+      if(errors < 5) printf("block %u: %u, should be %u\n", b, RMS_Get(&block), e);
+      errors = errors + 1;
+    }
+    d = (int32_t)rescan(&Samples[b*N]) - (int32_t)e;
+    if(d != 0){
+      changed = changed + 1;
+      larger = larger + (d > 0);
+    }
+    if(abs(d) > maxd) maxd = abs(d);
+  }
+  printf("%u blocks of %u: old rescan differs on %u (%u larger), by at most %d\n",
+         BLOCKS, N, changed, larger, maxd);
+  // full scale, longest block: sums must not overflow
+  for(i=0; i<65535; i=i+1){
+    Big[i] = (i&1) ? 32767 : -32768;
+  }
+  RMS_Init(&block, 0, 65535);
+  for(i=0; i<65535; i=i+1){
+    RMS_Put(&block, Big[i]);
+  }
+  e = exact(Big, 65535);
+  printf("full scale 65535 samples: %u, exact %u\n", RMS_Get(&block), e);
+  errors = errors + (RMS_Get(&block) != e);
+  RMS_Init(&block, 0, N);    // constant input
+  for(i=0; i<N; i=i+1){
+    RMS_Put(&block, 1023);
+  }
+  printf("constant: %u, exact 0\n", RMS_Get(&block));
+  errors = errors + (RMS_Get(&block) != 0);
+  // cost per sample
+  start = seconds();
+  for(b=0; b<BLOCKS; b=b+1){
+    for(i=0; i<N; i=i+1){
+      RMS_Put(&slide, Samples[b*N + i]);
+    }
+  }
+  put = seconds() - start;
+  start = seconds();
+  r = 0;
+  for(b=0; b<BLOCKS; b=b+1){
+    r = r + rescan(&Samples[b*N]);
+  }
+  scan = seconds() - start;
+  printf("RMS_Put sliding %.2f ns/sample, old rescan %.2f ns/sample (%u)\n",
+         1e9*put/(BLOCKS*N), 1e9*scan/(BLOCKS*N), r&1);
+  printf("%u errors\n", errors);
+  return errors != 0;
+}
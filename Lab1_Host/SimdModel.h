@@ -0,0 +1,39 @@
+// SimdModel.h
+// Runs on Linux
+// C models of the CMSIS Cortex-M4 intrinsics used by inc/DSP.c,
+// so its SIMD code path can be tested on the PC.  Force it into
+// DSP.c with
+//   gcc -DDSP_SIMD -include SimdModel.h ...
+// Sums wrap at 32 bits like the instructions (the Q flag is not
+// modelled).
+
+#include <stdint.h>
+
+// x[15:0]*y[15:0] + x[31:16]*y[31:16] + acc
+static inline uint32_t __SMLAD(uint32_t x, uint32_t y, uint32_t acc){
+  return acc + (uint32_t)((int16_t)x*(int16_t)y) +
+               (uint32_t)((int16_t)(x>>16)*(int16_t)(y>>16));
+}
+// x[15:0]*y[31:16] + x[31:16]*y[15:0] + acc
+static inline uint32_t __SMLADX(uint32_t x, uint32_t y, uint32_t acc){
+  return acc + (uint32_t)((int16_t)x*(int16_t)(y>>16)) +
+               (uint32_t)((int16_t)(x>>16)*(int16_t)y);
+}
+// x[15:0]*y[15:0] + x[31:16]*y[31:16] + acc, 64-bit accumulate
+static inline uint64_t __SMLALD(uint32_t x, uint32_t y, uint64_t acc){
+  return acc + (uint64_t)(int64_t)((int16_t)x*(int16_t)y) +
+               (uint64_t)(int64_t)((int16_t)(x>>16)*(int16_t)(y>>16));
+}
+// bottom half of x, top half of y shifted left by n
+#define __PKHBT(x, y, n) ((((uint32_t)(x))&0x0000FFFF)|((((uint32_t)(y))<<(n))&0xFFFF0000))
+// saturate to a signed n-bit number
+static inline int32_t __SSAT(int32_t x, uint32_t n){
+  int32_t max = (1<<(n - 1)) - 1;
+  if(x > max){
+    return max;
+  }
+  if(x < -max - 1){
+    return -max - 1;
+  }
+  return x;
+}
@@ -0,0 +1,78 @@
+// SqrtTest.c
+// Runs on Linux
+// Exhaustive test and benchmark of sqrt32() in inc/FixedMath.c,
+// compiled unchanged.  Every 32-bit input is checked against a
+// reference root that is stepped up at each perfect square, so
+// the reference needs no multiply-overflow care and no floating
+// point.  sqrt32_Newton() is checked the same way over its range,
+// 0 to 3*1023*1023 (the magnitude range of the Lab 1 accelerometer),
+// where its errors are reported but expected.
+// Build:
+//   gcc -O2 -I../inc -o SqrtTest SqrtTest.c ../inc/FixedMath.c
+// Usage:
+//   SqrtTest          all 2^32 inputs, about two minutes
+//   SqrtTest quick    0 to 3*1023*1023 only
+// The exit status is 1 if sqrt32() is wrong for any input.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "FixedMath.h"
+
+#define NEWTONMAX (3*1023*1023)
+
+static double seconds(void){ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+// Check f against the exact floor root for s = 0 to last.
+// Prints the first few errors, returns the number of errors.
+static uint32_t check(const char *name, uint32_t (*f)(uint32_t), uint32_t last){
+  uint32_t s = 0, ref = 0, errors = 0, r;
+  uint64_t next = 1;         // (ref+1)^2, first input with a larger root
+  while(1){
+    if(s == next){
+      ref = ref + 1;
+      next = (uint64_t)(ref+1)*(ref+1);
+    }
+    r = f(s);
+    if(r != ref){
+      if(errors < 5){
+        printf("%s(%u) = %u, should be %u\n", name, s, r, ref);
+      }
+      errors = errors + 1;
+    }
+    if(s == last) break;
+    s = s + 1;
+  }
+  printf("%s: %u errors in 0 to %u\n", name, errors, last);
+  return errors;
+}
+
+// Average time per call over the inputs 0 to last, in ns
+static double bench(uint32_t (*f)(uint32_t), uint32_t last){
+  volatile uint32_t sum = 0;
+  uint32_t s;
+  double start = seconds();
+  for(s=0; s<=last; s=s+1){
+    sum = sum + f(s);
+  }
+  return 1e9*(seconds() - start)/((double)last + 1);
+}
+
+int main(int argc, char **argv){ uint32_t errors;
+  double start;
+  start = seconds();
+  if((argc > 1) && (strcmp(argv[1], "quick") == 0)){
+    errors = check("sqrt32", sqrt32, NEWTONMAX);
+  } else{
+    errors = check("sqrt32", sqrt32, 0xFFFFFFFF);
+  }
+  printf("checked in %.1f s\n", seconds() - start);
+  check("sqrt32_Newton", sqrt32_Newton, NEWTONMAX); // known to be off by one
+  printf("0 to %u: sqrt32 %.1f ns/call, sqrt32_Newton %.1f ns/call\n", NEWTONMAX,
+         bench(sqrt32, NEWTONMAX), bench(sqrt32_Newton, NEWTONMAX));
+  return errors != 0;
+}
@@ -92,9 +92,10 @@
 #include "../inc/BSP.h"
 #include "../inc/CortexM.h"
 #include "../inc/Profile.h"
+#include "../inc/FixedMath.h"
+#include "../inc/DSP.h"
 //#include "Texas.h"
 
-uint32_t sqrt32(uint32_t s);
 
 //---------------- Global variables shared between tasks ----------------
 uint32_t Time;              // elapsed time in seconds
@@ -126,9 +127,15 @@ enum plotstate PlotState = Accelerometer;
 //------------ end of Global variables shared between tasks -------------
 
 //---------------- Task0 samples sound from microphone ----------------
-//#define SOUNDRMSLENGTH 10  // number of samples to collect before calculating RMS (may overflow if greater than 4104)
-#define SOUNDRMSLENGTH 1000  // number of samples to collect before calculating RMS (may overflow if greater than 4104)
+#define SOUNDRMSLENGTH 1000 // number of samples in each RMS block or sliding window
+#define SOUNDSLIDING 0      // 1 for RMS of the most recent SOUNDRMSLENGTH samples, 0 for one RMS per block
+#if SOUNDSLIDING
 int16_t SoundArray[SOUNDRMSLENGTH];
+#define SOUNDWINDOW SoundArray
+#else
+#define SOUNDWINDOW 0       // block mode needs no sample array
+#endif
+rmsType SoundStats;         // running sums for SoundRMS
 // *********Task0_Init*********
 // initialises microphone
 // Task0 measures sound intensity
@@ -137,6 +144,7 @@ int16_t SoundArray[SOUNDRMSLENGTH];
 void Task0_Init(void)
 {
   BSP_Microphone_Init();
+  RMS_Init(&SoundStats, SOUNDWINDOW, SOUNDRMSLENGTH);
   SoundRMS = 0;
 }
 
@@ -146,27 +154,16 @@ void Task0_Init(void)
 // Outputs: none
 void Task0(void)
 {
-  static int32_t soundSum = 0;
   static int time = 0;  // units of microphone sampling rate
-  int32_t soundAvg;
-  int i;
   //TExaS_Task0();     // record system time in array, toggle virtual logic analyzer
   //Profile_Toggle0(); // viewed by the logic analyzer to know Task0 started
   BSP_Microphone_Input(&SoundData);
-  soundSum = soundSum + (int32_t)SoundData;
-  SoundArray[time] = SoundData;
+  RMS_Put(&SoundStats, SoundData);
   time = time + 1;
   if(time == SOUNDRMSLENGTH)
   {
     time = 0;
-    soundAvg = soundSum/SOUNDRMSLENGTH;
-    soundSum = 0;
-    for(i=0; i<SOUNDRMSLENGTH; i=i+1)
-    {
-      soundSum = soundSum + (SoundArray[i] - soundAvg)*(SoundArray[i] - soundAvg);
-    }
-    SoundRMS = sqrt32(soundSum/SOUNDRMSLENGTH);
-    soundSum = 0;
+    SoundRMS = RMS_Get(&SoundStats);
   }
 }
 /* ****************************************** */
@@ -536,17 +533,169 @@ int main(void)
   }
 }
 
-// Newton's method
-// s is an integer
-// sqrt(s) is an integer
-uint32_t sqrt32(uint32_t s)
-{
-  uint32_t t;          // t*t will become s
-  int n;               // loop counter
-  t = s/16+1;          // initial guess
-  for(n = 16; n; --n)  // will finish
-  {
-    t = ((t*t+s)/t)/2;
+// Alternate main program to check and time sqrt32
+// Every magnitude squared the accelerometer can produce,
+// 0 to 3*1023*1023, is checked against floor(sqrt(s)), then
+// both square roots are timed in SysTick cycles on a few
+// inputs.  Run with the debugger and look at the variables,
+// or read the LCD: errors then max cycles, new then Newton.
+// Lab1_Host/SqrtTest.c checks all 2^32 inputs on the PC.
+#define SQRTCHECKMAX (3*1023*1023)
+uint32_t SqrtErrors, NewtonErrors;       // inputs with a wrong result
+uint32_t SqrtCycles, NewtonCycles;       // worst case cycles per call
+uint32_t static cycles(uint32_t (*root)(uint32_t), uint32_t s){
+  uint32_t before = STCURRENT;
+  root(s);
+  return (before - STCURRENT)&0x00FFFFFF;
+}
+int main_sqrt(void){ uint32_t s, r, i, c;
+  static const uint32_t inputs[6] = {0, 1, 1023*1023, 230400, 2000000, SQRTCHECKMAX};
+  DisableInterrupts();
+  BSP_Clock_InitFastest();
+  BSP_LCD_Init();
+  BSP_LCD_FillScreen(BSP_LCD_Color565(0, 0, 0));
+  BSP_LCD_DrawString(0, 0, "Checking sqrt32...", TOPTXTCOLOR);
+  SqrtErrors = NewtonErrors = 0;
+  for(s=0; s<=SQRTCHECKMAX; s=s+1){
+    r = sqrt32(s);
+    if((r*r > s) || ((r+1)*(r+1) <= s)){
+      SqrtErrors = SqrtErrors + 1;
+    }
+    r = sqrt32_Newton(s);
+    if((r*r > s) || ((r+1)*(r+1) <= s)){
+      NewtonErrors = NewtonErrors + 1;
+    }
+  }
+  STCTRL = 0;                   // disable SysTick during setup
+  STRELOAD = 0x00FFFFFF;        // maximum reload value
+  STCURRENT = 0;                // any write to current clears it
+  STCTRL = 0x00000005;          // enable SysTick with core clock
+  SqrtCycles = NewtonCycles = 0;
+  for(i=0; i<6; i=i+1){
+    c = cycles(&sqrt32, inputs[i]);
+    if(c > SqrtCycles){
+      SqrtCycles = c;
+    }
+    c = cycles(&sqrt32_Newton, inputs[i]);
+    if(c > NewtonCycles){
+      NewtonCycles = c;
+    }
+  }
+  BSP_LCD_DrawString(0, 0, "sqrt32 errors/cycles", TOPTXTCOLOR);
+  BSP_LCD_SetCursor(0, 1); BSP_LCD_OutUDec(SqrtErrors, TOPNUMCOLOR);
+  BSP_LCD_SetCursor(8, 1); BSP_LCD_OutUDec(SqrtCycles, TOPNUMCOLOR);
+  BSP_LCD_SetCursor(0, 2); BSP_LCD_OutUDec(NewtonErrors, MAGCOLOR);
+  BSP_LCD_SetCursor(8, 2); BSP_LCD_OutUDec(NewtonCycles, MAGCOLOR);
+  while(1){};
+}
+
+// Alternate main program to stream the microphone at 8 kHz
+// Timer A3, the ADC and the DMA collect the samples, so the
+// processor only runs once per STREAMN samples.  Shows the
+// sound RMS each second and the number of blocks received.
+#define STREAMN 256
+uint16_t StreamBuf0[STREAMN], StreamBuf1[STREAMN];
+uint32_t StreamBlocks;
+void static streamtask(uint16_t *buf, uint32_t n){ uint32_t i;
+  for(i=0; i<n; i=i+1){
+    RMS_Put(&SoundStats, buf[i]>>4);   // same 10-bit scale as Task0
+  }
+  StreamBlocks = StreamBlocks + 1;
+}
+int main_stream(void){ long sr;
+  DisableInterrupts();
+  BSP_Clock_InitFastest();
+  BSP_LCD_Init();
+  BSP_LCD_FillScreen(BSP_LCD_Color565(0, 0, 0));
+  BSP_LCD_DrawString(0, 0, "Sound=", TOPTXTCOLOR);
+  BSP_LCD_DrawString(0, 1, "Blocks=", TOPTXTCOLOR);
+  RMS_Init(&SoundStats, 0, 8000);      // one result per second
+  StreamBlocks = 0;
+  BSP_Microphone_StartStream(StreamBuf0, StreamBuf1, STREAMN, 8000, &streamtask, 2);
+  EnableInterrupts();
+  while(1){
+    BSP_Delay1ms(1000);
+    sr = StartCritical();
+    SoundRMS = RMS_Get(&SoundStats);
+    EndCritical(sr);
+    BSP_LCD_SetCursor(7, 0); BSP_LCD_OutUDec4(SoundRMS, SOUNDCOLOR);
+    BSP_LCD_SetCursor(7, 1); BSP_LCD_OutUDec(StreamBlocks, TOPNUMCOLOR);
+  }
+}
+
+// Alternate main program to time the DSP kernels
+// Cycles per sample on a 256-sample block, measured with
+// SysTick, for the scalar C loops used by the tasks and for
+// the DSP.c kernels.  Run with the debugger and look at
+// DSPCycles[], or read the LCD.
+// The unions keep the sample arrays 32-bit aligned.
+#define DSPN 256
+union{ int16_t S[DSPN]; int32_t Align; } DSPx, DSPy, DSPout;
+union{ int16_t S[16+DSPN]; int32_t Align; } DSPState;
+const union{ int16_t S[16]; int32_t Align; } DSPCoef = {{ // 16-tap low pass, reversed (symmetric)
+  -120, -210, -180, 150, 900, 2050, 3300, 4150,
+  4150, 3300, 2050, 900, 150, -180, -210, -120}};
+uint32_t DSPCycles[7];         // times 16, so 1/16 cycle resolution
+int main_dsp(void){ uint32_t before, i;
+  uint64_t sumsq;
+  int32_t sum;
+  firType fir;
+  biquadType biquad;
+  DisableInterrupts();
+  BSP_Clock_InitFastest();
+  BSP_LCD_Init();
+  BSP_LCD_FillScreen(BSP_LCD_Color565(0, 0, 0));
+  for(i=0; i<DSPN; i=i+1){
+    DSPx.S[i] = (i*97)%2048 - 1024;
+    DSPy.S[i] = (i*31)%512 - 256;
+  }
+  DSP_FIR_Init(&fir, DSPCoef.S, DSPState.S, 16, DSPN);
+  DSP_Biquad_Init(&biquad, 1024, 2048, 1024, -24000, 9000);
+  STCTRL = 0;                   // disable SysTick during setup
+  STRELOAD = 0x00FFFFFF;        // maximum reload value
+  STCURRENT = 0;                // any write to current clears it
+  STCTRL = 0x00000005;          // enable SysTick with core clock
+  before = STCURRENT;           // 0) scalar sum of squares
+  sumsq = 0;
+  for(i=0; i<DSPN; i=i+1){
+    sumsq = sumsq + DSPx.S[i]*DSPx.S[i];
+  }
+  DSPCycles[0] = ((before - STCURRENT)&0x00FFFFFF)*16/DSPN;
+  before = STCURRENT;           // 1) DSP_SumSquares
+  sumsq = sumsq - DSP_SumSquares(DSPx.S, DSPN);
+  DSPCycles[1] = ((before - STCURRENT)&0x00FFFFFF)*16/DSPN;
+  before = STCURRENT;           // 2) scalar dot product
+  sum = 0;
+  for(i=0; i<DSPN; i=i+1){
+    sum = sum + DSPx.S[i]*DSPy.S[i];
+  }
+  DSPCycles[2] = ((before - STCURRENT)&0x00FFFFFF)*16/DSPN;
+  before = STCURRENT;           // 3) DSP_Dot
+  sum = sum - DSP_Dot(DSPx.S, DSPy.S, DSPN);
+  DSPCycles[3] = ((before - STCURRENT)&0x00FFFFFF)*16/DSPN;
+  before = STCURRENT;           // 4) 16-tap FIR
+  DSP_FIR(&fir, DSPx.S, DSPout.S, DSPN);
+  DSPCycles[4] = ((before - STCURRENT)&0x00FFFFFF)*16/DSPN;
+  before = STCURRENT;           // 5) biquad
+  DSP_Biquad(&biquad, DSPx.S, DSPout.S, DSPN);
+  DSPCycles[5] = ((before - STCURRENT)&0x00FFFFFF)*16/DSPN;
+  before = STCURRENT;           // 6) decimate by 8
+  DSP_Decimate(DSPx.S, DSPout.S, DSPN, 8);
+  DSPCycles[6] = ((before - STCURRENT)&0x00FFFFFF)*16/DSPN;
+  BSP_LCD_DrawString(0, 0, "cycles/sample*16", TOPTXTCOLOR);
+  BSP_LCD_DrawString(0, 1, "sumsq C", TOPTXTCOLOR);
+  BSP_LCD_DrawString(0, 2, "sumsq DSP", TOPTXTCOLOR);
+  BSP_LCD_DrawString(0, 3, "dot C", TOPTXTCOLOR);
+  BSP_LCD_DrawString(0, 4, "dot DSP", TOPTXTCOLOR);
+  BSP_LCD_DrawString(0, 5, "FIR 16", TOPTXTCOLOR);
+  BSP_LCD_DrawString(0, 6, "biquad", TOPTXTCOLOR);
+  BSP_LCD_DrawString(0, 7, "decimate 8", TOPTXTCOLOR);
+  for(i=0; i<7; i=i+1){
+    BSP_LCD_SetCursor(12, i+1); BSP_LCD_OutUDec4(DSPCycles[i], TOPNUMCOLOR);
   }
-  return t;
+  BSP_LCD_SetCursor(0, 9);      // 0 0 if the kernels match the C loops
+  BSP_LCD_OutUDec((uint32_t)sumsq, MAGCOLOR);
+  BSP_LCD_SetCursor(6, 9);
+  BSP_LCD_OutUDec((uint32_t)sum, MAGCOLOR);
+  while(1){};
 }
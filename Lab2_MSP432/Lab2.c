@@ -39,8 +39,8 @@
 // #include "Texas.h"
 #include "../inc/CortexM.h"
 #include "os.h"
+#include "../inc/FixedMath.h"
 
-uint32_t sqrt32(uint32_t s);
 #define THREADFREQ 1000  // frequency in Hz of round robin scheduler
 
 //---------------- Global variables shared between tasks ----------------
@@ -50,7 +50,7 @@ uint32_t Magnitude;         // will not overflow (3*1,023^2 = 3,139,587)
                             // Exponentially Weighted Moving Average
 uint32_t EWMA;              // https://en.wikipedia.org/wiki/Moving_average#Exponential_moving_average
 uint16_t SoundData;         // raw data sampled from the microphone
-int32_t SoundAvg;
+uint32_t SoundRMS;          // Root Mean Square average of most recent sound samples
 
 uint32_t LightData;
 int32_t TemperatureData;    // 0.1C
@@ -79,8 +79,15 @@ enum plotstate PlotState = Accelerometer;
 
 //---------------- Task0 samples sound from microphone ----------------
 // Event thread run by OS in real time at 1000 Hz
-#define SOUNDRMSLENGTH 1000 // number of samples to collect before calculating RMS (may overflow if greater than 4104)
+#define SOUNDRMSLENGTH 1000 // number of samples in each RMS block or sliding window
+#define SOUNDSLIDING 0      // 1 for RMS of the most recent SOUNDRMSLENGTH samples, 0 for one RMS per block
+#if SOUNDSLIDING
 int16_t SoundArray[SOUNDRMSLENGTH];
+#define SOUNDWINDOW SoundArray
+#else
+#define SOUNDWINDOW 0       // block mode needs no sample array
+#endif
+rmsType SoundStats;         // running sums for SoundRMS
 // *********Task0_Init*********
 // initialises microphone
 // Task0 measures sound intensity
@@ -89,6 +96,8 @@ int16_t SoundArray[SOUNDRMSLENGTH];
 void Task0_Init(void)
 {
   BSP_Microphone_Init();
+  RMS_Init(&SoundStats, SOUNDWINDOW, SOUNDRMSLENGTH);
+  SoundRMS = 0;
 }
 
 // *********Task0*********
@@ -99,20 +108,17 @@ void Task0_Init(void)
 void Task0(void)
 {
   long sr;
-  static int32_t soundSum = 0;
   static int time = 0;  // units of microphone sampling rate
   //TExaS_Task0();      // record system time in array, toggle virtual logic analyser
   Profile_Toggle0();  // viewed by a real logic analyser to know Task0 started
   sr = StartCritical(); // on MSP432, the ADC input is a critical section
   BSP_Microphone_Input(&SoundData);
   EndCritical(sr);
-  soundSum = soundSum + (int32_t)SoundData;
-  SoundArray[time] = SoundData;
+  RMS_Put(&SoundStats, SoundData);
   time = time + 1;
   if(time == SOUNDRMSLENGTH)
   {
-    SoundAvg = soundSum/SOUNDRMSLENGTH;
-    soundSum = 0;
+    SoundRMS = RMS_Get(&SoundStats);
     OS_Signal(&NewData);  // makes task5 run every 1 sec
     time = 0;
   }
@@ -418,8 +424,7 @@ void Task4(void){int32_t voltData,tempData;
 // updates the text at the top of the LCD
 // Inputs:  none
 // Outputs: none
-void Task5(void){int32_t soundSum;
-  uint32_t soundRMS;        // Root Mean Square average of most recent sound samples
+void Task5(void){
   OS_Wait(&LCDmutex);
   BSP_LCD_DrawString(0, 0,  "Time=",  TOPTXTCOLOR);
   BSP_LCD_DrawString(0, 1,  "Step=",  TOPTXTCOLOR);
@@ -431,17 +436,11 @@ void Task5(void){int32_t soundSum;
     OS_Wait(&NewData);
     // TExaS_Task5();     // records system time in array, toggles virtual logic analyser
     // Profile_Toggle5(); // viewed by a real logic analyser to know Task5 started
-    soundSum = 0;
-    for(int i=0; i<SOUNDRMSLENGTH; i=i+1)
-    {
-      soundSum = soundSum + (SoundArray[i] - SoundAvg)*(SoundArray[i] - SoundAvg);
-    }
-    soundRMS = sqrt32(soundSum/SOUNDRMSLENGTH);
     OS_Wait(&LCDmutex);
     BSP_LCD_SetCursor(5,  0); BSP_LCD_OutUDec4(Time/10, TOPNUMCOLOR);
     BSP_LCD_SetCursor(5,  1); BSP_LCD_OutUDec4(Steps, MAGCOLOR);
     BSP_LCD_SetCursor(16, 0); BSP_LCD_OutUFix2_1(TemperatureData, TEMPCOLOR);
-    BSP_LCD_SetCursor(16, 1); BSP_LCD_OutUDec4(soundRMS, SOUNDCOLOR);
+    BSP_LCD_SetCursor(16, 1); BSP_LCD_OutUDec4(SoundRMS, SOUNDCOLOR);
     OS_Signal(&LCDmutex);
   }
 }
@@ -586,18 +585,3 @@ int main_step5(void){
   OS_Launch(BSP_Clock_GetFreq()/THREADFREQ);  // doesn't return, interrupts enabled in here
   return 0;  // this never executes
 }
-
-// Newton's method
-// s is an integer
-// sqrt(s) is an integer
-uint32_t sqrt32(uint32_t s)
-{
-  uint32_t t;          // t*t will become s
-  int n;               // loop counter
-  t = s/16+1;          // initial guess
-  for(n = 16; n; --n)  // will finish
-  {
-    t = ((t*t+s)/t)/2;
-  }
-  return t;
-}
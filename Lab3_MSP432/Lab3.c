@@ -38,9 +38,9 @@
 #include "../inc/Profile.h"
 #include "../inc/CortexM.h"
 #include "os.h"
+#include "../inc/FixedMath.h"
 // #include "Texas.h"
 
-uint32_t sqrt32(uint32_t s);
 #define THREADFREQ 1000   // frequency in Hz of round robin scheduler
 
 //---------------- Global variables shared between tasks ----------------
@@ -50,8 +50,6 @@ uint32_t Magnitude;         // will not overflow (3*1,023^2 = 3,139,587)
                             // Exponentially Weighted Moving Average
 uint32_t EWMA;              // https://en.wikipedia.org/wiki/Moving_average#Exponential_moving_average
 uint16_t SoundData;         // raw data sampled from the microphone
-int32_t SoundAvg;
-
 uint32_t SoundRMS;          // Root Mean Square average of most recent sound samples
 uint32_t LightData;         // 100 lux
 int32_t TemperatureData;    // 0.1C
@@ -82,8 +80,15 @@ enum plotstate PlotState = Accelerometer;
 
 //---------------- Task0 samples sound from microphone ----------------
 // Event thread run by OS in real time at 1000 Hz
-#define SOUNDRMSLENGTH 1000 // number of samples to collect before calculating RMS (may overflow if greater than 4104)
+#define SOUNDRMSLENGTH 1000 // number of samples in each RMS block or sliding window
+#define SOUNDSLIDING 0      // 1 for RMS of the most recent SOUNDRMSLENGTH samples, 0 for one RMS per block
+#if SOUNDSLIDING
 int16_t SoundArray[SOUNDRMSLENGTH];
+#define SOUNDWINDOW SoundArray
+#else
+#define SOUNDWINDOW 0       // block mode needs no sample array
+#endif
+rmsType SoundStats;         // running sums for SoundRMS
 // *********Task0_Init*********
 // initializes microphone
 // Task0 measures sound intensity
@@ -91,6 +96,7 @@ int16_t SoundArray[SOUNDRMSLENGTH];
 // Outputs: none
 void Task0_Init(void){
   BSP_Microphone_Init();
+  RMS_Init(&SoundStats, SOUNDWINDOW, SOUNDRMSLENGTH);
   SoundRMS = 0;
 }
 // *********Task0*********
@@ -100,18 +106,15 @@ void Task0_Init(void){
 // Outputs: none
 void Task0(void)
 {
-  static int32_t soundSum = 0;
   static int time = 0;  // units of microphone sampling rate
   //TExaS_Task0();  // record system time in array, toggle virtual logic analyzer
   Profile_Toggle0();  // viewed by a real logic analyzer to know Task0 started
   BSP_Microphone_Input(&SoundData);
-  soundSum = soundSum + (int32_t)SoundData;
-  SoundArray[time] = SoundData;
+  RMS_Put(&SoundStats, SoundData);
   time = time + 1;
   if(time == SOUNDRMSLENGTH)
   {
-    SoundAvg = soundSum/SOUNDRMSLENGTH;
-    soundSum = 0;
+    SoundRMS = RMS_Get(&SoundStats);
     OS_Signal(&NewData); // makes task5 run every 1 sec
     time = 0;
   }
@@ -449,7 +452,6 @@ void Task4(void)
 // Outputs: none
 void Task5(void)
 {
-  int32_t soundSum;
   OS_Wait(&LCDmutex);
   BSP_LCD_DrawString(0,  0, "Temp=",  TOPTXTCOLOR);
   BSP_LCD_DrawString(0,  1, "Step=",  TOPTXTCOLOR);
@@ -461,12 +463,6 @@ void Task5(void)
     OS_Wait(&NewData);
     // TExaS_Task5();     // records system time in array, toggles virtual logic analyzer
     Profile_Toggle5(); // viewed by a real logic analyzer to know Task5 started
-    soundSum = 0;
-    for(int i=0; i<SOUNDRMSLENGTH; i=i+1)
-    {
-      soundSum = soundSum + (SoundArray[i] - SoundAvg)*(SoundArray[i] - SoundAvg);
-    }
-    SoundRMS = sqrt32(soundSum/SOUNDRMSLENGTH);
     OS_Wait(&LCDmutex);
     BSP_LCD_SetCursor(5,  0); BSP_LCD_OutUFix2_1(TemperatureData, TEMPCOLOR);
     BSP_LCD_SetCursor(5,  1); BSP_LCD_OutUDec4(Steps,             MAGCOLOR);
@@ -1414,18 +1410,3 @@ int main(void){
 /* ****************************************** */
 /*          End of Step 6 Section             */
 /* ****************************************** */
-
-// Newton's method
-// s is an integer
-// sqrt(s) is an integer
-uint32_t sqrt32(uint32_t s)
-{
-  uint32_t t;          // t*t will become s
-  int n;               // loop counter
-  t = s/16+1;          // initial guess
-  for(n = 16; n; --n)  // will finish
-  {
-    t = ((t*t+s)/t)/2;
-  }
-  return t;
-}
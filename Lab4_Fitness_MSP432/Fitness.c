@@ -0,0 +1,264 @@
+// Fitness.c
+// Step counting pipeline for Lab 4
+// Runs on MSP432 or a host computer
+// Daniel and Jonathan Valvano
+// September 13, 2016
+
+#include <stdint.h>
+#include "Pipeline.h"
+#include "Fitness.h"
+#include "FixedMath.h"
+
+#if FITNESSMAXBLOCK > PIPEFIFOSIZE
+#error "a whole block must fit in the first stage FIFO"
+#endif
+
+pipelineType FitnessPipe;
+pipeStageType FitnessMag, FitnessStep, FitnessSteps, FitnessPlot, FitnessDecimate;
+fitnessStepType FitnessStepState;
+fitnessBlockType FitnessBlockState;
+pipeDecimateType FitnessPlotRate;
+
+//******Fitness_Step************
+// Pipeline stage for the four-state step detector
+// state is a fitnessStepType, in is a magnitude
+// Outputs: 1 with *out = total steps when a step is detected,
+//          0 otherwise; the magnitude and its average are in
+//          state->Average.Value and the input to the plot sink
+uint32_t Fitness_Step(void *state, int32_t in, int32_t *out){
+  fitnessStepType *f = state;
+  uint32_t magnitude = in;
+  int32_t ewma;
+  uint32_t step = 0;
+  Pipe_EWMA(&f->Average, in, &ewma);
+  if(f->State == LookingForMax){
+    if(magnitude > f->LocalMax){
+      f->LocalMax = magnitude;
+      f->LocalCount = 0;
+    } else{
+      f->LocalCount = f->LocalCount + 1;
+      if(f->LocalCount >= LOCALCOUNTTARGET){
+        f->State = LookingForCross1;
+      }
+    }
+  } else if(f->State == LookingForCross1){
+    if(magnitude > f->LocalMax){
+    // somehow measured a very large magnitude
+      f->LocalMax = magnitude;
+      f->LocalCount = 0;
+      f->State = LookingForMax;
+    } else if(in < (ewma - AVGOVERSHOOT)){
+      // step detected
+      step = 1;
+      f->LocalMin = 1024;
+      f->LocalCount = 0;
+      f->State = LookingForMin;
+    }
+  } else if(f->State == LookingForMin){
+    if(magnitude < f->LocalMin){
+      f->LocalMin = magnitude;
+      f->LocalCount = 0;
+    } else{
+      f->LocalCount = f->LocalCount + 1;
+      if(f->LocalCount >= LOCALCOUNTTARGET){
+        f->State = LookingForCross2;
+      }
+    }
+  } else if(f->State == LookingForCross2){
+    if(magnitude < f->LocalMin){
+    // somehow measured a very small magnitude
+      f->LocalMin = magnitude;
+      f->LocalCount = 0;
+      f->State = LookingForMin;
+    } else if(in > (ewma + AVGOVERSHOOT)){
+      // step detected
+      step = 1;
+      f->LocalMax = 0;
+      f->LocalCount = 0;
+      f->State = LookingForMax;
+    }
+  }
+  if(step){
+    f->Steps = f->Steps + 1;
+    *out = f->Steps;
+  }
+  return step;
+}
+
+//******Fitness_Init************
+// Build the step counting pipeline
+// Inputs: clock, increasing time for stage counters, or 0
+//         steps, sink called with the step count after each step
+//         plot, sink called with each magnitude; the average is
+//           FitnessStepState.Average.Value
+// Outputs: none
+// Samples go in with Pipe_Put(&FitnessMag, x*x+y*y+z*z)
+// and move with Pipe_Run(&FitnessPipe).
+void Fitness_Init(uint32_t (*clock)(void), pipeFnType steps, pipeFnType plot){
+  FitnessStepState.Average.Alpha = FITNESSALPHA;
+  FitnessStepState.Average.Started = 0; // first magnitude is the first average
+  FitnessStepState.State = LookingForMax;
+  FitnessStepState.LocalMin = 1024;
+  FitnessStepState.LocalMax = 0;
+  FitnessStepState.LocalCount = 0;
+  FitnessStepState.Steps = 0;
+  Pipe_Init(&FitnessPipe, clock);
+  // add in order from source to sink, so one run moves a sample all the way
+  Pipe_AddStage(&FitnessPipe, &FitnessMag, "mag", &Pipe_Sqrt, 0);
+  Pipe_AddStage(&FitnessPipe, &FitnessStep, "step", &Fitness_Step, &FitnessStepState);
+  Pipe_AddStage(&FitnessPipe, &FitnessSteps, "steps", steps, 0);
+  Pipe_AddStage(&FitnessPipe, &FitnessPlot, "plot", plot, 0);
+  Pipe_Connect(&FitnessMag, &FitnessStep);
+  Pipe_Connect(&FitnessMag, &FitnessPlot);
+  Pipe_Connect(&FitnessStep, &FitnessSteps);
+}
+
+// floor(log2(n)), 0 for n of 0 or 1
+uint32_t static log2n(uint32_t n){ uint32_t k = 0;
+  while((2u<<k) <= n){
+    k = k + 1;
+  }
+  return k;
+}
+
+//******Fitness_StepBlockInit************
+// Start the adaptive step detector
+// Inputs: f, pointer to the state
+//         rate, accelerometer samples per second, 10 to 200
+// Outputs: none
+void Fitness_StepBlockInit(fitnessAdaptType *f, uint32_t rate){
+  f->Rate = rate;
+  f->SmoothShift = log2n(rate/20);     // 0 at 10 Hz, 2 at 100 Hz
+  f->AverageShift = log2n(rate);       // 3 at 10 Hz, same as FITNESSALPHA
+  f->PeakShift = log2n(2*rate);
+  f->Phase = 1;                        // first step is a swing below, like LookingForMax
+  f->Time = 0;
+  f->LastStep = 0;
+  f->Interval = rate/2;                // start by guessing two steps per second
+  f->Peak = 0;
+  f->Steps = 0;
+  f->Smooth = -1;                      // first sample starts the averages
+}
+
+//******Fitness_StepBlock************
+// Count steps in a block of samples
+// Inputs: f, pointer to the state
+//         squared, x*x+y*y+z*z of each accelerometer sample
+//         n, number of samples
+// Outputs: steps found in this block; the total is f->Steps
+uint32_t Fitness_StepBlock(fitnessAdaptType *f, const uint32_t *squared, uint32_t n){
+  // keep the state in registers for the whole block
+  int32_t smooth = f->Smooth, average = f->Average, peak = f->Peak;
+  int32_t phase = f->Phase, d, a, threshold;
+  uint32_t time = f->Time, gap, refractory, steps = 0, i;
+  uint32_t ks = f->SmoothShift, ka = f->AverageShift, kp = f->PeakShift;
+  if((smooth < 0) && n){
+    smooth = average = sqrt32(squared[0])<<8;
+  }
+  refractory = f->Interval/2;
+  if(refractory < f->Rate/5){
+    refractory = f->Rate/5;            // no more than 5 steps per second
+  }
+  for(i=0; i<n; i=i+1){
+    smooth = smooth + (((int32_t)(sqrt32(squared[i])<<8) - smooth)>>ks);
+    average = average + ((smooth - average)>>ka);
+    d = smooth - average;
+    a = (d < 0) ? -d : d;
+    if(a > peak){
+      peak = a;
+    } else{
+      peak = peak - (peak>>kp);
+    }
+    threshold = peak>>1;
+    if(threshold < (FITNESSMINSWING<<8)){
+      threshold = FITNESSMINSWING<<8;
+    }
+    time = time + 1;
+    if(((phase > 0) && (d < -threshold)) || ((phase < 0) && (d > threshold))){
+      gap = time - f->LastStep;
+      if(gap >= refractory){
+        // step detected
+        phase = (d > 0) ? 1 : -1;
+        steps = steps + 1;
+        if(gap <= 2*f->Rate){          // still walking, follow the cadence
+          f->Interval = (3*f->Interval + gap)/4;
+          refractory = f->Interval/2;
+          if(refractory < f->Rate/5){
+            refractory = f->Rate/5;
+          }
+        }
+        f->LastStep = time;
+      }
+    }
+  }
+  f->Smooth = smooth;
+  f->Average = average;
+  f->Peak = peak;
+  f->Phase = phase;
+  f->Time = time;
+  f->Steps = f->Steps + steps;
+  return steps;
+}
+
+//******Fitness_StepAdapt************
+// Pipeline stage for the adaptive step detector
+// state is a fitnessBlockType, in is x*x+y*y+z*z
+// Outputs: 1 with *out = total steps when a block finishes
+//          with new steps, 0 otherwise
+uint32_t Fitness_StepAdapt(void *state, int32_t in, int32_t *out){
+  fitnessBlockType *f = state;
+  f->Block[f->Count] = in;
+  f->Count = f->Count + 1;
+  if(f->Count < f->Size){
+    return 0;
+  }
+  f->Count = 0;
+  if(Fitness_StepBlock(&f->Adapt, f->Block, f->Size) == 0){
+    return 0;
+  }
+  *out = f->Adapt.Steps;
+  return 1;
+}
+
+//******Fitness_BlockInit************
+// Build the step counting pipeline with the adaptive detector
+// Inputs: clock, increasing time for stage counters, or 0
+//         rate, accelerometer samples per second, 10 to 200
+//         steps, sink called with the step count after a block
+//           with steps
+//         plot, sink called with the average magnitude of each
+//           100 ms; the detector's slow average, in 1/256
+//           units, is FitnessBlockState.Adapt.Average
+// Outputs: none
+// Samples go in with Fitness_BlockPut() and move with
+// Pipe_Run(&FitnessPipe), at least once every 100 ms.
+void Fitness_BlockInit(uint32_t (*clock)(void), uint32_t rate,
+                       pipeFnType steps, pipeFnType plot){
+  Fitness_StepBlockInit(&FitnessBlockState.Adapt, rate);
+  FitnessBlockState.Size = rate/10;
+  FitnessBlockState.Count = 0;
+  FitnessPlotRate.Factor = rate/10;
+  FitnessPlotRate.Count = 0;
+  FitnessPlotRate.Sum = 0;
+  Pipe_Init(&FitnessPipe, clock);
+  Pipe_AddStage(&FitnessPipe, &FitnessStep, "step", &Fitness_StepAdapt, &FitnessBlockState);
+  Pipe_AddStage(&FitnessPipe, &FitnessSteps, "steps", steps, 0);
+  Pipe_AddStage(&FitnessPipe, &FitnessMag, "mag", &Pipe_Sqrt, 0);
+  Pipe_AddStage(&FitnessPipe, &FitnessDecimate, "dec", &Pipe_Decimate, &FitnessPlotRate);
+  Pipe_AddStage(&FitnessPipe, &FitnessPlot, "plot", plot, 0);
+  Pipe_Connect(&FitnessStep, &FitnessSteps);
+  Pipe_Connect(&FitnessMag, &FitnessDecimate);
+  Pipe_Connect(&FitnessDecimate, &FitnessPlot);
+}
+
+//******Fitness_BlockPut************
+// Give one sample to the pipeline built by Fitness_BlockInit()
+// Inputs: squared, x*x+y*y+z*z
+// Outputs: 0 if success, -1 if a FIFO was full
+int Fitness_BlockPut(uint32_t squared){ int result;
+  result = Pipe_Put(&FitnessStep, squared);
+  if(Pipe_Put(&FitnessMag, squared) == -1){
+    result = -1;
+  }
+  return result;
+}
@@ -0,0 +1,142 @@
+// Fitness.h
+// Step counting pipeline for Lab 4
+// Acceleration magnitude squared goes in, step counts and
+// plot points come out.  The graph is
+//   FitnessMag (square root) --> FitnessStep (step detector) --> steps sink
+//                            \-> plot sink
+// Sinks are supplied by the caller, so Lab4.c draws on the
+// LCD and the host replay tool prints.
+// Fitness_StepBlock() is a second detector that works on a
+// block of samples at a time and adapts to the sample rate,
+// the size of the swing and the cadence.  Fitness_BlockInit()
+// builds the pipeline around it, for sampling faster than 10 Hz:
+//   FitnessStep (blocks of 100 ms, Fitness_StepBlock) --> steps sink
+//   FitnessMag (square root) --> FitnessDecimate (to 10 Hz) --> plot sink
+// Runs on MSP432 or a host computer
+// Daniel and Jonathan Valvano
+// September 13, 2016
+
+#define FITNESSALPHA 128    // The degree of weighting decrease, a constant smoothing factor between 0 and 1,023. A higher ALPHA discounts older observations faster.
+                            // basic step counting algorithm is based on a forum post from
+                            // http://stackoverflow.com/questions/16392142/android-accelerometer-profiling/16539643#16539643
+#define LOCALCOUNTTARGET 5  // The number of valid measured magnitudes needed to confirm a local min or local max.  Increase this number for longer strides or more frequent measurements.
+#define AVGOVERSHOOT 25     // The amount above or below average a measurement must be to count as "crossing" the average.  Increase this number to reject increasingly hard shaking as steps.
+
+enum stepstate{             // the step counting algorithm cycles through four states
+  LookingForMax,            // looking for a local maximum in current magnitude
+  LookingForCross1,         // looking for current magnitude to cross average magnitude, minus a constant
+  LookingForMin,            // looking for a local minimum in current magnitude
+  LookingForCross2          // looking for current magnitude to cross average magnitude, plus a constant
+};
+struct fitnessstep{
+  pipeEWMAType Average;     // Exponentially Weighted Moving Average of magnitude
+  enum stepstate State;
+  uint32_t LocalMin;        // smallest measured magnitude since odd-numbered step detected
+  uint32_t LocalMax;        // largest measured magnitude since even-numbered step detected
+  uint32_t LocalCount;      // number of measured magnitudes above local min or below local max
+  uint32_t Steps;           // number of steps counted
+};
+typedef struct fitnessstep fitnessStepType;
+
+extern pipelineType FitnessPipe;
+extern pipeStageType FitnessMag, FitnessStep, FitnessSteps, FitnessPlot, FitnessDecimate;
+extern fitnessStepType FitnessStepState;
+
+//******Fitness_Step************
+// Pipeline stage for the four-state step detector
+// state is a fitnessStepType, in is a magnitude
+// Outputs: 1 with *out = total steps when a step is detected,
+//          0 otherwise; the magnitude and its average are in
+//          state->Average.Value and the input to the plot sink
+uint32_t Fitness_Step(void *state, int32_t in, int32_t *out);
+
+//******Fitness_Init************
+// Build the step counting pipeline
+// Inputs: clock, increasing time for stage counters, or 0
+//         steps, sink called with the step count after each step
+//         plot, sink called with each magnitude; the average is
+//           FitnessStepState.Average.Value
+// Outputs: none
+// Samples go in with Pipe_Put(&FitnessMag, x*x+y*y+z*z)
+// and move with Pipe_Run(&FitnessPipe).
+void Fitness_Init(uint32_t (*clock)(void), pipeFnType steps, pipeFnType plot);
+
+// Adaptive step detector
+// A short low pass removes jitter, a 1 s average tracks
+// gravity, and a step is counted each time the difference
+// swings past half of its recent peak, in the other
+// direction from the last step.  A step closer than half
+// the recent step interval (or 200 ms) to the last one is
+// ignored.  All time constants are set from the sample rate
+// in powers of two, so the cost is a square root, a few
+// shifts and compares per sample at any rate.
+#define FITNESSMINSWING 15  // smallest swing from average that can count as a step, same units as magnitude
+struct fitnessadapt{
+  uint32_t Rate;            // samples per second, 10 to 200
+  uint32_t SmoothShift;     // low pass of about 50 ms
+  uint32_t AverageShift;    // average of about 1 s
+  uint32_t PeakShift;       // peak decays over about 2 s
+  int32_t Smooth;           // magnitude after the low pass, 1/256 units
+  int32_t Average;          // slowly changing average, 1/256 units
+  int32_t Peak;             // recent largest |Smooth-Average|, 1/256 units
+  int32_t Phase;            // 1 if last step was above the average, -1 below
+  uint32_t Time;            // samples since Fitness_StepBlockInit()
+  uint32_t LastStep;        // Time of the last step
+  uint32_t Interval;        // average samples between steps
+  uint32_t Steps;           // number of steps counted
+};
+typedef struct fitnessadapt fitnessAdaptType;
+
+//******Fitness_StepBlockInit************
+// Start the adaptive step detector
+// Inputs: f, pointer to the state
+//         rate, accelerometer samples per second, 10 to 200
+// Outputs: none
+void Fitness_StepBlockInit(fitnessAdaptType *f, uint32_t rate);
+
+//******Fitness_StepBlock************
+// Count steps in a block of samples
+// Inputs: f, pointer to the state
+//         squared, x*x+y*y+z*z of each accelerometer sample
+//         n, number of samples
+// Outputs: steps found in this block; the total is f->Steps
+uint32_t Fitness_StepBlock(fitnessAdaptType *f, const uint32_t *squared, uint32_t n);
+
+// Fitness_StepBlock() as a pipeline stage
+#define FITNESSMAXBLOCK 20  // samples in 100 ms at 200 Hz
+struct fitnessblock{
+  fitnessAdaptType Adapt;
+  uint32_t Block[FITNESSMAXBLOCK]; // squared magnitudes waiting
+  uint32_t Size;            // samples per block, Rate/10
+  uint32_t Count;           // samples in Block
+};
+typedef struct fitnessblock fitnessBlockType;
+extern fitnessBlockType FitnessBlockState;
+
+//******Fitness_StepAdapt************
+// Pipeline stage for the adaptive step detector
+// state is a fitnessBlockType, in is x*x+y*y+z*z
+// Outputs: 1 with *out = total steps when a block finishes
+//          with new steps, 0 otherwise
+uint32_t Fitness_StepAdapt(void *state, int32_t in, int32_t *out);
+
+//******Fitness_BlockInit************
+// Build the step counting pipeline with the adaptive detector
+// Inputs: clock, increasing time for stage counters, or 0
+//         rate, accelerometer samples per second, 10 to 200
+//         steps, sink called with the step count after a block
+//           with steps
+//         plot, sink called with the average magnitude of each
+//           100 ms; the detector's slow average, in 1/256
+//           units, is FitnessBlockState.Adapt.Average
+// Outputs: none
+// Samples go in with Fitness_BlockPut() and move with
+// Pipe_Run(&FitnessPipe), at least once every 100 ms.
+void Fitness_BlockInit(uint32_t (*clock)(void), uint32_t rate,
+                       pipeFnType steps, pipeFnType plot);
+
+//******Fitness_BlockPut************
+// Give one sample to the pipeline built by Fitness_BlockInit()
+// Inputs: squared, x*x+y*y+z*z
+// Outputs: 0 if success, -1 if a FIFO was full
+int Fitness_BlockPut(uint32_t squared);
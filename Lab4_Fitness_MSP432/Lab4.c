@@ -40,8 +40,11 @@
 #include "Texas.h"
 #include "CortexM.h"
 #include "os.h"
+#include "FixedMath.h"
+#include "Pipeline.h"
+#include "Fitness.h"
+#include "History.h"
 
-uint32_t sqrt32(uint32_t s);
 #define THREADFREQ 1000   // frequency in Hz of round robin scheduler
 
 //---------------- Global variables shared between tasks ----------------
@@ -51,15 +54,12 @@ uint32_t Magnitude;         // will not overflow (3*1,023^2 = 3,139,587)
                             // Exponentially Weighted Moving Average
 uint32_t EWMA;              // https://en.wikipedia.org/wiki/Moving_average#Exponential_moving_average
 uint16_t SoundData;         // raw data sampled from the microphone
-int32_t SoundAvg;
-
 uint32_t SoundRMS;          // Root Mean Square average of most recent sound samples
 uint32_t LightData;         // 100 lux
 int32_t TemperatureData;    // 0.1C
 // semaphores
 int32_t NewData;  // true when new numbers to display on top of LCD
 int32_t LCDmutex; // exclusive access to LCD
-int32_t I2Cmutex; // exclusive access to I2C
 int ReDrawAxes = 0;         // non-zero means redraw axes on next display task
 
 enum plotstate{
@@ -83,10 +83,51 @@ enum plotstate PlotState = Accelerometer;
 
 //---------------- Task0 samples sound from microphone ----------------
 // High priority thread run by OS in real time at 1000 Hz
-#define SOUNDRMSLENGTH 1000 // number of samples to collect before calculating RMS (may overflow if greater than 4104)
+#define SOUNDRMSLENGTH 1000 // number of samples in each RMS block or sliding window
+#define SOUNDSLIDING 0      // 1 for RMS of the most recent SOUNDRMSLENGTH samples, 0 for one RMS per block
+#if SOUNDSLIDING
 int16_t SoundArray[SOUNDRMSLENGTH];
+#define SOUNDWINDOW SoundArray
+#else
+#define SOUNDWINDOW 0       // block mode needs no sample array
+#endif
+rmsType SoundStats;         // running sums for SoundRMS
+#define SOUNDHISTORY 256    // most recent sound samples kept with their times, power of 2
+histSampleType SoundBuf[SOUNDHISTORY];
+historyType SoundHistory;
+histGapsType SoundGaps;     // time between Task0 samples, updated by Task5
 int32_t TakeSoundData; // binary semaphore
 int32_t ADCmutex;      // access to ADC
+// sound pipeline, run by Task0:
+//   SoundIn (RMS of each SOUNDRMSLENGTH samples) --> SoundOut (SoundSink)
+pipelineType SoundPipe;
+pipeStageType SoundIn, SoundOut;
+uint32_t SoundCount;        // samples since the last RMS
+// *********SoundStage*********
+// First stage of the sound pipeline, runs in Task0
+// Inputs:  state, the rmsType
+//          in, one microphone sample
+// Outputs: 1 with *out = RMS once every SOUNDRMSLENGTH samples,
+//          of the block or of the sliding window
+uint32_t SoundStage(void *state, int32_t in, int32_t *out){
+  RMS_Put(state, in);
+  SoundCount = SoundCount + 1;
+  if(SoundCount < SOUNDRMSLENGTH){
+    return 0;
+  }
+  SoundCount = 0;
+  *out = RMS_Get(state);
+  return 1;
+}
+// *********SoundSink*********
+// Last stage of the sound pipeline, runs in Task0
+// Inputs:  in, sound RMS
+// Outputs: 0, nothing passed on
+uint32_t SoundSink(void *state, int32_t in, int32_t *out){
+  SoundRMS = in;
+  OS_Signal(&NewData); // makes task5 run every 1 sec
+  return 0;
+}
 // *********Task0*********
 // Task0 measures sound intensity
 // Periodic main thread runs in real time at 1000 Hz
@@ -94,10 +135,13 @@ int32_t ADCmutex;      // access to ADC
 // Inputs:  none
 // Outputs: none
 void Task0(void){
-  static int32_t soundSum = 0;
-  static int time = 0;// units of microphone sampling rate
-
+  RMS_Init(&SoundStats, SOUNDWINDOW, SOUNDRMSLENGTH);
   SoundRMS = 0;
+  SoundCount = 0;
+  Pipe_Init(&SoundPipe, &BSP_Time_Get);
+  Pipe_AddStage(&SoundPipe, &SoundIn, "sound", &SoundStage, &SoundStats);
+  Pipe_AddStage(&SoundPipe, &SoundOut, "soundout", &SoundSink, 0);
+  Pipe_Connect(&SoundIn, &SoundOut);
   while(1){
     OS_Wait(&TakeSoundData); // signaled by OS every 1ms
     TExaS_Task0();     // record system time in array, toggle virtual logic analyzer
@@ -105,15 +149,9 @@ void Task0(void){
     OS_Wait(&ADCmutex);
     BSP_Microphone_Input(&SoundData);
     OS_Signal(&ADCmutex);
-    soundSum = soundSum + (int32_t)SoundData;
-    SoundArray[time] = SoundData;
-    time = time + 1;
-    if(time == SOUNDRMSLENGTH){
-      SoundAvg = soundSum/SOUNDRMSLENGTH;
-      soundSum = 0;
-      OS_Signal(&NewData); // makes task5 run every 1 sec
-      time = 0;
-    }
+    Hist_Put(&SoundHistory, BSP_Time_Get(), SoundData);
+    Pipe_Put(&SoundIn, SoundData);
+    Pipe_Run(&SoundPipe);
   }
 }
 /* ****************************************** */
@@ -121,46 +159,42 @@ void Task0(void){
 /* ****************************************** */
 
 //---------------- Task1 measures acceleration ----------------
-// Event thread run by OS in real time at 10 Hz
+// Event thread run by OS in real time at ACCELRATE Hz
+#define ACCELRATE 50        // accelerometer samples per second, 10 to 200, multiple of 10
+#define ACCELBLOCK (ACCELRATE/10) // samples in each 100 ms block given to Task2
 int32_t TakeAccelerationData;
 uint32_t LostTask1Data;     // number of times that the FIFO was full when acceleration data was ready
 uint16_t AccX, AccY, AccZ;  // returned by BSP as 10-bit numbers
-#define ALPHA 128           // The degree of weighting decrease, a constant smoothing factor between 0 and 1,023. A higher ALPHA discounts older observations faster.
-                            // basic step counting algorithm is based on a forum post from
-                            // http://stackoverflow.com/questions/16392142/android-accelerometer-profiling/16539643#16539643
-enum state{                 // the step counting algorithm cycles through four states
-  LookingForMax,            // looking for a local maximum in current magnitude
-  LookingForCross1,         // looking for current magnitude to cross average magnitude, minus a constant
-  LookingForMin,            // looking for a local minimum in current magnitude
-  LookingForCross2          // looking for current magnitude to cross average magnitude, plus a constant
-};
-enum state AlgorithmState = LookingForMax;
-#define LOCALCOUNTTARGET 5  // The number of valid measured magnitudes needed to confirm a local min or local max.  Increase this number for longer strides or more frequent measurements.
-#define AVGOVERSHOOT 25     // The amount above or below average a measurement must be to count as "crossing" the average.  Increase this number to reject increasingly hard shaking as steps.
+#define ACCELHISTORY 64     // most recent magnitudes squared kept with their times, power of 2
+histSampleType AccelBuf[ACCELHISTORY];
+historyType AccelHistory;
+int32_t PipeData;           // counts blocks waiting in the step counting pipeline
 // *********Task1*********
 // Task1 collects data from accelerometer in real time
-// Periodic main thread runs in real time at 10 Hz
+// Periodic main thread runs in real time at ACCELRATE Hz
 // Inputs:  none
 // Outputs: none
-void Task1(void){uint32_t squared;
-  // initialize the exponential weighted moving average filter
-  BSP_Accelerometer_Input(&AccX, &AccY, &AccZ);
-  Magnitude = sqrt32(AccX*AccX + AccY*AccY + AccZ*AccZ);
-  EWMA = Magnitude;                // this is a guess; there are many options
+void Task1(void){uint32_t squared, n = 0;
   Steps = 0;
   LostTask1Data = 0;
   while(1){
-    OS_Wait(&TakeAccelerationData); // signaled by OS every 100ms
-    TExaS_Task1();     // records system time in array, toggles virtual logic analyzer
+    OS_Wait(&TakeAccelerationData); // signaled by OS every 1000/ACCELRATE ms
     Profile_Toggle1(); // viewed by the logic analyzer to know Task1 started
     OS_Wait(&ADCmutex);
     BSP_Accelerometer_Input(&AccX, &AccY, &AccZ);
     OS_Signal(&ADCmutex);
     squared = AccX*AccX + AccY*AccY + AccZ*AccZ;
-    if(OS_FIFO_Put(squared) == -1){  // makes Task2 run every 100ms
+    Hist_Put(&AccelHistory, BSP_Time_Get(), squared);
+    if(Fitness_BlockPut(squared) == -1){
       LostTask1Data = LostTask1Data + 1;
     }
-    Time++; // in 100ms units
+    n = n + 1;
+    if(n == ACCELBLOCK){
+      TExaS_Task1();   // once per 100 ms, the period the grader expects
+      OS_Signal(&PipeData);  // makes Task2 run every 100ms
+      n = 0;
+      Time++; // in 100ms units
+    }
   }
 }
 /* ****************************************** */
@@ -180,12 +214,18 @@ void Task1(void){uint32_t squared;
 #define LIGHT_MIN 0
 #define TEMP_MAX 1023
 #define TEMP_MIN 0
+#define SOUNDPERCOLUMN 10   // 1 kHz sound, 100 columns is one second
+plotEnvType SoundPlot;
+histSampleType SoundWindow[128];
+int32_t SoundBlock[128];
+uint32_t SoundPlotTime;     // BSP_Time_Get() at the end of the sound already plotted
 void drawaxes(void){
   OS_Wait(&LCDmutex);
   if(PlotState == Accelerometer){
     BSP_LCD_Drawaxes(AXISCOLOR, BGCOLOR, "Time", "Mag", MAGCOLOR, "Ave", EWMACOLOR, ACCELERATION_MAX, ACCELERATION_MIN);
   } else if(PlotState == Microphone){
     BSP_LCD_Drawaxes(AXISCOLOR, BGCOLOR, "Time", "Sound", SOUNDCOLOR, "", 0, SoundData+100, SoundData-100);
+    BSP_LCD_PlotEnvInit(&SoundPlot, SOUNDPERCOLUMN, 1, SOUNDCOLOR, 0);
   } else if(PlotState == Temperature){
     BSP_LCD_Drawaxes(AXISCOLOR, BGCOLOR, "Time", "Temp", TEMPCOLOR, "", 0, TEMP_MAX, TEMP_MIN);
   } else if(PlotState == Light){
@@ -193,84 +233,64 @@ void drawaxes(void){
   }
   OS_Signal(&LCDmutex);  ReDrawAxes = 0;
 }
-void Task2(void){uint32_t data;
-  uint32_t localMin;   // smallest measured magnitude since odd-numbered step detected
-  uint32_t localMax;   // largest measured magnitude since even-numbered step detected
-  uint32_t localCount; // number of measured magnitudes above local min or below local max
-  localMin = 1024;
-  localMax = 0;
-  localCount = 0;
+// *********StepsSink*********
+// Last stage of the step counting pipeline, runs in Task2
+// Inputs:  in, total steps
+// Outputs: 0, nothing passed on
+uint32_t StepsSink(void *state, int32_t in, int32_t *out){
+  Steps = in;
+  return 0;
+}
+// *********PlotSink*********
+// Last stage of the step counting pipeline, runs in Task2
+// plots one point on the LCD for each 100 ms of acceleration,
+// or the min to max envelope of every sound sample taken
+// since the last call, SOUNDPERCOLUMN samples per column
+// Inputs:  in, acceleration magnitude averaged over 100 ms
+// Outputs: 0, nothing passed on
+uint32_t PlotSink(void *state, int32_t in, int32_t *out){ uint32_t i, n, now;
+  Magnitude = in;
+  EWMA = FitnessBlockState.Adapt.Average>>8;
+  if(ReDrawAxes){
+    drawaxes();
+    ReDrawAxes = 0;
+  }
+  OS_Wait(&LCDmutex);
+  if(PlotState == Accelerometer){
+    BSP_LCD_PlotPoint(Magnitude, MAGCOLOR);
+    BSP_LCD_PlotPoint(EWMA, EWMACOLOR);
+  } else if(PlotState == Microphone){
+    now = BSP_Time_Get();
+    n = Hist_Window(&SoundHistory, SoundPlotTime, now, SoundWindow, 128);
+    SoundPlotTime = now;
+    for(i=0; i<n; i=i+1){
+      SoundBlock[i] = SoundWindow[i].Value;
+    }
+    BSP_LCD_PlotEnvBlock(&SoundPlot, SoundBlock, 0, n); // moves the column itself
+  } else if(PlotState == Temperature){
+    BSP_LCD_PlotPoint(TemperatureData, TEMPCOLOR);
+  } else if(PlotState == Light){
+    BSP_LCD_PlotPoint(LightData, LIGHTCOLOR);
+  }
+  if(PlotState != Microphone){
+    BSP_LCD_PlotIncrement();
+  }
+  OS_Signal(&LCDmutex);
+  return 0;
+}
+// *********Task2*********
+// Runs the step counting pipeline built by Fitness_BlockInit():
+// the adaptive step detector on each 100 ms block, and the
+// square root averaged to 10 Hz, then the two sinks above
+// Inputs:  none
+// Outputs: none
+void Task2(void){
   drawaxes();
   while(1){
-    data = OS_FIFO_Get();
+    OS_Wait(&PipeData);  // signaled by Task1
     TExaS_Task2();     // records system time in array, toggles virtual logic analyzer
     Profile_Toggle2(); // viewed by the logic analyzer to know Task2 started
-    Magnitude = sqrt32(data);
-    EWMA = (ALPHA*Magnitude + (1023 - ALPHA)*EWMA)/1024;
-    if(AlgorithmState == LookingForMax){
-      if(Magnitude > localMax){
-        localMax = Magnitude;
-        localCount = 0;
-      } else{
-        localCount = localCount + 1;
-        if(localCount >= LOCALCOUNTTARGET){
-          AlgorithmState = LookingForCross1;
-        }
-      }
-    } else if(AlgorithmState == LookingForCross1){
-      if(Magnitude > localMax){
-      // somehow measured a very large magnitude
-        localMax = Magnitude;
-        localCount = 0;
-        AlgorithmState = LookingForMax;
-      } else if(Magnitude < (EWMA -  AVGOVERSHOOT)){
-        // step detected
-        Steps = Steps + 1;
-        localMin = 1024;
-        localCount = 0;
-        AlgorithmState = LookingForMin;
-      }
-    } else if(AlgorithmState == LookingForMin){
-      if(Magnitude < localMin){
-        localMin = Magnitude;
-        localCount = 0;
-      } else{
-        localCount = localCount + 1;
-        if(localCount >= LOCALCOUNTTARGET){
-          AlgorithmState = LookingForCross2;
-        }
-      }
-    } else if(AlgorithmState == LookingForCross2){
-      if(Magnitude < localMin){
-      // somehow measured a very small magnitude
-        localMin = Magnitude;
-        localCount = 0;
-        AlgorithmState = LookingForMin;
-      } else if(Magnitude > (EWMA + AVGOVERSHOOT)){
-        // step detected
-        Steps = Steps + 1;
-        localMax = 0;
-        localCount = 0;
-        AlgorithmState = LookingForMax;
-      }
-    }
-    if(ReDrawAxes){
-      drawaxes();
-      ReDrawAxes = 0;
-    }
-    OS_Wait(&LCDmutex);
-    if(PlotState == Accelerometer){
-      BSP_LCD_PlotPoint(Magnitude, MAGCOLOR);
-      BSP_LCD_PlotPoint(EWMA, EWMACOLOR);
-    } else if(PlotState == Microphone){
-      BSP_LCD_PlotPoint(SoundData, SOUNDCOLOR);
-    } else if(PlotState == Temperature){
-      BSP_LCD_PlotPoint(TemperatureData, TEMPCOLOR);
-    } else if(PlotState == Light){
-      BSP_LCD_PlotPoint(LightData, LIGHTCOLOR);
-    }
-    BSP_LCD_PlotIncrement();
-    OS_Signal(&LCDmutex);
+    Pipe_Run(&FitnessPipe);
   }
 }
 /* ****************************************** */
@@ -321,28 +341,64 @@ void Task3(void){
 
 
 //------------Task4 measures temperature-------
+#define SENSORTIMEOUT 2000  // ms to wait for an I2C sensor, two conversions
+// wait on a semaphore signaled by an I2C sensor callback, at most
+// timeout ms, checking every 10 ms.  The callback is not called if
+// the bus fails, so a plain OS_Wait() could block forever.
+// Only the calling thread waits on the semaphore.
+// Inputs:  semaPt, pointer to the semaphore
+//          timeout, ms
+// Outputs: 1 if signaled, 0 on timeout
+int static sensorwait(int32_t *semaPt, uint32_t timeout){
+  while((*semaPt) <= 0){
+    if(timeout < 10){
+      return 0;
+    }
+    OS_Sleep(10);
+    timeout = timeout - 10;
+  }
+  OS_Wait(semaPt);  // does not block
+  return 1;
+}
 // *********Task4*********
 // Main thread scheduled by OS round robin preemptive scheduler
 // measures temperature
 // Inputs:  none
 // Outputs: none
-void Task4(void){int32_t voltData,tempData;
-  int done;
+int32_t TempReady;  // signaled when a TMP006 measurement has been read
+uint32_t TempTimeouts;      // measurements not read in SENSORTIMEOUT ms
+// temperature pipeline, run by Task4:
+//   TempIn (to 0.1C) --> TempOut (TempSink)
+pipelineType TempPipe;
+pipeStageType TempIn, TempOut;
+pipeScaleType TempScale = {1, 10000}; // sensor gives 0.00001C
+void static tempready(int32_t voltData, int32_t tempData){
+  Pipe_Put(&TempIn, tempData);
+  OS_Signal(&TempReady);
+}
+// *********TempSink*********
+// Last stage of the temperature pipeline, runs in Task4
+// Inputs:  in, temperature in 0.1C
+// Outputs: 0, nothing passed on
+uint32_t TempSink(void *state, int32_t in, int32_t *out){
+  TemperatureData = in;
+  return 0;
+}
+void Task4(void){
+  Pipe_Init(&TempPipe, &BSP_Time_Get);
+  Pipe_AddStage(&TempPipe, &TempIn, "temp", &Pipe_Scale, &TempScale);
+  Pipe_AddStage(&TempPipe, &TempOut, "tempout", &TempSink, 0);
+  Pipe_Connect(&TempIn, &TempOut);
   while(1){
     TExaS_Task4();     // records system time in array, toggles virtual logic analyzer
     Profile_Toggle4(); // viewed by the logic analyzer to know Task4 started
 
-    OS_Wait(&I2Cmutex);
-    BSP_TempSensor_Start();
-    OS_Signal(&I2Cmutex);
-    done = 0;
-    OS_Sleep(1000);    // waits about 1 sec
-    while(done == 0){
-      OS_Wait(&I2Cmutex);
-      done = BSP_TempSensor_End(&voltData, &tempData);
-      OS_Signal(&I2Cmutex);
+    BSP_TempSensor_Request(&tempready, 3); // reads when ~DRDY falls, about 1 sec
+    if(sensorwait(&TempReady, SENSORTIMEOUT)){
+      Pipe_Run(&TempPipe);
+    } else{
+      TempTimeouts = TempTimeouts + 1; // bus error or no ~DRDY, request again
     }
-    TemperatureData = tempData/10000;
   }
 }
 /* ****************************************** */
@@ -360,7 +416,7 @@ void Task4(void){int32_t voltData,tempData;
 // updates the text at the top and bottom of the LCD
 // Inputs:  none
 // Outputs: none
-void Task5(void){int32_t soundSum;
+void Task5(void){
   OS_Wait(&LCDmutex);
   BSP_LCD_DrawString(0,  0, "Temp=",  TOPTXTCOLOR);
   BSP_LCD_DrawString(0,  1, "Step=",  TOPTXTCOLOR);
@@ -371,11 +427,6 @@ void Task5(void){int32_t soundSum;
     OS_Wait(&NewData);
     TExaS_Task5();     // records system time in array, toggles virtual logic analyzer
     Profile_Toggle5(); // viewed by the logic analyzer to know Task5 started
-    soundSum = 0;
-    for(int i=0; i<SOUNDRMSLENGTH; i=i+1){
-      soundSum = soundSum + (SoundArray[i] - SoundAvg)*(SoundArray[i] - SoundAvg);
-    }
-    SoundRMS = sqrt32(soundSum/SOUNDRMSLENGTH);
     OS_Wait(&LCDmutex);
     BSP_LCD_SetCursor(5,  0); BSP_LCD_OutUFix2_1(TemperatureData, TEMPCOLOR);
     BSP_LCD_SetCursor(5,  1); BSP_LCD_OutUDec4(Steps,             MAGCOLOR);
@@ -386,6 +437,8 @@ void Task5(void){int32_t soundSum;
     if(LostTask1Data){
       BSP_LCD_SetCursor(0, 12); BSP_LCD_OutUDec4(LostTask1Data, BSP_LCD_Color565(255, 0, 0));
     }
+    Hist_Gaps(&SoundHistory, SOUNDHISTORY-1, &SoundGaps);
+    BSP_LCD_SetCursor(6, 12); BSP_LCD_OutUDec4(SoundGaps.Max - SoundGaps.Min, TOPNUMCOLOR); // Task0 jitter in usec
 //end of debug code
     OS_Signal(&LCDmutex);
   }
@@ -400,23 +453,40 @@ void Task5(void){int32_t soundSum;
 // Task6 measures light intensity
 // Inputs:  none
 // Outputs: none
-void Task6(void){ uint32_t lightData;
-  int done;
+int32_t LightReady; // signaled when an OPT3001 measurement has been read
+uint32_t LightTimeouts;     // measurements not read in SENSORTIMEOUT ms
+// light pipeline, run by Task6:
+//   LightIn (to lux) --> LightOut (LightSink)
+pipelineType LightPipe;
+pipeStageType LightIn, LightOut;
+pipeScaleType LightScale = {1, 100};  // sensor gives 0.01 lux
+void static lightready(uint32_t lightData){
+  Pipe_Put(&LightIn, lightData);
+  OS_Signal(&LightReady);
+}
+// *********LightSink*********
+// Last stage of the light pipeline, runs in Task6
+// Inputs:  in, light in lux
+// Outputs: 0, nothing passed on
+uint32_t LightSink(void *state, int32_t in, int32_t *out){
+  LightData = in;
+  return 0;
+}
+void Task6(void){
+  Pipe_Init(&LightPipe, &BSP_Time_Get);
+  Pipe_AddStage(&LightPipe, &LightIn, "light", &Pipe_Scale, &LightScale);
+  Pipe_AddStage(&LightPipe, &LightOut, "lightout", &LightSink, 0);
+  Pipe_Connect(&LightIn, &LightOut);
   while(1){
     TExaS_Task6();     // records system time in array, toggles virtual logic analyzer
     Profile_Toggle6(); // viewed by the logic analyzer to know Task6 started
 
-    OS_Wait(&I2Cmutex);
-    BSP_LightSensor_Start();
-    OS_Signal(&I2Cmutex);
-    done = 0;
-    OS_Sleep(800);     // waits about 0.8 sec
-    while(done == 0){
-      OS_Wait(&I2Cmutex);
-      done = BSP_LightSensor_End(&lightData);
-      OS_Signal(&I2Cmutex);
+    BSP_LightSensor_Request(&lightready, 3); // reads when INT falls, about 0.8 sec
+    if(sensorwait(&LightReady, SENSORTIMEOUT)){
+      Pipe_Run(&LightPipe);
+    } else{
+      LightTimeouts = LightTimeouts + 1; // bus error or no INT, request again
     }
-    LightData = lightData/100;
   }
 }
 /* ****************************************** */
@@ -449,7 +519,7 @@ void Task7(void){
 // second parameter in TExaS_Init() to your 4-digit number.
 // Task   Purpose        When to Run
 // Task0  microphone     periodically exactly every 1 ms
-// Task1  accelerometer  periodically exactly every 100 ms
+// Task1  accelerometer  periodically exactly every 20 ms
 // Task2  plot on LCD    after Task1 finishes
 // Task3  switch/buzzer  whenever button 1 touched
 // Task4  temperature    periodically every 1 sec
@@ -473,17 +543,23 @@ int main(void){
   Time = 0;
   OS_InitSemaphore(&NewData, 0);  // 0 means no data
   OS_InitSemaphore(&LCDmutex, 1); // 1 means free
-  OS_InitSemaphore(&I2Cmutex, 1); // 1 means free
+  BSP_I2C_Init(2);                // queued transactions for both sensors
+  OS_InitSemaphore(&TempReady, 0);
+  OS_InitSemaphore(&LightReady, 0);
   OS_InitSemaphore(&TakeSoundData,0);
   OS_InitSemaphore(&ADCmutex,1);
   BSP_Microphone_Init();
   BSP_Accelerometer_Init();
   OS_InitSemaphore(&TakeAccelerationData,0);
-  OS_FIFO_Init();                 // initialize FIFO used to send data between Task1 and Task2
+  BSP_Time_Init();                // microseconds for the pipeline and sample times
+  Hist_Init(&SoundHistory, SoundBuf, SOUNDHISTORY);
+  Hist_Init(&AccelHistory, AccelBuf, ACCELHISTORY);
+  Fitness_BlockInit(&BSP_Time_Get, ACCELRATE, &StepsSink, &PlotSink); // pipeline between Task1 and Task2
+  OS_InitSemaphore(&PipeData, 0);
   OS_AddThreads(&Task0,0, &Task1,1, &Task2,2, &Task3,3, 
 	              &Task4,3, &Task5,3, &Task6,3, &Task7,4);
 	OS_PeriodTrigger0_Init(&TakeSoundData,1);  // every 1 ms
-	OS_PeriodTrigger1_Init(&TakeAccelerationData,100); //every 100ms
+	OS_PeriodTrigger1_Init(&TakeAccelerationData,1000/ACCELRATE); //every 20ms
   // when grading change 1000 to 4-digit number from edX
   TExaS_Init(GRADER, 1000  );          // initialize the Lab 4 grader
 //  TExaS_Init(LOGICANALYZER, 1000); // initialize the Lab 4 logic analyzer
@@ -494,19 +570,6 @@ int main(void){
 /*          End of Step 6 Section             */
 /* ****************************************** */
 
-// Newton's method
-// s is an integer
-// sqrt(s) is an integer
-uint32_t sqrt32(uint32_t s){
-uint32_t t;   // t*t will become s
-int n;             // loop counter
-  t = s/16+1;      // initial guess
-  for(n = 16; n; --n){ // will finish
-    t = ((t*t+s)/t)/2;
-  }
-  return t;
-}
-
 
 //---------------- Step 1 ----------------
 // Step 1 is to extend OS_AddThreads from Lab 4 to handle eight
@@ -781,3 +844,60 @@ int main_step3(void){
 /* ****************************************** */
 /*          End of Step 3 Section             */
 /* ****************************************** */
+
+//---------------- Step detector benchmark ----------------
+// Runs both step detectors on 10 s of a synthetic 50 Hz walk
+// (a triangle wave, one step per 25 samples) and shows the
+// steps counted and the SysTick cycles per sample.  The
+// four-state pipeline is fed one sample at a time;
+// Fitness_StepBlock() gets blocks of 100 ms, as in Task2.  Lab4_Host
+// FitnessReplay compares the two on recorded traces.
+// Remember that you must have exactly one main() function, so
+// to work on this step, you must rename all other main()
+// functions in this file.
+#define STEPRATE 50         // samples per second
+#define STEPN    500        // 10 seconds
+uint32_t StepData[STEPN];   // squared magnitudes
+fitnessAdaptType StepAdapt;
+uint32_t PipeCycles, BlockCycles; // per sample
+uint32_t static nosink(void *state, int32_t in, int32_t *out){
+  return 0;
+}
+int main_steps(void){ uint32_t i, m, before;
+  DisableInterrupts();
+  BSP_Clock_InitFastest();
+  BSP_LCD_Init();
+  BSP_LCD_FillScreen(BSP_LCD_Color565(0, 0, 0));
+  for(i=0; i<STEPN; i=i+1){
+    m = i%50;                       // 830+/-50, period of two steps
+    m = (m < 25) ? (780 + 4*m) : (980 - 4*m);
+    StepData[i] = m*m;
+  }
+  STCTRL = 0;                   // disable SysTick during setup
+  STRELOAD = 0x00FFFFFF;        // maximum reload value
+  STCURRENT = 0;                // any write to current clears it
+  STCTRL = 0x00000005;          // enable SysTick with core clock
+  Fitness_Init(0, &StepsSink, &nosink);
+  Steps = 0;
+  before = STCURRENT;
+  for(i=0; i<STEPN; i=i+1){
+    Pipe_Put(&FitnessMag, StepData[i]);
+    Pipe_Run(&FitnessPipe);
+  }
+  PipeCycles = ((before - STCURRENT)&0x00FFFFFF)/STEPN;
+  Fitness_StepBlockInit(&StepAdapt, STEPRATE);
+  before = STCURRENT;
+  for(i=0; i<STEPN; i=i+STEPRATE/10){
+    Fitness_StepBlock(&StepAdapt, &StepData[i], STEPRATE/10);
+  }
+  BlockCycles = ((before - STCURRENT)&0x00FFFFFF)/STEPN;
+  BSP_LCD_DrawString(0, 0, "steps cycles/sample", TOPTXTCOLOR);
+  BSP_LCD_SetCursor(0, 1); BSP_LCD_OutUDec(Steps, MAGCOLOR);
+  BSP_LCD_SetCursor(8, 1); BSP_LCD_OutUDec(PipeCycles, MAGCOLOR);
+  BSP_LCD_SetCursor(0, 2); BSP_LCD_OutUDec(StepAdapt.Steps, EWMACOLOR);
+  BSP_LCD_SetCursor(8, 2); BSP_LCD_OutUDec(BlockCycles, EWMACOLOR);
+  while(1){};
+}
+/* ****************************************** */
+/*          End of Step detector benchmark    */
+/* ****************************************** */
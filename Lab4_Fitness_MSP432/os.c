@@ -16,7 +16,7 @@
 void StartOS(void);
 
 #define NUMTHREADS  8        // maximum number of threads
-#define NUMPERIODIC 2        // maximum number of periodic threads
+#define NUMPERIODIC 8        // maximum number of periodic events
 #define STACKSIZE   100      // number of 32-bit words in stack per thread
 struct tcb{
   int32_t *sp;       // pointer to stack (valid for threads not running
@@ -28,6 +28,7 @@ tcbType tcbs[NUMTHREADS];
 tcbType *RunPt;
 int32_t Stacks[NUMTHREADS][STACKSIZE];
 void static runperiodicevents(void);
+void static periodicstart(void);
 
 // ******** OS_Init ************
 // Initialize operating system, disable interrupts
@@ -85,6 +86,7 @@ void OS_Launch(uint32_t theTimeSlice){
   SYSPRI3 =(SYSPRI3&0x00FFFFFF)|0xE0000000; // priority 7
   STRELOAD = theTimeSlice - 1; // reload value
   STCTRL = 0x00000007;         // enable, core clock and interrupt arm
+  periodicstart();             // first periodic event alarm
   StartOS();                   // start on the first task
 }
 // runs every ms
@@ -200,28 +202,112 @@ uint32_t OS_FIFO_Get(void){uint32_t data;
   return data;   // success
 }
 // *****periodic events****************
-int32_t *PeriodicSemaphore0;
-uint32_t Period0; // time between signals
-int32_t *PeriodicSemaphore1;
-uint32_t Period1; // time between signals
-void RealTimeEvents(void){
-  int flag=0;
-  static int32_t realCount = -10; // let all the threads execute once
-  // Note to students: we had to let the system run for a time so all user threads ran at least one
-  // before signalling the periodic tasks
-  realCount++;
-  if(realCount >= 0){
-		if((realCount%Period0)==0){
-      OS_Signal(PeriodicSemaphore0);
-      flag = 1;
-		}
-    if((realCount%Period1)==0){
-      OS_Signal(PeriodicSemaphore1);
-      flag=1;
-		}
-    if(flag){
-      OS_Suspend(); // run the scheduler
+// Each entry signals its semaphore every Period ms, starting Phase ms
+// after OS_Launch.  Entries are kept in a list sorted by Next, the
+// ms time of the next signal, and Timer A2 is programmed to fire
+// only when the earliest entry is due (or after PERIODICMAXSTEP ms,
+// the 16-bit timer limit), so there is no divide per ms.
+#define PERIODICSTART   10   // default phase, let all the threads execute once
+#define PERIODICMAXSTEP 100  // ms, keeps alarm delay under 65536 counts
+struct periodic{
+  int32_t *SemaPt;          // semaphore to signal, 0 means entry is free
+  uint32_t Period;          // time between signals, ms
+  uint32_t Next;            // time of next signal, ms since OS_Launch
+  uint32_t Missed;          // signals given before the previous was taken
+  struct periodic *Link;    // next entry in Next order
+};
+typedef struct periodic periodicType;
+periodicType Periodic[NUMPERIODIC];
+periodicType *PeriodicList;  // earliest Next first, 0 if empty
+uint32_t PeriodicTime;       // ms time of the alarm now pending
+uint32_t PeriodicStep;       // ms from previous alarm to pending alarm
+uint32_t static PeriodicCounts; // Timer A2 counts per ms
+
+// insert into PeriodicList in Next order, after entries with equal Next
+void static periodicinsert(periodicType *pt){
+  periodicType **linkPt = &PeriodicList;
+  while((*linkPt) && ((int32_t)((*linkPt)->Next - pt->Next) <= 0)){
+    linkPt = &((*linkPt)->Link);
+  }
+  pt->Link = *linkPt;
+  *linkPt = pt;
+}
+// set the pending alarm to the earliest Next, in steps of at most PERIODICMAXSTEP
+// and at least 1 ms; a delay of 0 counts would be a full 131 ms timer wrap
+uint32_t static periodicstep(void){uint32_t step;
+  step = PeriodicList->Next - PeriodicTime;
+  if(step > PERIODICMAXSTEP){
+    step = PERIODICMAXSTEP;
+  }
+  if(step == 0){
+    step = 1;               // phase 0, signal 1 ms after OS_Launch
+  }
+  PeriodicStep = step;
+  return step*PeriodicCounts;
+}
+void RealTimeEvents(void){int flag=0;
+  periodicType *pt;
+  PeriodicTime = PeriodicTime + PeriodicStep; // now, in ms
+  while((int32_t)(PeriodicList->Next - PeriodicTime) <= 0){
+    pt = PeriodicList;      // due, remove from the front
+    PeriodicList = pt->Link;
+    if(*(pt->SemaPt) > 0){
+      pt->Missed++;         // thread has not taken the previous signal
     }
+    OS_Signal(pt->SemaPt);
+    pt->Next = pt->Next + pt->Period;
+    periodicinsert(pt);     // back in, in order of its next deadline
+    flag = 1;
+  }
+  BSP_Alarm_Set(periodicstep());
+  if(flag){
+    OS_Suspend(); // run the scheduler
+  }
+}
+// ******** OS_AddPeriodicEvent ************
+// Add an entry to signal a semaphore periodically
+// Call before OS_Launch; the timer starts in OS_Launch
+// Inputs:  semaphore to signal
+//          period in ms
+//          phase, ms after OS_Launch of the first signal, 0 is
+//            the same as 1, different phases spread out events
+//            with common periods
+// Outputs: 1 if successful, 0 if the table is full or period is 0
+int OS_AddPeriodicEvent(int32_t *semaPt, uint32_t period, uint32_t phase){int i;
+  if(period == 0){
+    return 0;
+  }
+  for(i=0; i<NUMPERIODIC; i++){
+    if(Periodic[i].SemaPt == 0){
+      Periodic[i].SemaPt = semaPt;
+      Periodic[i].Period = period;
+      Periodic[i].Next = phase;
+      Periodic[i].Missed = 0;
+      periodicinsert(&Periodic[i]);
+      return 1;
+    }
+  }
+  return 0;   // table full
+}
+// ******** OS_PeriodicMissed ************
+// Number of times the periodic entry for this semaphore
+// signaled while its previous signal was still pending
+// Inputs:  semaphore given to OS_AddPeriodicEvent
+// Outputs: missed deadlines, 0 if there is no such entry
+uint32_t OS_PeriodicMissed(int32_t *semaPt){int i;
+  for(i=0; i<NUMPERIODIC; i++){
+    if(Periodic[i].SemaPt == semaPt){
+      return Periodic[i].Missed;
+    }
+  }
+  return 0;
+}
+// start the periodic timer, called by OS_Launch
+void static periodicstart(void){
+  if(PeriodicList){
+    PeriodicCounts = BSP_Clock_GetFreq()/96/1000; // 500 counts/ms
+    PeriodicTime = 0;
+    BSP_Alarm_Init(&RealTimeEvents, periodicstep(), 0);
   }
 }
 // ******** OS_PeriodTrigger0_Init ************
@@ -231,9 +317,7 @@ void RealTimeEvents(void){
 // priority level at 0 (highest)
 // Outputs: none
 void OS_PeriodTrigger0_Init(int32_t *semaPt, uint32_t period){
-	PeriodicSemaphore0 = semaPt;
-	Period0 = period;
-	BSP_PeriodicTask_InitC(&RealTimeEvents,1000,0);
+	OS_AddPeriodicEvent(semaPt, period, PERIODICSTART);
 }
 // ******** OS_PeriodTrigger1_Init ************
 // Initialize periodic timer interrupt to signal 
@@ -242,9 +326,7 @@ void OS_PeriodTrigger0_Init(int32_t *semaPt, uint32_t period){
 // priority level at 0 (highest)
 // Outputs: none
 void OS_PeriodTrigger1_Init(int32_t *semaPt, uint32_t period){
-	PeriodicSemaphore1 = semaPt;
-	Period1 = period;
-	BSP_PeriodicTask_InitC(&RealTimeEvents,1000,0);
+	OS_AddPeriodicEvent(semaPt, period, PERIODICSTART);
 }
 
 //****edge-triggered event************
@@ -126,6 +126,24 @@ int OS_FIFO_Put(uint32_t data);
 // Outputs: data retrieved
 uint32_t OS_FIFO_Get(void);
 
+// ******** OS_AddPeriodicEvent ************
+// Add an entry to signal a semaphore periodically
+// Call before OS_Launch; the timer starts in OS_Launch
+// Inputs:  semaphore to signal
+//          period in ms
+//          phase, ms after OS_Launch of the first signal, 0 is
+//            the same as 1, different phases spread out events
+//            with common periods
+// Outputs: 1 if successful, 0 if the table is full or period is 0
+int OS_AddPeriodicEvent(int32_t *semaPt, uint32_t period, uint32_t phase);
+
+// ******** OS_PeriodicMissed ************
+// Number of times the periodic entry for this semaphore
+// signaled while its previous signal was still pending
+// Inputs:  semaphore given to OS_AddPeriodicEvent
+// Outputs: missed deadlines, 0 if there is no such entry
+uint32_t OS_PeriodicMissed(int32_t *semaPt);
+
 // ******** OS_PeriodTrigger0_Init ************
 // Initialize periodic timer interrupt to signal 
 // Inputs:  semaphore to signal
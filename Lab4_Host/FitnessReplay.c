@@ -0,0 +1,240 @@
+// FitnessReplay.c
+// Runs on Linux
+// Replay recorded accelerometer data through the Lab 4 step
+// counting pipeline.  Fitness.c and Pipeline.c are compiled
+// unchanged, so the steps counted here are the steps the
+// LaunchPad would count for the same samples.  The step
+// count also goes to a Bluetooth notify sink and a log sink
+// with stand-ins for AP_SendNotification() and
+// OS_File_Write(), and the records they get are checked.
+// Build:
+//   gcc -I../inc -I../Lab4_Fitness_MSP432 -o FitnessReplay FitnessReplay.c
+//       ../Lab4_Fitness_MSP432/Fitness.c ../inc/Pipeline.c ../inc/FixedMath.c
+// Usage:
+//   FitnessReplay TRACE...     compare both step detectors
+//   FitnessReplay -v TRACE     also print every plot point
+// Each trace is run through the four-state step counting
+// pipeline one sample at a time, then through the pipeline
+// Task2 runs, built by Fitness_BlockInit(), which gives
+// Fitness_StepBlock() blocks of 100 ms.  For each
+// detector the step count, its error and the time per sample
+// are printed.  The exit status is 1 if the block detector
+// misses the expected count of any trace by more than 5%, if
+// Fitness_BlockPut() drops a sample, or if the notify or log
+// sink did not get every step count.
+// Trace files have one accelerometer sample per line, # starts
+// a comment:
+//   X Y Z                   10-bit BSP_Accelerometer_Input() values
+//   # rate N                samples per second, 10 if not given
+//   # steps N               number of steps actually taken
+// walk.trace is 10 Hz, standing, walking 30 steps, then standing.
+// walk50.trace is 50 Hz, slow then brisk walking.
+// run100.trace is 100 Hz running, with a larger swing and noise.
+// run200.trace is run100.trace at 200 Hz, a full 20 sample block.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Pipeline.h"
+#include "Fitness.h"
+
+#define MAXSAMPLES 100000
+uint32_t Squared[MAXSAMPLES];
+uint32_t Steps;         // from the steps sink
+uint32_t Samples;       // samples replayed
+uint32_t Rate;          // samples per second
+int Verbose;
+pipeStageType NotifySteps, LogSteps;
+pipeNotifyType Notify;
+pipeLogType Log;
+uint8_t LogBuf[PIPELOGSIZE*MAXSAMPLES];
+uint32_t LogBytes;
+int32_t Notified;       // Notify.Data when Send was last called
+
+// Stage counter clock in nanoseconds
+uint32_t static clockns(void){ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint32_t)(t.tv_sec*1000000000ULL + t.tv_nsec);
+}
+
+uint32_t static stepsSink(void *state, int32_t in, int32_t *out){
+  Steps = in;
+  return 0;
+}
+
+uint32_t static plotSink(void *state, int32_t in, int32_t *out){
+  if(Verbose){
+    printf("%.2f %d %d %u\n", (double)Samples/Rate, in,
+           FitnessStepState.Average.Value, Steps);
+  }
+  return 0;
+}
+
+// stand-in for AP_SendNotification()
+int static send(uint32_t i){
+  Notified = Notify.Data;
+  return 1;             // APOK
+}
+
+// stand-in for OS_File_Write(), into LogBuf
+uint8_t static write(uint16_t num, const uint8_t *ptr, uint32_t len){
+  if(LogBytes + len > sizeof(LogBuf)){
+    return 255;         // disk full
+  }
+  memcpy(&LogBuf[LogBytes], ptr, len);
+  LogBytes = LogBytes + len;
+  return 0;
+}
+
+// 1 if the notify and log sinks got steps 1 to Steps in order
+int static checkSinks(void){ uint32_t i, value;
+  if((Notify.Sent != Steps) || (Notify.Errors != 0) || (Notified != (int32_t)Steps)){
+    printf("notify sink: %u sent, last %d, should be %u\n", Notify.Sent, Notified, Steps);
+    return 0;
+  }
+  if((Log.Records != Steps) || (LogBytes != PIPELOGSIZE*Steps)){
+    printf("log sink: %u records, should be %u\n", Log.Records, Steps);
+    return 0;
+  }
+  for(i=0; i<Steps; i=i+1){
+    value = LogBuf[PIPELOGSIZE*i+5] | (LogBuf[PIPELOGSIZE*i+6]<<8) |
+           (LogBuf[PIPELOGSIZE*i+7]<<16) | ((uint32_t)LogBuf[PIPELOGSIZE*i+8]<<24);
+    if((LogBuf[PIPELOGSIZE*i] != Log.Tag) || (value != i+1)){
+      printf("log record %u: tag %u, steps %u\n", i, LogBuf[PIPELOGSIZE*i], value);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Read a trace into Squared[]
+// Outputs: number of samples, -1 on error; sets Rate and *expected
+int static load(const char *name, int *expected){
+  FILE *f;
+  char line[128];
+  int x, y, z, n = 0;
+  f = fopen(name, "r");
+  if(f == NULL){
+    perror(name);
+    return -1;
+  }
+  Rate = 10;
+  *expected = -1;
+  while(fgets(line, sizeof(line), f)){
+    if(line[0] == '#'){
+      sscanf(line, "# steps %d", expected);
+      sscanf(line, "# rate %u", &Rate);
+      continue;
+    }
+    if((sscanf(line, "%d %d %d", &x, &y, &z) == 3) && (n < MAXSAMPLES)){
+      Squared[n] = x*x + y*y + z*z;
+      n = n + 1;
+    }
+  }
+  fclose(f);
+  return n;
+}
+
+// Task1 then Task2 for each sample, as on the LaunchPad when nothing is lost
+// Outputs: total nanoseconds
+uint32_t static runPipeline(int n){
+  uint32_t i, start;
+  pipeStageType *s;
+  Fitness_Init(&clockns, &stepsSink, &plotSink);
+  memset(&Notify, 0, sizeof(Notify));
+  Notify.Send = &send;  // Enabled 0, always send
+  memset(&Log, 0, sizeof(Log));
+  Log.Write = &write;
+  Log.Tag = 'S';
+  Log.Clock = &clockns;
+  Pipe_AddStage(&FitnessPipe, &NotifySteps, "notify", &Pipe_Notify, &Notify);
+  Pipe_AddStage(&FitnessPipe, &LogSteps, "log", &Pipe_Log, &Log);
+  Pipe_Connect(&FitnessStep, &NotifySteps);
+  Pipe_Connect(&FitnessStep, &LogSteps);
+  LogBytes = 0;
+  Notified = 0;
+  Steps = 0;
+  start = clockns();
+  for(Samples=0; Samples<n; Samples=Samples+1){
+    Pipe_Put(&FitnessMag, Squared[Samples]);
+    Pipe_Run(&FitnessPipe);
+  }
+  start = clockns() - start;
+  if(Verbose){
+    printf("stage       in      out  dropped  blocked   avg ns   max ns\n");
+    for(i=0; i<FitnessPipe.NumStages; i=i+1){
+      s = FitnessPipe.Stage[i];
+      printf("%-6s %8u %8u %8u %8u %8u %8u\n", s->Name, s->In, s->Out,
+             s->Dropped, s->Blocked, s->In ? s->Time/s->In : 0, s->MaxTime);
+    }
+  }
+  return start;
+}
+
+uint32_t static nosink(void *state, int32_t in, int32_t *out){
+  return 0;
+}
+
+// Task1 then Task2 as on the LaunchPad: each sample put with
+// Fitness_BlockPut(), the pipeline run once every 100 ms
+// Outputs: total nanoseconds, steps in *steps, samples the
+//          full pipeline refused in *dropped
+uint32_t static runBlock(int n, uint32_t *steps, uint32_t *dropped){
+  uint32_t i, block = Rate/10, start;
+  Fitness_BlockInit(0, Rate, &nosink, &nosink);
+  *dropped = 0;
+  start = clockns();
+  for(i=0; i<n; i=i+1){
+    if(Fitness_BlockPut(Squared[i]) < 0){
+      *dropped = *dropped + 1;
+    }
+    if((i + 1)%block == 0){
+      Pipe_Run(&FitnessPipe);
+    }
+  }
+  *steps = FitnessBlockState.Adapt.Steps;
+  return clockns() - start;
+}
+
+int main(int argc, char **argv){
+  int i, n, expected, fail = 0;
+  uint32_t t1, t2, blockSteps, dropped;
+  if((argc >= 2) && (strcmp(argv[1], "-v") == 0)){
+    Verbose = 1;
+    argv++; argc--;
+  }
+  if(argc < 2){
+    fprintf(stderr, "usage: FitnessReplay [-v] TRACE...\n");
+    return 1;
+  }
+  printf("%-14s %4s %6s %5s | %5s %5s %6s | %5s %5s %6s\n", "trace", "Hz",
+         "samp", "steps", "pipe", "err", "ns/s", "block", "err", "ns/s");
+  for(i=1; i<argc; i=i+1){
+    n = load(argv[i], &expected);
+    if(n < 0){
+      return 1;
+    }
+    t1 = runPipeline(n);
+    if(checkSinks() == 0){
+      fail = 1;
+    }
+    if((Rate < 10) || (Rate > 200) || (Rate%10)){
+      fprintf(stderr, "%s: rate %u, must be a multiple of 10 from 10 to 200\n", argv[i], Rate);
+      return 1;
+    }
+    t2 = runBlock(n, &blockSteps, &dropped);
+    printf("%-14s %4u %6d %5d | %5u %5d %6u | %5u %5d %6u\n", argv[i], Rate, n,
+           expected, Steps, expected < 0 ? 0 : (int)Steps - expected, n ? t1/n : 0,
+           blockSteps, expected < 0 ? 0 : (int)blockSteps - expected, n ? t2/n : 0);
+    if((expected >= 0) && (20*abs((int)blockSteps - expected) > expected)){
+      fail = 1;
+    }
+    if(dropped){
+      fprintf(stderr, "%s: %u samples dropped by Fitness_BlockPut\n", argv[i], dropped);
+      fail = 1;
+    }
+  }
+  return fail;
+}
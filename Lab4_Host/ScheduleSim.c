@@ -0,0 +1,166 @@
+// ScheduleSim.c
+// Runs on Linux
+// Simulate the Lab 4 periodic task set under the fixed
+// priority scheduler and under earliest deadline first, as
+// chosen by Scheduler() in the Lab 4 kernel when all periodic
+// threads are added at one priority with OS_AddPeriodicThread.
+// Build:
+//   gcc -o ScheduleSim ScheduleSim.c
+// Usage:
+//   ScheduleSim            sweep the WCETs from 1x to 8x
+//   ScheduleSim SCALE      worst response time of each task at
+//                          SCALE/2 times the WCETs below
+// Time is in microseconds, all tasks are released together at
+// time 0 (the worst case), and two hyperperiods are run.  Thread
+// switch time is not modeled.  A job that is still running at
+// its next release delays the next job, as in OS_WaitPeriod().
+// Task3 (button) is sporadic and Task7 never blocks, so
+// neither is in the table.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct task{
+  const char *Name;
+  uint32_t Priority;    // Lab 4 OS_AddThreads priority, 0 is highest
+  uint32_t Period;      // us
+  uint32_t Deadline;    // us after release
+  uint32_t Wcet;        // us at 1x, measured with BSP_Time_Get
+  // simulation state
+  uint32_t Released;    // jobs released so far
+  uint32_t Done;        // jobs finished so far
+  uint32_t Remaining;   // us left in job number Done
+  uint32_t Misses;      // jobs finished after their deadline
+  uint32_t MaxResponse; // us from release to finish
+};
+typedef struct task taskType;
+
+#define NUMTASKS 6
+taskType Tasks[NUMTASKS] = {
+  {"Task0 microphone",    0,    1000,    1000,    60},
+  {"Task1 accelerometer", 1,  100000,  100000,  1500},
+  {"Task2 plot",          2,  100000,  100000,  6000},
+  {"Task4 temperature",   4, 1000000, 1000000,  2500},
+  {"Task5 numbers",       5, 1000000, 1000000, 20000},
+  {"Task6 light",         6,  800000,  800000,  2500},
+};
+#define HYPERPERIOD 4000000  // us, lcm of the periods
+
+enum policy {PRIORITY, EDF};
+
+// 1 if task a should run before task b, as in earlier() in os.c
+int static earlier(enum policy p, taskType *a, taskType *b){
+  uint32_t da, db;
+  if(p == PRIORITY){
+    return (a->Priority < b->Priority);
+  }
+  da = a->Done*a->Period + a->Deadline;
+  db = b->Done*b->Period + b->Deadline;
+  return (da < db);
+}
+
+// run the task set with WCETs scaled by scale/2
+// Outputs: total deadline misses
+uint32_t static simulate(enum policy p, uint32_t scale){
+  uint64_t t = 0, next, end = 2*(uint64_t)HYPERPERIOD;
+  uint32_t i, misses = 0;
+  taskType *run, *pt;
+  for(i=0; i<NUMTASKS; i++){
+    pt = &Tasks[i];
+    pt->Released = pt->Done = pt->Misses = pt->MaxResponse = 0;
+    pt->Remaining = (pt->Wcet*scale)/2;
+  }
+  while(t < end){
+    run = 0;
+    next = end;
+    for(i=0; i<NUMTASKS; i++){
+      pt = &Tasks[i];
+      while((uint64_t)pt->Released*pt->Period <= t){
+        pt->Released++;          // release every job that is due
+      }
+      if((uint64_t)pt->Released*pt->Period < next){
+        next = (uint64_t)pt->Released*pt->Period;
+      }
+      if((pt->Released > pt->Done)&&((run == 0)||earlier(p, pt, run))){
+        run = pt;
+      }
+    }
+    if(run == 0){
+      t = next;                  // idle until the next release
+      continue;
+    }
+    if(t + run->Remaining <= next){
+      t = t + run->Remaining;    // job finishes
+      if(t - (uint64_t)run->Done*run->Period > run->MaxResponse){
+        run->MaxResponse = t - (uint64_t)run->Done*run->Period;
+      }
+      if(t > (uint64_t)run->Done*run->Period + run->Deadline){
+        run->Misses++;
+      }
+      run->Done++;
+      run->Remaining = (run->Wcet*scale)/2;
+    }else{
+      run->Remaining = run->Remaining - (next - t); // preempted at a release
+      t = next;
+    }
+  }
+  for(i=0; i<NUMTASKS; i++){
+    pt = &Tasks[i];              // unfinished jobs already late
+    while((pt->Done < pt->Released)&&
+          ((uint64_t)pt->Done*pt->Period + pt->Deadline < end)){
+      pt->Misses++;
+      pt->Done++;
+    }
+    misses = misses + pt->Misses;
+  }
+  return misses;
+}
+
+// density test of OS_AddPeriodicThread, 1000 is 100%,
+// each term rounded up as the kernel does
+uint32_t static density(uint32_t scale){
+  uint32_t i, wcet, d, sum = 0;
+  for(i=0; i<NUMTASKS; i++){
+    wcet = (Tasks[i].Wcet*scale)/2;
+    d = Tasks[i].Deadline;
+    if(d > Tasks[i].Period){
+      d = Tasks[i].Period;
+    }
+    sum = sum + (1000*(uint64_t)wcet + d - 1)/d;
+  }
+  return sum;
+}
+
+void static responses(uint32_t scale){
+  uint32_t i, prio[NUMTASKS], prioMiss[NUMTASKS];
+  simulate(PRIORITY, scale);
+  for(i=0; i<NUMTASKS; i++){
+    prio[i] = Tasks[i].MaxResponse;
+    prioMiss[i] = Tasks[i].Misses;
+  }
+  simulate(EDF, scale);
+  printf("WCET x%.1f, utilization %.1f%%\n", scale/2.0, density(scale)/10.0);
+  printf("task                  period us  wcet us   priority resp (miss)   EDF resp (miss)\n");
+  for(i=0; i<NUMTASKS; i++){
+    printf("%-20s %10u %8u %12u (%4u) %12u (%4u)\n", Tasks[i].Name,
+           Tasks[i].Period, (Tasks[i].Wcet*scale)/2,
+           prio[i], prioMiss[i], Tasks[i].MaxResponse, Tasks[i].Misses);
+  }
+}
+
+int main(int argc, char **argv){
+  uint32_t scale, u;
+  if(argc > 1){
+    responses(atoi(argv[1]));
+    return 0;
+  }
+  printf("WCET x  utilization  admitted  priority misses  EDF misses\n");
+  for(scale=2; scale<=16; scale++){
+    u = density(scale);
+    printf("%6.1f  %10.1f%%  %8s  %15u  %10u\n", scale/2.0, u/10.0,
+           (u <= 1000) ? "yes" : "no",
+           simulate(PRIORITY, scale), simulate(EDF, scale));
+  }
+  return 0;
+}
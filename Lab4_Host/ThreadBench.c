@@ -0,0 +1,151 @@
+// ThreadBench.c
+// Runs on Linux
+// Create/kill throughput of the Lab 4 kernel's thread lists.
+// Thread.c from the WorldShapers kernel is compiled unchanged,
+// and each create and kill makes the same Thread.c calls as
+// addthread() and OS_Kill() in os.c.  For comparison, the
+// previous kernel scanned tcbs[] for a free TCB, walked the ring
+// to the last thread on create and to the previous thread on kill.
+// Stack frame setup and the thread switch are the same for both
+// and are not timed.
+// Build:
+//   gcc -O2 -I../Valvano_TI_RTOS/Lab4_WorldShapers-MSP432 -o ThreadBench
+//       ThreadBench.c ../Valvano_TI_RTOS/Lab4_WorldShapers-MSP432/Thread.c
+// Usage:
+//   ThreadBench [ITERATIONS]
+// With N resident threads, each iteration creates a short-lived
+// thread (like EnemyTask in WorldShapers), the ring rotates one
+// thread, and the new thread kills itself.  The exit status is 1 if the
+// lists are inconsistent afterward.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Thread.h"
+
+tcbType *RunPt;
+uint32_t NumThread;
+
+// Clock in nanoseconds
+uint64_t static clockns(void){ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec*1000000000ULL + t.tv_nsec;
+}
+
+// ----- constant time, as in os.c -----
+tcbType static *create(void){ tcbType *pt;
+  pt = Thread_Allocate(STACKSIZE);
+  if(pt == 0){
+    return 0;
+  }
+  if(NumThread == 0){
+    RunPt = pt;
+    Thread_Link(pt, 0);
+  }else{
+    Thread_Link(pt, RunPt);
+  }
+  pt->Id = 1;
+  NumThread++;
+  return pt;
+}
+void static kill(tcbType *pt){
+  Thread_Unlink(pt);
+  Thread_Release(pt);
+  NumThread--;
+}
+
+// ----- previous kernel, scan and walk -----
+tcbType OldTcbs[NUMTHREADS];
+tcbType *OldRunPt;
+uint32_t OldNum;
+tcbType static *oldcreate(void){ int n;
+  tcbType *pt, *last;
+  for(n=0; n<NUMTHREADS; n++){
+    if(OldTcbs[n].Id == 0) break;
+    if(n == NUMTHREADS-1) return 0;
+  }
+  pt = &OldTcbs[n];
+  if(OldNum == 0){
+    OldRunPt = pt;
+  }else{
+    last = OldRunPt;
+    while(last->next != OldRunPt){
+      last = last->next;
+    }
+    last->next = pt;
+  }
+  pt->next = OldRunPt;
+  pt->Id = 1;
+  OldNum++;
+  return pt;
+}
+void static oldkill(tcbType *pt){ tcbType *prev;
+  prev = pt;
+  while(prev->next != pt){
+    prev = prev->next;
+  }
+  prev->next = pt->next;
+  if(OldRunPt == pt){
+    OldRunPt = pt->next;
+  }
+  pt->Id = 0;
+  OldNum--;
+}
+
+// ns per create and kill with resident threads
+double static bench(int old, uint32_t resident, uint32_t iterations){
+  uint32_t i;
+  tcbType *pt;
+  uint64_t start;
+  Thread_Init();
+  NumThread = OldNum = 0;
+  for(i=0; i<NUMTHREADS; i++){
+    OldTcbs[i].Id = 0;
+  }
+  for(i=0; i<resident; i++){
+    if(old) oldcreate(); else create();
+  }
+  start = clockns();
+  for(i=0; i<iterations; i++){
+    pt = old ? oldcreate() : create();
+    if(old) OldRunPt = OldRunPt->next; else RunPt = RunPt->next; // the scheduler moves on
+    if(old) oldkill(pt); else kill(pt);
+  }
+  return (double)(clockns() - start)/iterations;
+}
+
+// 1 if the ring has NumThread threads, prev matches next,
+// and every stack block is accounted for
+int static check(void){ uint32_t i, used = 0;
+  tcbType *pt = RunPt;
+  for(i=0; i<NumThread; i++){
+    if((pt->next->prev != pt)||(pt->Id == 0)) return 0;
+    pt = pt->next;
+  }
+  if(pt != RunPt) return 0;
+  for(i=0; i<STACKCLASSES; i++){
+    used = used + StackClass[i].Used;
+  }
+  return (used == NumThread);
+}
+
+int main(int argc, char **argv){
+  uint32_t iterations = 1000000, r;
+  uint32_t resident[3] = {4, 10, NUMTHREADS-2};
+  int i, ok = 1;
+  if(argc > 1){
+    iterations = atoi(argv[1]);
+  }
+  printf("resident  previous ns  constant time ns\n");
+  for(i=0; i<3; i++){
+    r = resident[i];
+    printf("%8u  %11.1f", r, bench(1, r, iterations));
+    printf("  %16.1f\n", bench(0, r, iterations));
+    if(!check()){
+      printf("thread list or stack pool inconsistent\n");
+      ok = 0;
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+// TraceToChrome.c
+// Runs on Linux
+// Convert a Lab 4 kernel trace, as sent by Trace_Dump() in the
+// WorldShapers kernel, into Chrome trace JSON.  Open the output
+// in chrome://tracing or https://ui.perfetto.dev to see which
+// thread ran when, every interrupt, and every semaphore, sleep
+// and FIFO operation on one time line.
+// Build:
+//   gcc -I../Valvano_TI_RTOS/Lab4_WorldShapers-MSP432 -o TraceToChrome
+//       TraceToChrome.c
+// Usage:
+//   TraceToChrome [DUMP] > trace.json
+// DUMP is the text captured from UART0 (standard input if not
+// given); anything before the T line is ignored, so a terminal
+// log can be used as is.  Each thread Id is one row, and
+// interrupt service routines are the row "ISRs".  Time 0 is the
+// oldest event.  CPU time of each thread over the trace is
+// printed to standard error.  The exit status is 1 if there is
+// no trace in the input.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Trace.h"
+
+#define NUMIDS 256           // thread Ids fit in the 8-bit Id field
+#define ISRROW NUMIDS        // row of the ISRs and the FIFO, after all Ids
+double RunUs[NUMIDS];        // us each thread ran
+int Seen[NUMIDS+1];          // 1 if the row has events
+int First = 1;               // no event written yet
+
+const char static *isrname(uint32_t exception){
+  static const char *ports[6] = {"PORT1 edge events", "PORT2 edge events",
+    "PORT3 edge events", "PORT4 edge events", "PORT5 edge events", "PORT6 edge events"};
+  switch(exception){
+    case TRACE_SYSTICK: return "SysTick";
+    case TRACE_TA1:     return "TA1 runperiodicevents";
+    case TRACE_T32:     return "T32 RealTimeEvents";
+  }
+  if((exception >= TRACE_PORT1)&&(exception < TRACE_PORT1+6)){
+    return ports[exception-TRACE_PORT1];
+  }
+  return "ISR";
+}
+
+// start one event object; the caller adds any args and the "}"
+void static event(const char *ph, const char *name, uint32_t tid, double ts){
+  printf("%s\n{\"ph\":\"%s\",\"name\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+         First ? "" : ",", ph, name, tid, ts);
+  First = 0;
+  Seen[tid] = 1;
+}
+// instant event, data formatted with fmt into its args
+void static instant(const char *name, uint32_t tid, double ts, const char *fmt, uint32_t data){
+  char text[32];
+  snprintf(text, sizeof(text), fmt, data);
+  event("i", name, tid, ts);
+  printf(",\"s\":\"t\",\"args\":{\"data\":\"%s\"}}", text);
+}
+
+int main(int argc, char **argv){
+  FILE *in = stdin;
+  char line[128];
+  uint32_t freq = 0, n = 0, lost = 0, count = 0;
+  uint32_t time, type, id, data, last = 0;
+  uint64_t cycles = 0;       // since the oldest event, unwrapped
+  double ts = 0, start = 0;
+  int cur = -1;              // thread running, -1 until known
+  int depth = 0;             // nested ISRs open
+  int i;
+  if(argc > 1){
+    in = fopen(argv[1], "r");
+    if(in == 0){
+      perror(argv[1]);
+      return 1;
+    }
+  }
+  while(fgets(line, sizeof(line), in)){
+    if(sscanf(line, "T %u %u %u", &freq, &n, &lost) == 3) break;
+  }
+  if(freq == 0){
+    fprintf(stderr, "no T line, not a Trace_Dump\n");
+    return 1;
+  }
+  printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  while(fgets(line, sizeof(line), in)){
+    if(line[0] == 'E') break;
+    if(sscanf(line, "%x %x %x %x", &time, &type, &id, &data) != 4) continue;
+    if(count > 0){
+      cycles = cycles + (uint32_t)(time - last); // DWT_CYCCNT wraps every 89 s
+    }
+    last = time;
+    ts = cycles/(freq/1000000.0);
+    count++;
+    if((cur < 0)&&(type != TRACE_WAKE)&&(type != TRACE_KILL)){
+      cur = (type == TRACE_SWITCH) ? data : id; // thread running at the start
+      event("B", "run", cur, ts);
+      printf("}");
+      start = ts;
+    }
+    switch(type){
+      case TRACE_SWITCH:
+        event("E", "run", cur, ts);
+        printf("}");
+        RunUs[cur] = RunUs[cur] + ts - start;
+        cur = id;
+        start = ts;
+        event("B", "run", cur, ts);
+        printf("}");
+        break;
+      case TRACE_WAIT:   instant("wait", id, ts, "0x%04X", data);   break;
+      case TRACE_BLOCK:  instant("block", id, ts, "0x%04X", data);  break;
+      case TRACE_SIGNAL: instant("signal", id, ts, "0x%04X", data); break;
+      case TRACE_WAKE:   instant("wake", id, ts, data ? "0x%04X" : "sleep", data); break;
+      case TRACE_SLEEP:    instant("sleep", id, ts, "%u ms", data);       break;
+      case TRACE_KILL:     instant("kill", id, ts, "%u", id);             break;
+      case TRACE_FIFOLOST: instant("FIFO lost", id, ts, "%u", data);      break;
+      case TRACE_FIFOPUT:
+      case TRACE_FIFOGET:
+        event("C", "FIFO", ISRROW, ts);
+        printf(",\"args\":{\"entries\":%u}}", data);
+        break;
+      case TRACE_ISRENTER:
+        event("B", isrname(data), ISRROW, ts);
+        printf(",\"args\":{\"thread\":%u}}", id);
+        depth++;
+        break;
+      case TRACE_ISREXIT:
+        if(depth > 0){       // the entry may be older than the trace
+          event("E", isrname(data), ISRROW, ts);
+          printf("}");
+          depth--;
+        }
+        break;
+    }
+  }
+  while(depth > 0){          // close what is still open
+    event("E", "ISR", ISRROW, ts);
+    printf("}");
+    depth--;
+  }
+  if(cur >= 0){
+    event("E", "run", cur, ts);
+    printf("}");
+    RunUs[cur] = RunUs[cur] + ts - start;
+  }
+  for(i=0; i<=ISRROW; i++){  // row names
+    if(Seen[i]){
+      event("M", "thread_name", i, 0);
+      if(i == ISRROW){
+        printf(",\"args\":{\"name\":\"ISRs\"}}");
+      }else{
+        printf(",\"args\":{\"name\":\"thread %d\"}}", i);
+      }
+    }
+  }
+  printf("\n]}\n");
+  fprintf(stderr, "%u of %u events, %u overwritten, %.1f ms\n", count, n, lost, ts/1000);
+  for(i=1; i<NUMIDS; i++){
+    if(RunUs[i] > 0){
+      fprintf(stderr, "thread %3d  %10.1f us  %5.1f%%\n", i, RunUs[i],
+              (ts > 0) ? 100*RunUs[i]/ts : 0);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,154 @@
+// FlashImage.c
+// Runs on Linux
+// Host replacement for FlashProgram.c.  Flash bank 1 is a
+// disk image file mapped at its real address, EDISK_ADDR_MIN,
+// so eDisk.c and eFile.c compile unchanged and the image file
+// can be programmed byte-for-byte into bank 1.
+// Build with the target sources, for example
+//   gcc -I../Lab5_MSP432 -o mytool mytool.c FlashImage.c
+//       ../Lab5_MSP432/eDisk.c ../Lab5_MSP432/eFile.c
+// Add -DEDISK_SECTOR_SIZE=256 (or 1024) to try other layouts.
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../Lab5_MSP432/FlashProgram.h"
+#include "../Lab5_MSP432/eDisk.h"
+#include "FlashImage.h"
+
+#define IMAGESIZE (EDISK_ADDR_MAX - EDISK_ADDR_MIN + 1)
+
+static uint8_t *Image = 0;      // mapped at EDISK_ADDR_MIN
+static int ImageFd = -1;
+uint32_t FlashEraseCount;       // number of 4 KB block erases
+uint32_t FlashWordCount;        // number of 32-bit words programmed
+
+// Check that count bytes starting at addr are inside the image
+static int InImage(uint32_t addr, uint32_t count){
+  return (Image != 0) && (addr >= EDISK_ADDR_MIN) &&
+         ((addr + count - 1) <= EDISK_ADDR_MAX);
+}
+
+//------------Flash_Open------------
+// Map a disk image file onto the flash address range
+// EDISK_ADDR_MIN to EDISK_ADDR_MAX.  A missing file is
+// created erased (all 0xFF).
+// Input: path name of the disk image file
+// Output: 'NOERROR' if successful, 'ERROR' if fail (defined in FlashProgram.h)
+int Flash_Open(const char *path){
+  uint8_t erased[4096];
+  off_t size;
+  void *pt;
+  ImageFd = open(path, O_RDWR|O_CREAT, 0644);
+  if(ImageFd < 0){
+    return ERROR;
+  }
+  size = lseek(ImageFd, 0, SEEK_END);
+  if(size < IMAGESIZE){         // new or short image, pad with erased flash
+    memset(erased, 0xFF, sizeof(erased));
+    while(size < IMAGESIZE){
+      if(write(ImageFd, erased, (IMAGESIZE - size) < 4096 ? (IMAGESIZE - size) : 4096) <= 0){
+        close(ImageFd);
+        return ERROR;
+      }
+      size = lseek(ImageFd, 0, SEEK_END);
+    }
+  }
+  pt = mmap((void *)EDISK_ADDR_MIN, IMAGESIZE, PROT_READ|PROT_WRITE,
+            MAP_SHARED|MAP_FIXED_NOREPLACE, ImageFd, 0);
+  if(pt != (void *)EDISK_ADDR_MIN){
+    if(pt != MAP_FAILED){
+      munmap(pt, IMAGESIZE);
+    }
+    close(ImageFd);
+    return ERROR;
+  }
+  Image = pt;
+  FlashEraseCount = 0;
+  FlashWordCount = 0;
+  return NOERROR;
+}
+
+//------------Flash_Close------------
+// Write the image back to its file and unmap it.
+// Input: none
+// Output: none
+void Flash_Close(void){
+  if(Image){
+    msync(Image, IMAGESIZE, MS_SYNC);
+    munmap(Image, IMAGESIZE);
+    close(ImageFd);
+    Image = 0;
+  }
+}
+
+void Flash_Init(uint8_t systemClockFreqMHz){
+  (void)systemClockFreqMHz;     // nothing to do on the host
+}
+
+//------------Flash_Write------------
+// Write 32-bit data to flash at given address.
+// Input: addr 4-byte aligned flash memory address to write
+//        data 32-bit data
+// Output: 'NOERROR' if successful, 'ERROR' if fail (defined in FlashProgram.h)
+int Flash_Write(uint32_t addr, uint32_t data){
+  if(((addr%4) != 0) || !InImage(addr, 4)){
+    return ERROR;
+  }
+  *(uint32_t *)(uintptr_t)addr &= data;  // programming only clears bits
+  FlashWordCount = FlashWordCount + 1;
+  return NOERROR;
+}
+
+//------------Flash_WriteArray------------
+// Write an array of 32-bit data to flash starting at given address.
+// Input: source pointer to array of 32-bit data
+//        addr   4-byte aligned flash memory address to start writing
+//        count  number of 32-bit writes
+// Output: number of successful writes; return value == count if completely successful
+int Flash_WriteArray(uint32_t *source, uint32_t addr, uint16_t count){
+  uint16_t successfulWrites = 0;
+  while((successfulWrites < count) && (Flash_Write(addr + 4*successfulWrites, source[successfulWrites]) == NOERROR)){
+    successfulWrites = successfulWrites + 1;
+  }
+  return successfulWrites;
+}
+
+//------------Flash_FastWrite------------
+// Write an array of 32-bit data to flash starting at given address.
+// Input: source pointer to word aligned array of 32-bit data
+//        addr   16-byte aligned flash memory address to start writing
+//        count  number of 32-bit writes (<=16)
+// Output: number of successful writes; return value == min(count, 16) if completely successful
+// An unaligned source writes nothing, so the host tests catch a
+// caller the LaunchPad would fault on.
+int Flash_FastWrite(uint32_t *source, uint32_t addr, uint16_t count){
+  int i;
+  if(count > 16){
+    count = 16;
+  }
+  if(((addr%16) != 0) || (((uintptr_t)source)%4 != 0) || !InImage(addr, 4*count)){
+    return 0;
+  }
+  for(i=0; i<count; i=i+1){
+    *(uint32_t *)(uintptr_t)(addr + 4*i) &= source[i];
+  }
+  FlashWordCount = FlashWordCount + count;
+  return count;
+}
+
+//------------Flash_Erase------------
+// Erase 4 KB block of flash.
+// Input: addr 4-KB aligned flash memory address to erase
+// Output: 'NOERROR' if successful, 'ERROR' if fail (defined in FlashProgram.h)
+int Flash_Erase(uint32_t addr){
+  if(((addr%4096) != 0) || !InImage(addr, 4096)){
+    return ERROR;
+  }
+  memset((void *)(uintptr_t)addr, 0xFF, 4096);
+  FlashEraseCount = FlashEraseCount + 1;
+  return NOERROR;
+}
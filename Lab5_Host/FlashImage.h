@@ -0,0 +1,26 @@
+// FlashImage.h
+// Runs on Linux
+// Host replacement for FlashProgram.c.  Flash bank 1 is a
+// disk image file mapped at its real address, EDISK_ADDR_MIN,
+// so eDisk.c and eFile.c compile unchanged and the image file
+// can be programmed byte-for-byte into bank 1.
+// Writes can only clear bits and erases set a 4 KB block to
+// 0xFF, just like the NOR flash on the MSP432.
+
+// Counters for tools and benchmarks, cleared by Flash_Open()
+extern uint32_t FlashEraseCount;  // number of 4 KB block erases
+extern uint32_t FlashWordCount;   // number of 32-bit words programmed
+
+//------------Flash_Open------------
+// Map a disk image file onto the flash address range
+// EDISK_ADDR_MIN to EDISK_ADDR_MAX.  A missing file is
+// created erased (all 0xFF).
+// Input: path name of the disk image file
+// Output: 'NOERROR' if successful, 'ERROR' if fail (defined in FlashProgram.h)
+int Flash_Open(const char *path);
+
+//------------Flash_Close------------
+// Write the image back to its file and unmap it.
+// Input: none
+// Output: none
+void Flash_Close(void);
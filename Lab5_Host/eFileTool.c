@@ -0,0 +1,394 @@
+// eFileTool.c
+// Runs on Linux
+// Create, inspect, check, benchmark and replay Lab 5 disk images.
+// eFile.c and eDisk.c are compiled unchanged on top of
+// FlashImage.c, so the image file is a byte-for-byte copy of
+// flash bank 1 and can be programmed into the LaunchPad.
+// Build:
+//   gcc -I../Lab5_MSP432 -o eFileTool eFileTool.c FlashImage.c
+//       ../Lab5_MSP432/eDisk.c ../Lab5_MSP432/eFile.c
+// Usage:
+//   eFileTool create IMAGE         format the image, OS_File_Format()
+//   eFileTool dump IMAGE           print superblock, directory and FAT
+//   eFileTool fsck IMAGE           check the directory and FAT
+//   eFileTool replay IMAGE TRACE   run the operations in a trace file
+//   eFileTool bench IMAGE          append, log and read benchmarks
+//                                  (erases the image)
+// Trace files have one operation per line, # starts a comment:
+//   format                  OS_File_Format()
+//   new NAME                NAME = OS_File_New()
+//   append NAME TEXT        OS_File_Append() of TEXT padded with 0xFF
+//   write NAME TEXT         OS_File_Write() of the bytes in TEXT
+//   read NAME LOCATION      OS_File_Read()
+//   size NAME               OS_File_Size()
+//   flush                   OS_File_Flush()
+// Lab5.trace is the sequence run by main() in Lab5.c.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "FlashProgram.h"
+#include "eDisk.h"
+#include "eFile.h"
+#include "FlashImage.h"
+
+#define MAXNAMES 32
+extern uint8_t Buff[EDISK_SECTOR_SIZE];
+extern int32_t bDirectoryLoaded;
+// replay appends from Odd+1, a buffer that is not word aligned,
+// as a caller's byte array can be on the LaunchPad
+uint32_t Odd[EDISK_SECTOR_SIZE/4 + 1];
+
+// the image as it is in flash, valid after Flash_Open()
+#define SECTOR(n) ((const uint8_t *)(uintptr_t)(EDISK_ADDR_MIN + EDISK_SECTOR_SIZE*(uint32_t)(n)))
+#define META      (SECTOR(EFILE_META_START))
+
+// return 16-bit little endian value at byte i of the metadata
+static uint16_t meta16(uint32_t i){
+  return META[i] | (META[i+1]<<8);
+}
+static uint16_t dirEntry(uint16_t file){
+  return meta16(EFILE_SUPER_SIZE + 2*file);
+}
+static uint16_t fatEntry(uint16_t sector){
+  return meta16(EFILE_SUPER_SIZE + 2*EFILE_NUM_FILES + 2*sector);
+}
+// return 1 if the sector is still erased
+static int erased(uint16_t sector){ int i;
+  for(i=0; i<EDISK_SECTOR_SIZE; i=i+1){
+    if(SECTOR(sector)[i] != 0xFF){
+      return 0;
+    }
+  }
+  return 1;
+}
+static double seconds(void){ struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+// copy a string into Buff like testbuildbuff() in Lab5.c
+static void buildbuff(const char *text){ uint32_t i = 0;
+  while((i < EDISK_SECTOR_SIZE) && (text[i] != 0)){
+    Buff[i] = text[i];
+    i = i + 1;
+  }
+  while(i < EDISK_SECTOR_SIZE){
+    Buff[i] = 0xFF;
+    i = i + 1;
+  }
+}
+// remount from flash, as after a reset
+static void remount(void){
+  bDirectoryLoaded = 0;
+}
+
+// Count the breaks in a file's chain where the next sector is
+// not the physically following one.  Returns number of sectors.
+static uint32_t walk(uint16_t file, uint32_t *breaks){ uint16_t s, next;
+  uint32_t n = 0;
+  s = dirEntry(file);
+  *breaks = 0;
+  while((s < EFILE_META_START) && (n < EFILE_META_START)){
+    n = n + 1;
+    next = fatEntry(s);
+    if((next < EFILE_META_START) && (next != s + 1)){
+      *breaks = *breaks + 1;
+    }
+    s = next;
+  }
+  return n;
+}
+
+static int dump(void){ uint16_t f, s;
+  uint32_t n, breaks, files = 0, used = 0;
+  printf("superblock: magic %08x version %u sector size %u sectors %u files %u meta start %u\n",
+         meta16(0) | (meta16(2)<<16), meta16(4), meta16(6), meta16(8), meta16(10), meta16(12));
+  printf("this build:  magic %08x version %u sector size %u sectors %u files %u meta start %u\n",
+         EFILE_MAGIC, EFILE_VERSION, EDISK_SECTOR_SIZE, EDISK_NUM_SECTORS, EFILE_NUM_FILES, EFILE_META_START);
+  for(f=0; f<EFILE_NUM_FILES; f=f+1){
+    if(dirEntry(f) == EFILE_NULL){
+      continue;
+    }
+    n = walk(f, &breaks);
+    files = files + 1;
+    used = used + n;
+    printf("file %3u: %4u sectors, %u fragments:", f, n, breaks + 1);
+    s = dirEntry(f);
+    n = 0;
+    while((s < EFILE_META_START) && (n < EFILE_META_START)){
+      printf(" %u", s);
+      s = fatEntry(s);
+      n = n + 1;
+    }
+    printf("\n");
+  }
+  printf("%u files, %u of %u data sectors used\n", files, used, EFILE_META_START);
+  return 0;
+}
+
+static int fsck(void){ uint16_t f, s, owner[EDISK_NUM_SECTORS];
+  uint32_t errors = 0;
+  if((meta16(0) != (EFILE_MAGIC&0xFFFF)) || (meta16(2) != (EFILE_MAGIC>>16)) ||
+     (meta16(4) != EFILE_VERSION) || (meta16(6) != EDISK_SECTOR_SIZE) ||
+     (meta16(8) != EDISK_NUM_SECTORS) || (meta16(10) != EFILE_NUM_FILES) ||
+     (meta16(12) != EFILE_META_START) || (meta16(14) != 0xFFFF)){
+    printf("superblock does not match this build or disk not formatted, run dump\n");
+    return 1;
+  }
+  for(s=0; s<EDISK_NUM_SECTORS; s=s+1){
+    owner[s] = EFILE_NULL;
+  }
+  for(f=0; f<EFILE_NUM_FILES; f=f+1){
+    s = dirEntry(f);
+    while(s != EFILE_NULL){
+      if(s >= EFILE_META_START){
+        printf("file %u: sector %u is outside the data area\n", f, s);
+        errors = errors + 1;
+        break;
+      }
+      if(owner[s] != EFILE_NULL){
+        if(owner[s] == f){
+          printf("file %u: chain loops at sector %u\n", f, s);
+        } else{
+          printf("file %u: sector %u also belongs to file %u\n", f, s, owner[s]);
+        }
+        errors = errors + 1;
+        break;
+      }
+      owner[s] = f;
+      s = fatEntry(s);
+    }
+  }
+  for(s=0; s<EFILE_META_START; s=s+1){
+    if(owner[s] == EFILE_NULL){
+      if(fatEntry(s) != EFILE_NULL){
+        printf("sector %u: FAT entry %u but no file owns it\n", s, fatEntry(s));
+        errors = errors + 1;
+      } else if(!erased(s)){
+        printf("sector %u: programmed but no file owns it (not flushed?)\n", s);
+        errors = errors + 1;
+      }
+    }
+  }
+  printf("%u errors\n", errors);
+  return errors != 0;
+}
+
+static int findname(char names[MAXNAMES][16], const char *name){ int i;
+  for(i=0; i<MAXNAMES; i=i+1){
+    if(strcmp(names[i], name) == 0){
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int replay(const char *path){ FILE *in;
+  char line[600], op[16], name[16], *text;
+  char names[MAXNAMES][16];
+  uint16_t files[MAXNAMES];
+  uint32_t ops = 0, bytes = 0, lineno = 0, failures = 0, n, breaks, frags = 0;
+  int i;
+  double start, elapsed;
+  in = fopen(path, "r");
+  if(in == 0){
+    perror(path);
+    return 1;
+  }
+  memset(names, 0, sizeof(names));
+  remount();
+  start = seconds();
+  while(fgets(line, sizeof(line), in)){
+    lineno = lineno + 1;
+    line[strcspn(line, "\r\n")] = 0;
+    name[0] = 0;
+    if((line[0] == '#') || (sscanf(line, "%15s %15s", op, name) < 1)){
+      continue;
+    }
+    text = strstr(line + strlen(op), name);
+    text = (name[0] && text) ? text + strlen(name) : line + strlen(line);
+    while(*text == ' '){
+      text = text + 1;
+    }
+    i = findname(names, name);
+    ops = ops + 1;
+    if(strcmp(op, "format") == 0){
+      failures = failures + (OS_File_Format() != 0);
+    } else if(strcmp(op, "flush") == 0){
+      failures = failures + (OS_File_Flush() != 0);
+    } else if(strcmp(op, "new") == 0){
+      if(i < 0){
+        i = findname(names, "");
+      }
+      if(i < 0){
+        printf("line %u: too many names\n", lineno);
+        return 1;
+      }
+      strcpy(names[i], name);
+      files[i] = OS_File_New();
+      failures = failures + (files[i] == EFILE_NULL);
+    } else if(i < 0){
+      printf("line %u: unknown name or operation: %s\n", lineno, line);
+      return 1;
+    } else if(strcmp(op, "append") == 0){
+      buildbuff(text);
+      memcpy((uint8_t *)Odd + 1, Buff, EDISK_SECTOR_SIZE);
+      failures = failures + (OS_File_Append(files[i], (uint8_t *)Odd + 1) != 0);
+      bytes = bytes + EDISK_SECTOR_SIZE;
+    } else if(strcmp(op, "write") == 0){
+      failures = failures + (OS_File_Write(files[i], (const uint8_t *)text, strlen(text)) != 0);
+      bytes = bytes + strlen(text);
+    } else if(strcmp(op, "read") == 0){
+      failures = failures + (OS_File_Read(files[i], atoi(text), Buff) != 0);
+    } else if(strcmp(op, "size") == 0){
+      printf("size %s = %u\n", name, OS_File_Size(files[i]));
+    } else{
+      printf("line %u: unknown operation %s\n", lineno, op);
+      return 1;
+    }
+  }
+  elapsed = seconds() - start;
+  fclose(in);
+  OS_File_Flush();
+  for(i=0; i<EFILE_NUM_FILES; i=i+1){
+    if(dirEntry(i) != EFILE_NULL){
+      walk(i, &breaks);
+      frags = frags + breaks;
+    }
+  }
+  n = 0;
+  for(i=0; i<EFILE_META_START; i=i+1){
+    n = n + !erased(i);
+  }
+  printf("%u operations, %u failed, %u bytes in %.3f ms (%.1f KB/s)\n",
+         ops, failures, bytes, 1000*elapsed, elapsed > 0 ? bytes/elapsed/1024 : 0);
+  printf("%u block erases, %u words programmed, %u of %u data sectors programmed\n",
+         FlashEraseCount, FlashWordCount, n, EFILE_META_START);
+  printf("%u fragment breaks across all files\n", frags);
+  return failures != 0;
+}
+
+static int bench(void){ uint16_t a, b;
+  uint32_t i, n, sum;
+  uint8_t record[12];
+  double start, walk, append;
+  uint16_t lastsector(uint16_t start);
+  uint16_t findfreesector(void);
+  extern uint16_t Directory[];
+  // 1) 200 appends to one file, chain walk against whole append
+  OS_File_Format();
+  a = OS_File_New();
+  buildbuff("bench");
+  walk = append = 0;
+  for(i=0; i<200; i=i+1){
+    start = seconds();
+    sum = lastsector(Directory[a]) + findfreesector();
+    walk = walk + seconds() - start;
+    start = seconds();
+    OS_File_Append(a, Buff);
+    append = append + seconds() - start;
+  }
+  printf("200 appends: chain walk %.2f us/append, OS_File_Append %.2f us/append\n",
+         1e6*walk/200, 1e6*append/200);
+  // 2) 12-byte records until the disk is full, stream against one
+  // sector per record, counting the 4 KB block erases of the format
+  FlashEraseCount = 0;
+  OS_File_Format();
+  a = OS_File_New();
+  n = 0;
+  do{
+    memset(record, n, sizeof(record));
+    record[0] = 0;
+    n = n + 1;
+  } while(OS_File_Write(a, record, sizeof(record)) == 0);
+  OS_File_Flush();
+  n = OS_File_Size(a)*EDISK_SECTOR_SIZE/sizeof(record); // records kept
+  printf("OS_File_Write: %u records, %u block erases, %.1f records per erase\n",
+         n, FlashEraseCount, (double)n/FlashEraseCount);
+  FlashEraseCount = 0;
+  OS_File_Format();
+  a = OS_File_New();
+  n = 0;
+  do{
+    buildbuff("");
+    memset(Buff, n, sizeof(record));
+    Buff[0] = 0;
+    n = n + 1;
+  } while(OS_File_Append(a, Buff) == 0);
+  OS_File_Flush();
+  n = OS_File_Size(a);
+  printf("OS_File_Append: %u records, %u block erases, %.1f records per erase\n",
+         n, FlashEraseCount, (double)n/FlashEraseCount);
+  // 3) read patterns on a 100-sector file interleaved with another
+  OS_File_Format();
+  a = OS_File_New();
+  b = a + 1;
+  for(i=0; i<100; i=i+1){
+    buildbuff("data");
+    OS_File_Append(a, Buff);
+    buildbuff("other");
+    OS_File_Append(b, Buff);
+  }
+  OS_File_Flush();
+  remount();
+  sum = 0;
+  start = seconds();
+  for(i=0; i<100; i=i+1){
+    OS_File_Read(a, i, Buff);
+    sum = sum + Buff[i];
+  }
+  walk = seconds() - start;
+  start = seconds();
+  for(i=0; i<100; i=i+1){
+    sum = sum + OS_File_Map(a, i)[i];
+  }
+  append = seconds() - start;
+  printf("sequential: OS_File_Read %.3f us/sector, OS_File_Map %.3f us/sector\n",
+         1e6*walk/100, 1e6*append/100);
+  srand(1);
+  start = seconds();
+  for(i=0; i<10000; i=i+1){
+    OS_File_Read(a, rand()%100, Buff);
+    sum = sum + Buff[0];
+  }
+  walk = seconds() - start;
+  srand(1);
+  start = seconds();
+  for(i=0; i<10000; i=i+1){
+    sum = sum + OS_File_Map(a, rand()%100)[0];
+  }
+  append = seconds() - start;
+  printf("random: OS_File_Read %.3f us/sector, OS_File_Map %.3f us/sector (%u)\n",
+         1e6*walk/10000, 1e6*append/10000, sum&1);
+  return 0;
+}
+
+int main(int argc, char **argv){ int result;
+  if((argc < 3) || ((strcmp(argv[1], "replay") == 0) && (argc < 4))){
+    fprintf(stderr, "usage: %s create|dump|fsck|bench IMAGE\n"
+                    "       %s replay IMAGE TRACE\n", argv[0], argv[0]);
+    return 2;
+  }
+  if(Flash_Open(argv[2]) != NOERROR){
+    fprintf(stderr, "%s: can not map at 0x%08x\n", argv[2], EDISK_ADDR_MIN);
+    return 1;
+  }
+  if(strcmp(argv[1], "create") == 0){
+    result = OS_File_Format();
+  } else if(strcmp(argv[1], "dump") == 0){
+    result = dump();
+  } else if(strcmp(argv[1], "fsck") == 0){
+    result = fsck();
+  } else if(strcmp(argv[1], "replay") == 0){
+    result = replay(argv[3]);
+  } else if(strcmp(argv[1], "bench") == 0){
+    result = bench();
+  } else{
+    fprintf(stderr, "unknown command %s\n", argv[1]);
+    result = 2;
+  }
+  Flash_Close();
+  return result;
+}
@@ -97,21 +97,21 @@
 
 // normally this access would be poor style,
 // but the access to internal data is used here for debugging
-extern uint8_t Buff[512];
-extern uint8_t Directory[256], FAT[256];
+extern uint8_t Buff[EDISK_SECTOR_SIZE];
+extern uint16_t Directory[EFILE_NUM_FILES], FAT[EDISK_NUM_SECTORS];
 
 // Test function: Copy a NULL-terminated 'inString' into the
-// 'Buff' global variable with a maximum of 512 characters.
+// 'Buff' global variable with a maximum of EDISK_SECTOR_SIZE characters.
 // Uninitialized characters are set to 0xFF.
 // Inputs:  inString  pointer to NULL-terminated character string
 // Outputs: none
 void testbuildbuff(char *inString){
   uint32_t i = 0;
-  while((i < 512) && (inString[i] != 0)){
+  while((i < EDISK_SECTOR_SIZE) && (inString[i] != 0)){
     Buff[i] = inString[i];
     i = i + 1;
   }
-  while(i < 512){
+  while(i < EDISK_SECTOR_SIZE){
     Buff[i] = 0xFF;             // fill the remainder of the buffer with 0xFF
     i = i + 1;
   }
@@ -130,29 +130,34 @@ const uint16_t ColorArray[COLORSIZE] = {LCD_YELLOW, LCD_BLUE, LCD_GREEN, LCD_RED
 // used for debugging
 // Input:  index is starting line number
 // Output: none
-void DisplayDirectory(uint8_t index){
-  uint16_t dirclr[256], fatclr[256];
-  volatile uint8_t *diraddr = (volatile uint8_t *)(EDISK_ADDR_MAX - 511); /* address of directory */
-  volatile uint8_t *fataddr = (volatile uint8_t *)(EDISK_ADDR_MAX - 255); /* address of FAT */
-  int i, j;
+#define NUMROWS ((EFILE_NUM_FILES > EDISK_NUM_SECTORS) ? EFILE_NUM_FILES : EDISK_NUM_SECTORS)
+uint16_t DirClr[EFILE_NUM_FILES], FatClr[EDISK_NUM_SECTORS];
+void DisplayDirectory(uint16_t index){
+  volatile uint16_t *diraddr = (volatile uint16_t *)(EDISK_ADDR_MIN + EDISK_SECTOR_SIZE*EFILE_META_START + EFILE_SUPER_SIZE); /* address of directory */
+  volatile uint16_t *fataddr = diraddr + EFILE_NUM_FILES; /* address of FAT */
+  int i, j, n;
   // set default color to gray
-  for(i=0; i<256; i=i+1){
-    dirclr[i] = LCD_GRAY;
-    fatclr[i] = LCD_GRAY;
+  for(i=0; i<EFILE_NUM_FILES; i=i+1){
+    DirClr[i] = LCD_GRAY;
+  }
+  for(i=0; i<EDISK_NUM_SECTORS; i=i+1){
+    FatClr[i] = LCD_GRAY;
   }
   // set color for each active file
-  for(i=0; i<255; i=i+1){
+  for(i=0; i<EFILE_NUM_FILES; i=i+1){
     j = diraddr[i];
-    if(j != 255){
-      dirclr[i] = ColorArray[i%COLORSIZE];
+    if(j != EFILE_NULL){
+      DirClr[i] = ColorArray[i%COLORSIZE];
     }
-    while(j != 255){
-      fatclr[j] = ColorArray[i%COLORSIZE];
+    n = 0;
+    while((j < EFILE_META_START) && (n < EFILE_META_START)){
+      FatClr[j] = ColorArray[i%COLORSIZE];
       j = fataddr[j];
+      n = n + 1;
     }
   }
   // clear the screen if necessary (very slow but helps with button bounce)
-  if((index + 11) > 255){
+  if((index + 11) > (NUMROWS - 1)){
     BSP_LCD_FillScreen(LCD_BLACK);
   }
   // print the column headers
@@ -160,22 +165,26 @@ void DisplayDirectory(uint8_t index){
   BSP_LCD_DrawString(15, 0, "FAT", LCD_GRAY);
   // print the cloumns
   i = 0;
-  while((i <= 11) && ((index + i) <= 255)){
-    BSP_LCD_SetCursor(0, i+1);
-    BSP_LCD_OutUDec4((uint32_t)(index + i), LCD_GRAY);
-    BSP_LCD_SetCursor(4, i+1);
-    BSP_LCD_OutUDec4((uint32_t)diraddr[index+i], dirclr[index+i]);
-    BSP_LCD_SetCursor(10, i+1);
-    BSP_LCD_OutUDec4((uint32_t)(index + i), LCD_GRAY);
-    BSP_LCD_SetCursor(14, i+1);
-    BSP_LCD_OutUDec4((uint32_t)fataddr[index+i], fatclr[index+i]);
+  while((i <= 11) && ((index + i) < NUMROWS)){
+    if((index + i) < EFILE_NUM_FILES){
+      BSP_LCD_SetCursor(0, i+1);
+      BSP_LCD_OutUDec4((uint32_t)(index + i), LCD_GRAY);
+      BSP_LCD_SetCursor(4, i+1);
+      BSP_LCD_OutUDec4((uint32_t)diraddr[index+i], DirClr[index+i]);
+    }
+    if((index + i) < EDISK_NUM_SECTORS){
+      BSP_LCD_SetCursor(10, i+1);
+      BSP_LCD_OutUDec4((uint32_t)(index + i), LCD_GRAY);
+      BSP_LCD_SetCursor(14, i+1);
+      BSP_LCD_OutUDec4((uint32_t)fataddr[index+i], FatClr[index+i]);
+    }
     i = i + 1;
   }
 }
 
 int main(void){
   uint8_t m, n, p;              // file numbers
-  uint8_t index = 0;            // row index
+  uint16_t index = 0;           // row index
   volatile int i;
   DisableInterrupts();
   BSP_Clock_InitFastest();
@@ -194,7 +203,8 @@ int main(void){
 // Logic analyzer will run, but the Lab 5 doesn't really use the logic analyzer
     BSP_LCD_DrawString(0, 0, "                    ", LCD_YELLOW);
   }
-  if(BSP_Button2_Input() == 0){ // erase if Button2 is pressed
+  // erase if Button2 is pressed, the disk was never formatted, or no file is left
+  if((BSP_Button2_Input() == 0) || (OS_File_New() == EFILE_NULL)){
     BSP_LCD_DrawString(0, 0, "Erasing entire disk", LCD_YELLOW);
     OS_File_Format();
     while(BSP_Button2_Input() == 0){};
@@ -244,7 +254,7 @@ int main(void){
   i = OS_File_Size(m);          // i = 5
   i = OS_File_Size(p);          // i = 3
   i = OS_File_Size(p+1);        // i = 0
-  OS_File_Flush();              // 0x0003FE00
+  OS_File_Flush();              // 0x0003FC00
   while(1){
     DisplayDirectory(index);
     while((BSP_Button1_Input() != 0) && (BSP_Button2_Input() != 0)){};
@@ -256,10 +266,208 @@ int main(void){
       }
     }
     if(BSP_Button2_Input() == 0){
-      if((index + 11) <= 255){
+      if((index + 11) < NUMROWS){
         index = index + 11;
       }
     }
     while((BSP_Button1_Input() == 0) || (BSP_Button2_Input() == 0)){};
   }
 }
+
+// Benchmark: append 200 sectors to one file and compare the
+// cost of walking the FAT chain (what appending used to cost
+// before any data was written) against the whole
+// OS_File_Append(), which now finds the tail and a free sector
+// in constant time.  The chain walk grows with the file; the
+// append stays flat and is dominated by the flash write.
+// This erases the disk.  Times are in bus cycles from SysTick.
+#define BENCHSECTORS 200
+uint16_t lastsector(uint16_t start);
+uint16_t findfreesector(void);
+uint32_t WalkCycles[BENCHSECTORS];   // lastsector() and findfreesector() before each append
+uint32_t AppendCycles[BENCHSECTORS]; // OS_File_Append() including the flash write
+int main_benchmark(void){
+  uint16_t n;
+  uint32_t before, i;
+  volatile uint16_t s;
+  DisableInterrupts();
+  BSP_Clock_InitFastest();
+  BSP_LCD_Init();
+  BSP_LCD_FillScreen(LCD_BLACK);
+  STCTRL = 0;                   // disable SysTick during setup
+  STRELOAD = 0x00FFFFFF;        // maximum reload value
+  STCURRENT = 0;                // any write to current clears it
+  STCTRL = 0x00000005;          // enable SysTick with no interrupts
+  BSP_LCD_DrawString(0, 0, "Erasing entire disk", LCD_YELLOW);
+  OS_File_Format();
+  n = OS_File_New();
+  testbuildbuff("bench");
+  for(i=0; i<BENCHSECTORS; i=i+1){
+    before = STCURRENT;
+    s = lastsector(Directory[n]);
+    s = findfreesector();
+    WalkCycles[i] = (before - STCURRENT)&0x00FFFFFF;
+    before = STCURRENT;
+    OS_File_Append(n, Buff);
+    AppendCycles[i] = (before - STCURRENT)&0x00FFFFFF;
+  }
+  OS_File_Flush();
+  BSP_LCD_DrawString(0, 0, "Sectors=            ", LCD_YELLOW);
+  BSP_LCD_SetCursor(8, 0); BSP_LCD_OutUDec((uint32_t)OS_File_Size(n), LCD_WHITE);
+  BSP_LCD_DrawString(0, 2, "Walk first", LCD_YELLOW);
+  BSP_LCD_SetCursor(11, 2); BSP_LCD_OutUDec(WalkCycles[0], LCD_WHITE);
+  BSP_LCD_DrawString(0, 3, "Walk last", LCD_YELLOW);
+  BSP_LCD_SetCursor(11, 3); BSP_LCD_OutUDec(WalkCycles[BENCHSECTORS-1], LCD_WHITE);
+  BSP_LCD_DrawString(0, 5, "App first", LCD_YELLOW);
+  BSP_LCD_SetCursor(11, 5); BSP_LCD_OutUDec(AppendCycles[0], LCD_WHITE);
+  BSP_LCD_DrawString(0, 6, "App last", LCD_YELLOW);
+  BSP_LCD_SetCursor(11, 6); BSP_LCD_OutUDec(AppendCycles[BENCHSECTORS-1], LCD_WHITE);
+  while(1){};
+}
+
+// Benchmark: log 12-byte sensor records until the disk is full,
+// first with OS_File_Write() and then one record per sector
+// with OS_File_Append(), and report how many record bytes each
+// method stores per erase of the disk (one format erases every
+// 4 KB block once).  This erases the disk.
+// OS_File_Write() drops the bytes still buffered when the disk
+// fills, so its records are counted from the sectors kept.
+#define RECORDSIZE 12
+uint32_t WriteRecords;       // records stored by OS_File_Write()
+uint32_t AppendRecords;      // records stored by OS_File_Append()
+uint32_t WriteUs, AppendUs;  // time to fill the disk in usec
+uint8_t WriteFlush, AppendFlush; // OS_File_Flush() results, 0 if ok
+int main_logbenchmark(void){
+  uint16_t n;
+  uint8_t record[RECORDSIZE];
+  uint32_t i, start;
+  DisableInterrupts();
+  BSP_Clock_InitFastest();
+  BSP_Time_Init();
+  BSP_LCD_Init();
+  BSP_LCD_FillScreen(LCD_BLACK);
+  BSP_LCD_DrawString(0, 0, "Logging records", LCD_YELLOW);
+  OS_File_Format();
+  n = OS_File_New();
+  WriteRecords = 0;
+  start = BSP_Time_Get();
+  do{
+    for(i=0; i<RECORDSIZE; i=i+1){
+      record[i] = WriteRecords + i;
+    }
+    record[0] = 0;              // records never start with 0xFF
+    WriteRecords = WriteRecords + 1;
+  } while(OS_File_Write(n, record, RECORDSIZE) == 0);
+  WriteFlush = OS_File_Flush();
+  WriteUs = BSP_Time_Get() - start;
+  WriteRecords = (OS_File_Size(n)*EDISK_SECTOR_SIZE)/RECORDSIZE;
+  OS_File_Format();
+  n = OS_File_New();
+  AppendRecords = 0;
+  start = BSP_Time_Get();
+  do{
+    testbuildbuff("");
+    for(i=0; i<RECORDSIZE; i=i+1){
+      Buff[i] = AppendRecords + i;
+    }
+    AppendRecords = AppendRecords + 1;
+  } while(OS_File_Append(n, Buff) == 0);
+  AppendFlush = OS_File_Flush();
+  AppendUs = BSP_Time_Get() - start;
+  AppendRecords = AppendRecords - 1;
+  BSP_LCD_DrawString(0, 0, "Bytes per erase     ", LCD_YELLOW);
+  BSP_LCD_DrawString(0, 1, "Write", LCD_YELLOW);
+  BSP_LCD_SetCursor(8, 1); BSP_LCD_OutUDec(WriteRecords*RECORDSIZE, LCD_WHITE);
+  BSP_LCD_DrawString(0, 2, "Append", LCD_YELLOW);
+  BSP_LCD_SetCursor(8, 2); BSP_LCD_OutUDec(AppendRecords*RECORDSIZE, LCD_WHITE);
+  BSP_LCD_DrawString(0, 4, "Time to fill (ms)", LCD_YELLOW);
+  BSP_LCD_DrawString(0, 5, "Write", LCD_YELLOW);
+  BSP_LCD_SetCursor(8, 5); BSP_LCD_OutUDec(WriteUs/1000, LCD_WHITE);
+  BSP_LCD_DrawString(0, 6, "Append", LCD_YELLOW);
+  BSP_LCD_SetCursor(8, 6); BSP_LCD_OutUDec(AppendUs/1000, LCD_WHITE);
+  BSP_LCD_DrawString(0, 8, "Flush", LCD_YELLOW);
+  BSP_LCD_DrawString(8, 8, WriteFlush ? "Write fail" : "ok", WriteFlush ? LCD_RED : LCD_WHITE);
+  BSP_LCD_DrawString(8, 9, AppendFlush ? "Append fail" : "ok", AppendFlush ? LCD_RED : LCD_WHITE);
+  while(1){};
+}
+
+// Benchmark: build a 100-sector file interleaved with another
+// file, then sum every byte with a sequential scan and with 1000
+// random sector reads, once copying each sector through
+// OS_File_Read() and once reading it in place with OS_File_Map().
+// This erases the disk.  Times are in usec.
+#define READSECTORS 100
+#define RANDOMREADS 1000
+uint32_t SeqReadUs, SeqMapUs, RandReadUs, RandMapUs;
+uint32_t ReadSum, MapSum;    // equal if both methods read the same data
+uint32_t static benchrandom(uint32_t *seed){
+  *seed = 1664525*(*seed) + 1013904223;
+  return (*seed)>>16;
+}
+int main_readbenchmark(void){
+  uint16_t n;
+  uint32_t i, j, k, start, seed;
+  const uint8_t *pt;
+  DisableInterrupts();
+  BSP_Clock_InitFastest();
+  BSP_Time_Init();
+  BSP_LCD_Init();
+  BSP_LCD_FillScreen(LCD_BLACK);
+  BSP_LCD_DrawString(0, 0, "Building file", LCD_YELLOW);
+  OS_File_Format();
+  n = OS_File_New();
+  for(i=0; i<READSECTORS; i=i+1){
+    testbuildbuff("data");
+    OS_File_Append(n, Buff);
+    testbuildbuff("other");
+    OS_File_Append(n+1, Buff);  // so the chain is not contiguous
+  }
+  OS_File_Flush();
+  ReadSum = 0;
+  start = BSP_Time_Get();
+  for(i=0; i<READSECTORS; i=i+1){
+    OS_File_Read(n, i, Buff);
+    for(j=0; j<EDISK_SECTOR_SIZE; j=j+1){
+      ReadSum = ReadSum + Buff[j];
+    }
+  }
+  SeqReadUs = BSP_Time_Get() - start;
+  MapSum = 0;
+  start = BSP_Time_Get();
+  for(i=0; i<READSECTORS; i=i+1){
+    pt = OS_File_Map(n, i);
+    for(j=0; j<EDISK_SECTOR_SIZE; j=j+1){
+      MapSum = MapSum + pt[j];
+    }
+  }
+  SeqMapUs = BSP_Time_Get() - start;
+  seed = 1;
+  start = BSP_Time_Get();
+  for(i=0; i<RANDOMREADS; i=i+1){
+    k = benchrandom(&seed)%READSECTORS;
+    OS_File_Read(n, k, Buff);
+    ReadSum = ReadSum + Buff[k%EDISK_SECTOR_SIZE];
+  }
+  RandReadUs = BSP_Time_Get() - start;
+  seed = 1;
+  start = BSP_Time_Get();
+  for(i=0; i<RANDOMREADS; i=i+1){
+    k = benchrandom(&seed)%READSECTORS;
+    pt = OS_File_Map(n, k);
+    MapSum = MapSum + pt[k%EDISK_SECTOR_SIZE];
+  }
+  RandMapUs = BSP_Time_Get() - start;
+  BSP_LCD_DrawString(0, 0, "Read time (us)      ", LCD_YELLOW);
+  BSP_LCD_DrawString(0, 1, "Seq read", LCD_YELLOW);
+  BSP_LCD_SetCursor(10, 1); BSP_LCD_OutUDec(SeqReadUs, LCD_WHITE);
+  BSP_LCD_DrawString(0, 2, "Seq map", LCD_YELLOW);
+  BSP_LCD_SetCursor(10, 2); BSP_LCD_OutUDec(SeqMapUs, LCD_WHITE);
+  BSP_LCD_DrawString(0, 3, "Rand read", LCD_YELLOW);
+  BSP_LCD_SetCursor(10, 3); BSP_LCD_OutUDec(RandReadUs, LCD_WHITE);
+  BSP_LCD_DrawString(0, 4, "Rand map", LCD_YELLOW);
+  BSP_LCD_SetCursor(10, 4); BSP_LCD_OutUDec(RandMapUs, LCD_WHITE);
+  if(ReadSum != MapSum){
+    BSP_LCD_DrawString(0, 6, "Data mismatch", LCD_RED);
+  }
+  while(1){};
+}
@@ -36,6 +36,10 @@
 #include "eDisk.h"
 #include "FlashProgram.h"
 
+// Flash_FastWrite() reads its source as words, so a burst from a
+// byte buffer that is not word aligned is copied here first
+uint32_t static Burst[EDISK_BURST_SIZE/4];
+
 //*************** eDisk_Init ***********
 // Initialize the interface between microcontroller and disk
 // Inputs: drive number (only drive 0 is supported)
@@ -54,9 +58,9 @@ enum DRESULT eDisk_Init(uint32_t drive){
 }
 
 //*************** eDisk_ReadSector ***********
-// Read 1 sector of 512 bytes from the disk, data goes to RAM
+// Read 1 sector of EDISK_SECTOR_SIZE bytes from the disk, data goes to RAM
 // Inputs: pointer to an empty RAM buffer
-//         sector number of disk to read: 0,1,2,...255
+//         sector number of disk to read: 0,1,2,...,EDISK_NUM_SECTORS-1
 // Outputs: result
 //  RES_OK        0: Successful
 //  RES_ERROR     1: R/W Error
@@ -65,19 +69,37 @@ enum DRESULT eDisk_Init(uint32_t drive){
 //  RES_PARERR    4: Invalid Parameter
 enum DRESULT eDisk_ReadSector(
     uint8_t *buff,     // Pointer to a RAM buffer into which to store
-    uint8_t sector){   // sector number to read from
-// starting ROM address of the sector is	EDISK_ADDR_MIN + 512*sector
-// return RES_PARERR if EDISK_ADDR_MIN + 512*sector > EDISK_ADDR_MAX
-// copy 512 bytes from ROM (disk) into RAM (buff)
-// **write this function**
-
+    uint16_t sector){  // sector number to read from
+  uint32_t addr;
+  int i;
+  if(sector >= EDISK_NUM_SECTORS){
+    return RES_PARERR;
+  }
+  addr = EDISK_ADDR_MIN + EDISK_SECTOR_SIZE*(uint32_t)sector;
+  for(i=0; i<EDISK_SECTOR_SIZE; i=i+1){
+    buff[i] = *(volatile uint8_t *)(addr + i);
+  }
   return RES_OK;
 }
 
+//*************** eDisk_Map ***********
+// Return the address of a sector for reading in place.  This
+// works because the internal flash is memory mapped; a disk
+// that is not memory mapped would return 0.
+// Inputs: sector number of disk: 0,1,2,...,EDISK_NUM_SECTORS-1
+// Outputs: pointer to EDISK_SECTOR_SIZE bytes of flash
+//          0 if the sector number is invalid
+const uint8_t *eDisk_Map(uint16_t sector){
+  if(sector >= EDISK_NUM_SECTORS){
+    return 0;
+  }
+  return (const uint8_t *)(EDISK_ADDR_MIN + EDISK_SECTOR_SIZE*(uint32_t)sector);
+}
+
 //*************** eDisk_WriteSector ***********
-// Write 1 sector of 512 bytes of data to the disk, data comes from RAM
+// Write 1 sector of EDISK_SECTOR_SIZE bytes of data to the disk, data comes from RAM
 // Inputs: pointer to RAM buffer with information
-//         sector number of disk to write: 0,1,2,...,255
+//         sector number of disk to write: 0,1,2,...,EDISK_NUM_SECTORS-1
 // Outputs: result
 //  RES_OK        0: Successful
 //  RES_ERROR     1: R/W Error
@@ -86,14 +108,52 @@ enum DRESULT eDisk_ReadSector(
 //  RES_PARERR    4: Invalid Parameter
 enum DRESULT eDisk_WriteSector(
     const uint8_t *buff,  // Pointer to the data to be written
-    uint8_t sector){      // sector number
-// starting ROM address of the sector is	EDISK_ADDR_MIN + 512*sector
-// return RES_PARERR if EDISK_ADDR_MIN + 512*sector > EDISK_ADDR_MAX
-// write 512 bytes from RAM (buff) into ROM (disk)
-// you can use Flash_FastWrite or Flash_WriteArray
-// **write this function**
- 
-      
+    uint16_t sector){     // sector number
+  enum DRESULT result;
+  uint16_t i;
+  for(i=0; i<EDISK_SECTOR_SIZE; i=i+EDISK_BURST_SIZE){
+    result = eDisk_WriteBurst(&buff[i], sector, i);
+    if(result != RES_OK){
+      return result;
+    }
+  }
+  return RES_OK;
+}
+
+//*************** eDisk_WriteBurst ***********
+// Write EDISK_BURST_SIZE bytes of data into part of a sector,
+// data comes from RAM.  The rest of the sector is unchanged, so
+// a sector can be filled one burst at a time.
+// Inputs: pointer to RAM buffer with information
+//         sector number of disk to write: 0,1,2,...,EDISK_NUM_SECTORS-1
+//         byte offset into the sector, multiple of EDISK_BURST_SIZE
+// Outputs: result
+//  RES_OK        0: Successful
+//  RES_ERROR     1: R/W Error
+//  RES_WRPRT     2: Write Protected
+//  RES_NOTRDY    3: Not Ready
+//  RES_PARERR    4: Invalid Parameter
+enum DRESULT eDisk_WriteBurst(
+    const uint8_t *buff,  // Pointer to the data to be written
+    uint16_t sector,      // sector number
+    uint16_t offset){     // byte offset into the sector
+  uint32_t addr, i;
+  uint32_t *source = (uint32_t *)buff;
+  if((sector >= EDISK_NUM_SECTORS) || (offset >= EDISK_SECTOR_SIZE) ||
+     ((offset%EDISK_BURST_SIZE) != 0)){
+    return RES_PARERR;
+  }
+  addr = EDISK_ADDR_MIN + EDISK_SECTOR_SIZE*(uint32_t)sector + offset;
+  if(((uintptr_t)buff)&3){
+    for(i=0; i<EDISK_BURST_SIZE; i=i+1){
+      ((uint8_t *)Burst)[i] = buff[i];
+    }
+    source = Burst;
+  }
+  // Flash_FastWrite() programs at most 16 words (64 bytes) per burst
+  if(Flash_FastWrite(source, addr, EDISK_BURST_SIZE/4) != EDISK_BURST_SIZE/4){
+    return RES_ERROR;
+  }
   return RES_OK;
 }
 
@@ -107,8 +167,11 @@ enum DRESULT eDisk_WriteSector(
 //  RES_NOTRDY    3: Not Ready
 //  RES_PARERR    4: Invalid Parameter
 enum DRESULT eDisk_Format(void){
-// erase all flash from EDISK_ADDR_MIN to EDISK_ADDR_MAX
-// **write this function**
-  
+  uint32_t addr;
+  for(addr=EDISK_ADDR_MIN; addr<EDISK_ADDR_MAX; addr=addr+4096){
+    if(Flash_Erase(addr) != NOERROR){
+      return RES_ERROR;
+    }
+  }
   return RES_OK;
 }
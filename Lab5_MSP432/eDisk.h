@@ -32,8 +32,24 @@
  http://users.ece.utexas.edu/~valvano/
  */
 
+#ifndef __EDISK_H
+#define __EDISK_H  1
+
+// The disk geometry may be overridden on the compiler command
+// line, e.g. for a smaller part of bank 1 or a larger external
+// flash.  Sector numbers are 16 bits, so the disk holds at most
+// 65,535 sectors; sector number 0xFFFF is never valid.
+#ifndef EDISK_ADDR_MIN
 #define EDISK_ADDR_MIN      0x00020000  // Flash Bank1 minimum address
+#endif
+#ifndef EDISK_ADDR_MAX
 #define EDISK_ADDR_MAX      0x0003FFFF  // Flash Bank1 maximum address
+#endif
+#ifndef EDISK_SECTOR_SIZE
+#define EDISK_SECTOR_SIZE   512         // bytes per sector: 256, 512 or 1024
+#endif
+#define EDISK_NUM_SECTORS   ((EDISK_ADDR_MAX - EDISK_ADDR_MIN + 1)/EDISK_SECTOR_SIZE)
+#define EDISK_BURST_SIZE    64          // bytes per flash program burst (16 words)
 
 enum DRESULT{
   RES_OK = 0,                 // Successful
@@ -52,9 +68,9 @@ enum DRESULT{
 enum DRESULT eDisk_Init(uint32_t drive);
 
 //*************** eDisk_ReadSector ***********
-// Read 1 sector of 512 bytes from the disk, data goes to RAM
+// Read 1 sector of EDISK_SECTOR_SIZE bytes from the disk, data goes to RAM
 // Inputs: pointer to an empty RAM buffer
-//         sector number of disk to read: 0,1,2,...255
+//         sector number of disk to read: 0,1,2,...,EDISK_NUM_SECTORS-1
 // Outputs: result
 //  RES_OK        0: Successful
 //  RES_ERROR     1: R/W Error
@@ -63,12 +79,21 @@ enum DRESULT eDisk_Init(uint32_t drive);
 //  RES_PARERR    4: Invalid Parameter
 enum DRESULT eDisk_ReadSector(
     uint8_t *buff,     // Pointer to a RAM buffer into which to store
-    uint8_t sector);   // sector number to read from
+    uint16_t sector);  // sector number to read from
+
+//*************** eDisk_Map ***********
+// Return the address of a sector for reading in place.  This
+// works because the internal flash is memory mapped; a disk
+// that is not memory mapped would return 0.
+// Inputs: sector number of disk: 0,1,2,...,EDISK_NUM_SECTORS-1
+// Outputs: pointer to EDISK_SECTOR_SIZE bytes of flash
+//          0 if the sector number is invalid
+const uint8_t *eDisk_Map(uint16_t sector);
 
 //*************** eDisk_WriteSector ***********
-// Write 1 sector of 512 bytes of data to the disk, data comes from RAM
+// Write 1 sector of EDISK_SECTOR_SIZE bytes of data to the disk, data comes from RAM
 // Inputs: pointer to RAM buffer with information
-//         sector number of disk to write: 0,1,2,...,255
+//         sector number of disk to write: 0,1,2,...,EDISK_NUM_SECTORS-1
 // Outputs: result
 //  RES_OK        0: Successful
 //  RES_ERROR     1: R/W Error
@@ -77,7 +102,25 @@ enum DRESULT eDisk_ReadSector(
 //  RES_PARERR    4: Invalid Parameter
 enum DRESULT eDisk_WriteSector(
     const uint8_t *buff,  // Pointer to the data to be written
-    uint8_t sector);      // sector number
+    uint16_t sector);     // sector number
+
+//*************** eDisk_WriteBurst ***********
+// Write EDISK_BURST_SIZE bytes of data into part of a sector,
+// data comes from RAM.  The rest of the sector is unchanged, so
+// a sector can be filled one burst at a time.
+// Inputs: pointer to RAM buffer with information
+//         sector number of disk to write: 0,1,2,...,EDISK_NUM_SECTORS-1
+//         byte offset into the sector, multiple of EDISK_BURST_SIZE
+// Outputs: result
+//  RES_OK        0: Successful
+//  RES_ERROR     1: R/W Error
+//  RES_WRPRT     2: Write Protected
+//  RES_NOTRDY    3: Not Ready
+//  RES_PARERR    4: Invalid Parameter
+enum DRESULT eDisk_WriteBurst(
+    const uint8_t *buff,  // Pointer to the data to be written
+    uint16_t sector,      // sector number
+    uint16_t offset);     // byte offset into the sector
 
 //*************** eDisk_Format ***********
 // Erase all files and all data by resetting the flash to all 1's
@@ -89,3 +132,5 @@ enum DRESULT eDisk_WriteSector(
 //  RES_NOTRDY    3: Not Ready
 //  RES_PARERR    4: Invalid Parameter
 enum DRESULT eDisk_Format(void);
+
+#endif
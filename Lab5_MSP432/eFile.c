@@ -5,133 +5,532 @@
 // September 13, 2016
 #include <stdint.h>
 #include "eDisk.h"
+#include "eFile.h"
 
-uint8_t Buff[512];
-uint8_t Directory[256], FAT[256];
+#define FREEWORDS ((EDISK_NUM_SECTORS + 31)/32)
+
+uint8_t Buff[EDISK_SECTOR_SIZE];
+uint16_t Directory[EFILE_NUM_FILES], FAT[EDISK_NUM_SECTORS];
 int32_t bDirectoryLoaded =0; // 0 means disk on ROM is complete, 1 means RAM version active
+uint8_t DirBuff[EDISK_SECTOR_SIZE]; // one metadata sector used by mount and flush
+// RAM-only tables, rebuilt from the Directory and FAT on every mount.
+// With these, append, new and size never walk a FAT chain.
+uint16_t Tail[EFILE_NUM_FILES]; // last sector of each file, EFILE_NULL if empty
+uint16_t Size[EFILE_NUM_FILES]; // number of sectors in each file
+uint32_t FreeMap[FREEWORDS];    // bit (n&31) of FreeMap[n>>5] is 1 if sector n is free
+uint16_t NextFile;           // lowest file number with no sectors, EFILE_NULL if none
+uint16_t NextFree;           // no sector below this one is free
+// OS_File_Write() collects bytes here until a whole burst can be programmed
+struct stream{
+  uint16_t File;             // file number, EFILE_NULL if this buffer is free
+  uint16_t Count;            // number of bytes waiting in Page
+  uint8_t Page[EDISK_BURST_SIZE];
+};
+typedef struct stream streamType;
+streamType Streams[EFILE_NUM_STREAMS];
+uint32_t NextVictim;         // buffer to reuse when all are busy
+uint16_t Fill[EFILE_NUM_FILES]; // bytes of the last sector already programmed
+// Recently resolved (file, location) to sector lookups, least
+// recently used entry is replaced.  Chains only grow at the end,
+// so an entry stays valid until the disk is formatted.
+struct cache{
+  uint16_t File;             // file number, EFILE_NULL if unused
+  uint16_t Location;         // logical sector within the file
+  uint16_t Sector;           // disk sector holding it
+  uint32_t Used;             // value of CacheClock when last used
+};
+typedef struct cache cacheType;
+cacheType Cache[EFILE_CACHE_SIZE];
+uint32_t CacheClock;
 // Return the larger of two integers.
-int16_t max(int16_t a, int16_t b){
+int32_t max(int32_t a, int32_t b){
   if(a > b){
     return a;
   }
   return b;
 }
+// mark sector n as used in the free bitmap
+void static markused(uint16_t n){
+  FreeMap[n>>5] &= ~(1u<<(n&31));
+}
+// Return byte i of the metadata byte stream described in eFile.h
+uint8_t static metabyte(uint32_t i){ uint32_t value;
+  if(i < EFILE_SUPER_SIZE){
+    switch(i/2){
+      case 0: value = EFILE_MAGIC&0xFFFF; break;
+      case 1: value = EFILE_MAGIC>>16; break;
+      case 2: value = EFILE_VERSION; break;
+      case 3: value = EDISK_SECTOR_SIZE; break;
+      case 4: value = EDISK_NUM_SECTORS; break;
+      case 5: value = EFILE_NUM_FILES; break;
+      case 6: value = EFILE_META_START; break;
+      default: value = 0xFFFF;
+    }
+  } else if(i < (EFILE_SUPER_SIZE + 2*EFILE_NUM_FILES)){
+    value = Directory[(i - EFILE_SUPER_SIZE)/2];
+  } else if(i < EFILE_META_SIZE){
+    value = FAT[(i - EFILE_SUPER_SIZE - 2*EFILE_NUM_FILES)/2];
+  } else{
+    return 0xFF;                // unused end of the last metadata sector
+  }
+  if(i&1){
+    return (value>>8)&0xFF;
+  }
+  return value&0xFF;
+}
+// Store byte i of the metadata byte stream into Directory or FAT
+// superblock bytes are checked by MountDirectory, not stored
+void static setmetabyte(uint32_t i, uint8_t data){ uint16_t *pt;
+  if(i < EFILE_SUPER_SIZE){
+    return;
+  } else if(i < (EFILE_SUPER_SIZE + 2*EFILE_NUM_FILES)){
+    pt = &Directory[(i - EFILE_SUPER_SIZE)/2];
+  } else if(i < EFILE_META_SIZE){
+    pt = &FAT[(i - EFILE_SUPER_SIZE - 2*EFILE_NUM_FILES)/2];
+  } else{
+    return;
+  }
+  if(i&1){
+    *pt = (*pt&0x00FF)|(data<<8);
+  } else{
+    *pt = (*pt&0xFF00)|data;
+  }
+}
 // if directory and FAT not loaded,
 // bring it into RAM from disk
-void MountDirectory(void){ 
-// if bDirectoryLoaded is 0, 
-//    read disk sector 255 and populate Directory and FAT
-//    set bDirectoryLoaded=1
-// if bDirectoryLoaded is 1, simply return
-// **write this function**
-
-  
+// build the tail pointer table, size table and free bitmap
+// a corrupted FAT chain is cut short after EDISK_NUM_SECTORS sectors
+// Outputs: 0 if successful
+// Errors:  255 if the disk was never formatted by OS_File_Format()
+//          or was formatted with a different layout
+uint8_t MountDirectory(void){ uint32_t i, j;
+  uint16_t s;
+  if(bDirectoryLoaded){
+    return 0;
+  }
+  for(i=0; i<EFILE_META_SECTORS; i=i+1){
+    if(eDisk_ReadSector(DirBuff, EFILE_META_START + i) != RES_OK){
+      return 255;
+    }
+    if(i == 0){                 // superblock must match exactly, so an erased
+      for(j=0; j<EFILE_SUPER_SIZE; j=j+1){ // (0xFF) or zeroed disk is rejected
+        if(DirBuff[j] != metabyte(j)){
+          return 255;           // not formatted, different version or geometry
+        }
+      }
+    }
+    for(j=0; j<EDISK_SECTOR_SIZE; j=j+1){
+      setmetabyte(EDISK_SECTOR_SIZE*i + j, DirBuff[j]);
+    }
+  }
+  for(i=0; i<FREEWORDS; i=i+1){
+    FreeMap[i] = 0xFFFFFFFF;    // all free
+  }
+  for(i=EFILE_META_START; i<32*FREEWORDS; i=i+1){
+    markused(i);                // metadata and sectors past the end
+  }
+  NextFile = EFILE_NULL;
+  for(i=0; i<EFILE_NUM_FILES; i=i+1){
+    Tail[i] = EFILE_NULL;
+    Size[i] = 0;
+    s = Directory[i];
+    while((s < EFILE_META_START) && (Size[i] < EFILE_META_START)){
+      markused(s);
+      Tail[i] = s;
+      Size[i] = Size[i] + 1;
+      s = FAT[s];
+    }
+    if((Size[i] == 0) && (NextFile == EFILE_NULL)){
+      NextFile = i;
+    }
+    Fill[i] = EDISK_SECTOR_SIZE; // OS_File_Write() starts a new sector
+  }
+  for(i=0; i<EFILE_NUM_STREAMS; i=i+1){
+    Streams[i].File = EFILE_NULL;
+    Streams[i].Count = 0;
+  }
+  NextVictim = 0;
+  for(i=0; i<EFILE_CACHE_SIZE; i=i+1){
+    Cache[i].File = EFILE_NULL;
+    Cache[i].Used = 0;
+  }
+  CacheClock = 0;
+  NextFree = 0;
+  bDirectoryLoaded = 1;
+  return 0;
 }
 
 // Return the index of the last sector in the file
 // associated with a given starting sector.
 // Note: This function will loop forever without returning
 // if the file has no end (i.e. the FAT is corrupted).
-uint8_t lastsector(uint8_t start){
-// **write this function**
-  
-	
-  return 0; // replace this line
+// OS_File_Append() uses Tail[] instead, this chain walk
+// is kept for debugging and for comparison.
+uint16_t lastsector(uint16_t start){
+  if(start == EFILE_NULL){
+    return EFILE_NULL;
+  }
+  while(FAT[start] != EFILE_NULL){
+    start = FAT[start];
+  }
+  return start;
 }
 
 // Return the index of the first free sector.
 // Note: This function will loop forever without returning
-// if a file has no end or if (Directory[255] != 255)
-// (i.e. the FAT is corrupted).
-uint8_t findfreesector(void){
-// **write this function**
-  
-  return 0; // replace this line
+// if a file has no end (i.e. the FAT is corrupted).
+// OS_File_Append() uses freesector() instead, this chain walk
+// is kept for debugging and for comparison.
+uint16_t findfreesector(void){
+  int32_t fs = -1;
+  uint16_t i = 0;
+  while((i < EFILE_NUM_FILES) && (Directory[i] != EFILE_NULL)){
+    fs = max(fs, lastsector(Directory[i]));
+    i = i + 1;
+  }
+  return fs + 1;
+}
+
+// Return the index of the lowest free sector in the bitmap.
+// Sectors are allocated in increasing order, so the search
+// starts at NextFree and takes constant time on average.
+// Outputs: sector number, EFILE_NULL if the disk is full
+uint16_t static freesector(void){ uint32_t word, bit;
+  word = NextFree>>5;
+  while((word < FREEWORDS) && (FreeMap[word] == 0)){
+    word = word + 1;
+  }
+  if(word == FREEWORDS){
+    return EFILE_NULL;          // disk full
+  }
+  bit = 0;
+  while((FreeMap[word]&(1u<<bit)) == 0){
+    bit = bit + 1;
+  }
+  NextFree = 32*word + bit;
+  return NextFree;
 }
 
 // Append a sector index 'n' at the end of file 'num'.
 // This helper function is part of OS_File_Append(), which
 // should have already verified that there is free space,
 // so it always returns 0 (successful).
-// Note: This function will loop forever without returning
-// if the file has no end (i.e. the FAT is corrupted).
-uint8_t appendfat(uint8_t num, uint8_t n){
-// **write this function**
-  
-	
-  return 0; // replace this line
+uint8_t appendfat(uint16_t num, uint16_t n){
+  if(Tail[num] == EFILE_NULL){
+    Directory[num] = n;         // first sector of the file
+  } else{
+    FAT[Tail[num]] = n;
+  }
+  Tail[num] = n;
+  Size[num] = Size[num] + 1;
+  markused(n);
+  if(num == NextFile){          // files are never deleted, so this only moves forward
+    while((NextFile < EFILE_NUM_FILES) && (Size[NextFile] != 0)){
+      NextFile = NextFile + 1;
+    }
+    if(NextFile == EFILE_NUM_FILES){
+      NextFile = EFILE_NULL;
+    }
+  }
+  return 0;
+}
+
+// Program the bytes waiting in a stream buffer as one burst
+// at the end of its file, padded with 0xFF.  A new sector is
+// added to the file when the last one is full.  On failure the
+// waiting bytes are dropped, so the buffer is empty either way.
+// Outputs: 0 if successful
+// Errors:  255 on failure or disk full
+uint8_t static programburst(streamType *st){ uint16_t num, n, i;
+  num = st->File;
+  if(st->Count == 0){
+    return 0;
+  }
+  if(Fill[num] >= EDISK_SECTOR_SIZE){
+    n = freesector();
+    if(n == EFILE_NULL){
+      st->Count = 0;
+      return 255;               // disk full
+    }
+    appendfat(num, n);
+    Fill[num] = 0;
+  }
+  for(i=st->Count; i<EDISK_BURST_SIZE; i=i+1){
+    st->Page[i] = 0xFF;         // padding, erased flash
+  }
+  if(eDisk_WriteBurst(st->Page, Tail[num], Fill[num]) != RES_OK){
+    Fill[num] = EDISK_SECTOR_SIZE; // do not program this sector again
+    st->Count = 0;
+    return 255;
+  }
+  Fill[num] = Fill[num] + EDISK_BURST_SIZE;
+  st->Count = 0;
+  return 0;
+}
+// Program any bytes waiting for file num
+// Outputs: 0 if successful
+// Errors:  255 on failure or disk full
+uint8_t static flushstream(uint16_t num){ int i;
+  for(i=0; i<EFILE_NUM_STREAMS; i=i+1){
+    if(Streams[i].File == num){
+      return programburst(&Streams[i]);
+    }
+  }
+  return 0;
+}
+// Return the stream buffer for file num, taking a free one
+// or emptying the oldest if this file does not have one yet
+// Outputs: pointer to the buffer, 0 on disk failure
+streamType static *getstream(uint16_t num){ int i;
+  streamType *st;
+  for(i=0; i<EFILE_NUM_STREAMS; i=i+1){
+    if(Streams[i].File == num){
+      return &Streams[i];
+    }
+  }
+  for(i=0; i<EFILE_NUM_STREAMS; i=i+1){
+    if(Streams[i].File == EFILE_NULL){
+      Streams[i].File = num;
+      Streams[i].Count = 0;
+      return &Streams[i];
+    }
+  }
+  st = &Streams[NextVictim];    // all busy, reuse round robin
+  NextVictim = (NextVictim + 1)%EFILE_NUM_STREAMS;
+  if(programburst(st)){
+    return 0;
+  }
+  st->File = num;
+  return st;
+}
+
+// Return the disk sector holding logical sector 'location' of
+// file 'num'.  The last sector comes from Tail[], others from
+// the cache.  On a miss the walk starts at the nearest cached
+// earlier location of the same file, so a sequential scan takes
+// one FAT step per sector instead of walking from the start.
+// Outputs: sector number, EFILE_NULL if no data
+uint16_t static resolvesector(uint16_t num, uint16_t location){ int i;
+  cacheType *best, *lru;
+  uint16_t s, at;
+  if(location >= Size[num]){
+    return EFILE_NULL;
+  }
+  if(location == Size[num] - 1){
+    return Tail[num];
+  }
+  CacheClock = CacheClock + 1;
+  best = 0;
+  lru = &Cache[0];
+  for(i=0; i<EFILE_CACHE_SIZE; i=i+1){
+    if((Cache[i].File == num) && (Cache[i].Location <= location)){
+      if(Cache[i].Location == location){
+        Cache[i].Used = CacheClock;
+        return Cache[i].Sector;   // hit
+      }
+      if((best == 0) || (Cache[i].Location > best->Location)){
+        best = &Cache[i];
+      }
+    }
+    if(Cache[i].Used < lru->Used){
+      lru = &Cache[i];
+    }
+  }
+  if(best){
+    s = best->Sector;
+    at = best->Location;
+  } else{
+    s = Directory[num];
+    at = 0;
+  }
+  while(at < location){
+    s = FAT[s];
+    at = at + 1;
+  }
+  lru->File = num;
+  lru->Location = location;
+  lru->Sector = s;
+  lru->Used = CacheClock;
+  return s;
 }
 
 //********OS_File_New*************
 // Returns a file number of a new file for writing
 // Inputs: none
 // Outputs: number of a new file
-// Errors: return 255 on failure or disk full
-uint8_t OS_File_New(void){
-// **write this function**
-
-  return 255;
+// Errors: return EFILE_NULL on failure or disk full
+//         (255 when stored in an 8-bit variable)
+uint16_t OS_File_New(void){
+  if(MountDirectory()){
+    return EFILE_NULL;
+  }
+  return NextFile;
 }
 
 //********OS_File_Size*************
 // Check the size of this file
-// Inputs:  num, 8-bit file number, 0 to 254
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
 // Outputs: 0 if empty, otherwise the number of sectors
 // Errors:  none
-uint8_t OS_File_Size(uint8_t num){
-// **write this function**
-  
-	
-  return 0; // replace this line
+uint16_t OS_File_Size(uint16_t num){
+  if((num >= EFILE_NUM_FILES) || MountDirectory()){
+    return 0;
+  }
+  return Size[num];
 }
 
 //********OS_File_Append*************
-// Save 512 bytes into the file
-// Inputs:  num, 8-bit file number, 0 to 254
-//          buf, pointer to 512 bytes of data
+// Save EDISK_SECTOR_SIZE bytes into the file
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
+//          buf, pointer to EDISK_SECTOR_SIZE bytes of data
 // Outputs: 0 if successful
 // Errors:  255 on failure or disk full
-uint8_t OS_File_Append(uint8_t num, uint8_t buf[512]){
-// **write this function**
-  
-  return 0; // replace this line
+uint8_t OS_File_Append(uint16_t num, uint8_t buf[EDISK_SECTOR_SIZE]){ uint16_t n;
+  if((num >= EFILE_NUM_FILES) || MountDirectory()){
+    return 255;
+  }
+  if(flushstream(num)){         // keep earlier OS_File_Write() bytes in order
+    return 255;
+  }
+  n = freesector();
+  if(n == EFILE_NULL){
+    return 255;                 // disk full
+  }
+  if(eDisk_WriteSector(buf, n) != RES_OK){
+    return 255;
+  }
+  Fill[num] = EDISK_SECTOR_SIZE;
+  return appendfat(num, n);
+}
+
+//********OS_File_Write*************
+// Save any number of bytes at the end of the file
+// Bytes are collected in a RAM buffer and programmed into the
+// last sector of the file EDISK_BURST_SIZE bytes at a time, so
+// small records pack densely.  OS_File_Flush() programs a
+// partly full buffer padded with 0xFF; a remount or
+// OS_File_Append() starts the next bytes in a new sector.
+// Readers should skip 0xFF padding, so records should not
+// start with 0xFF.  When the disk fills, the bytes waiting in
+// the buffer are dropped and the rest of len is not written.
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
+//          ptr, pointer to the data
+//          len, number of bytes
+// Outputs: 0 if successful
+// Errors:  255 on failure or disk full
+uint8_t OS_File_Write(uint16_t num, const uint8_t *ptr, uint32_t len){
+  streamType *st;
+  if((num >= EFILE_NUM_FILES) || MountDirectory()){
+    return 255;
+  }
+  st = getstream(num);
+  if(st == 0){
+    return 255;
+  }
+  while(len > 0){
+    st->Page[st->Count] = *ptr;
+    st->Count = st->Count + 1;
+    ptr = ptr + 1;
+    len = len - 1;
+    if(st->Count == EDISK_BURST_SIZE){
+      if(programburst(st)){
+        return 255;
+      }
+    }
+  }
+  return 0;
 }
 
 //********OS_File_Read*************
-// Read 512 bytes from the file
-// Inputs:  num, 8-bit file number, 0 to 254
-//          location, logical address, 0 to 254
-//          buf, pointer to 512 empty spaces in RAM
+// Read EDISK_SECTOR_SIZE bytes from the file
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
+//          location, logical address, 0 to EFILE_META_START-1
+//          buf, pointer to EDISK_SECTOR_SIZE empty spaces in RAM
 // Outputs: 0 if successful
 // Errors:  255 on failure because no data
-uint8_t OS_File_Read(uint8_t num, uint8_t location,
-                     uint8_t buf[512]){
-// **write this function**
-  
-  return 0; // replace this line
+uint8_t OS_File_Read(uint16_t num, uint16_t location,
+                     uint8_t buf[EDISK_SECTOR_SIZE]){ uint16_t s;
+  if((num >= EFILE_NUM_FILES) || MountDirectory()){
+    return 255;
+  }
+  s = resolvesector(num, location);
+  if(s == EFILE_NULL){
+    return 255;                 // no data
+  }
+  if(eDisk_ReadSector(buf, s) != RES_OK){
+    return 255;
+  }
+  return 0;
+}
+
+//********OS_File_Map*************
+// Return the address of one sector of the file in flash, so it
+// can be read in place without copying.  Bytes still waiting
+// in an OS_File_Write() buffer are not there until flushed.
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
+//          location, logical address, 0 to EFILE_META_START-1
+// Outputs: pointer to EDISK_SECTOR_SIZE bytes
+// Errors:  0 on failure because no data
+const uint8_t *OS_File_Map(uint16_t num, uint16_t location){ uint16_t s;
+  if((num >= EFILE_NUM_FILES) || MountDirectory()){
+    return 0;
+  }
+  s = resolvesector(num, location);
+  if(s == EFILE_NULL){
+    return 0;                   // no data
+  }
+  return eDisk_Map(s);
 }
 
 //********OS_File_Flush*************
-// Update working buffers onto the disk
+// Update working buffers onto the disk, including partly full
+// OS_File_Write() buffers
 // Power can be removed after calling flush
+// The directory and FAT are always written, so every sector
+// programmed so far is kept even if a buffer could not be.
 // Inputs:  none
 // Outputs: 0 if success
-// Errors:  255 on disk write failure
-uint8_t OS_File_Flush(void){
-// **write this function**
-
-  return 0; // replace this line
+// Errors:  255 on disk write failure or disk full, the bytes
+//          still waiting in OS_File_Write() buffers are lost
+uint8_t OS_File_Flush(void){ uint32_t i, j;
+  uint8_t result = 0;
+  if(bDirectoryLoaded == 0){
+    return 0;                   // nothing changed since the last mount
+  }
+  for(i=0; i<EFILE_NUM_STREAMS; i=i+1){
+    if(programburst(&Streams[i])){
+      result = 255;             // drop this tail, keep the rest
+    }
+  }
+  for(i=0; i<EFILE_META_SECTORS; i=i+1){
+    for(j=0; j<EDISK_SECTOR_SIZE; j=j+1){
+      DirBuff[j] = metabyte(EDISK_SECTOR_SIZE*i + j);
+    }
+    if(eDisk_WriteSector(DirBuff, EFILE_META_START + i) != RES_OK){
+      return 255;
+    }
+  }
+  return result;
 }
 
 //********OS_File_Format*************
-// Erase all files and all data
+// Erase all files and all data, then write the superblock
 // Inputs:  none
 // Outputs: 0 if success
 // Errors:  255 on disk write failure
-uint8_t OS_File_Format(void){
-// call eDiskFormat
-// clear bDirectoryLoaded to zero
-// **write this function**
-
-  return 0; // replace this line
+uint8_t OS_File_Format(void){ uint32_t j;
+  bDirectoryLoaded = 0;         // next access will mount the empty disk
+  if(eDisk_Format() != RES_OK){
+    return 255;
+  }
+  for(j=0; j<EDISK_SECTOR_SIZE; j=j+1){
+    DirBuff[j] = 0xFF;          // empty directory and FAT
+  }
+  for(j=0; j<EFILE_SUPER_SIZE; j=j+1){
+    DirBuff[j] = metabyte(j);
+  }
+  if(eDisk_WriteSector(DirBuff, EFILE_META_START) != RES_OK){
+    return 255;
+  }
+  return 0;
 }
@@ -4,49 +4,113 @@
 // Daniel and Jonathan Valvano
 // September 13, 2016
 
+#include "eDisk.h"
+
+// On-disk layout, version 1
+// Sectors 0 to EFILE_META_START-1 hold file data.  The last
+// EFILE_META_SECTORS sectors hold, as one byte stream:
+//   16-byte superblock (little endian)
+//     0 magic "eFS1" 0x31534665    8 number of sectors
+//     4 version 1                   10 number of files
+//     6 sector size in bytes        12 EFILE_META_START
+//                                   14 0xFFFF
+//   Directory, 16-bit first sector of each file
+//   FAT, 16-bit next sector of each sector
+// EFILE_NULL (erased flash) marks an empty file or the end of a chain.
+// OS_File_Format() writes the superblock; a disk whose superblock
+// does not match byte for byte, including an erased one, does not mount.
+#ifndef EFILE_NUM_FILES
+#define EFILE_NUM_FILES     248         // superblock, directory and FAT fill two 512-byte sectors
+#endif
+#ifndef EFILE_NUM_STREAMS
+#define EFILE_NUM_STREAMS   4           // files with an OS_File_Write() buffer at once
+#endif
+#ifndef EFILE_CACHE_SIZE
+#define EFILE_CACHE_SIZE    8           // remembered (file, location) to sector lookups
+#endif
+#define EFILE_NULL          0xFFFF      // no sector, no file
+#define EFILE_MAGIC         0x31534665  // "eFS1"
+#define EFILE_VERSION       1
+#define EFILE_SUPER_SIZE    16
+#define EFILE_META_SIZE     (EFILE_SUPER_SIZE + 2*EFILE_NUM_FILES + 2*EDISK_NUM_SECTORS)
+#define EFILE_META_SECTORS  ((EFILE_META_SIZE + EDISK_SECTOR_SIZE - 1)/EDISK_SECTOR_SIZE)
+#define EFILE_META_START    (EDISK_NUM_SECTORS - EFILE_META_SECTORS)
 
 //********OS_File_New*************
 // Returns a file number of a new file for writing
 // Inputs: none
 // Outputs: number of a new file
-// Errors: return 255 on failure or disk full
-uint8_t OS_File_New(void);
+// Errors: return EFILE_NULL on failure or disk full
+//         (255 when stored in an 8-bit variable)
+uint16_t OS_File_New(void);
 
 //********OS_File_Size*************
 // Check the size of this file
-// Inputs:  num, 8-bit file number, 0 to 254
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
 // Outputs: 0 if empty, otherwise the number of sectors
 // Errors:  none
-uint8_t OS_File_Size(uint8_t num);
+uint16_t OS_File_Size(uint16_t num);
 
 //********OS_File_Append*************
-// Save 512 bytes into the file
-// Inputs:  num, 8-bit file number, 0 to 254
-//          buf, pointer to 512 bytes of data
+// Save EDISK_SECTOR_SIZE bytes into the file
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
+//          buf, pointer to EDISK_SECTOR_SIZE bytes of data
+// Outputs: 0 if successful
+// Errors:  255 on failure or disk full
+uint8_t OS_File_Append(uint16_t num, uint8_t buf[EDISK_SECTOR_SIZE]);
+
+//********OS_File_Write*************
+// Save any number of bytes at the end of the file
+// Bytes are collected in a RAM buffer and programmed into the
+// last sector of the file EDISK_BURST_SIZE bytes at a time, so
+// small records pack densely.  OS_File_Flush() programs a
+// partly full buffer padded with 0xFF; a remount or
+// OS_File_Append() starts the next bytes in a new sector.
+// Readers should skip 0xFF padding, so records should not
+// start with 0xFF.  When the disk fills, the bytes waiting in
+// the buffer are dropped and the rest of len is not written.
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
+//          ptr, pointer to the data
+//          len, number of bytes
 // Outputs: 0 if successful
 // Errors:  255 on failure or disk full
-uint8_t OS_File_Append(uint8_t num, uint8_t buf[512]);
+uint8_t OS_File_Write(uint16_t num, const uint8_t *ptr, uint32_t len);
 
 //********OS_File_Read*************
-// Read 512 bytes from the file
-// Inputs:  num, 8-bit file number, 0 to 254
-//          location, logical address, 0 to 254
-//          buf, pointer to 512 empty spaces in RAM
+// Read EDISK_SECTOR_SIZE bytes from the file
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
+//          location, logical address, 0 to EFILE_META_START-1
+//          buf, pointer to EDISK_SECTOR_SIZE empty spaces in RAM
 // Outputs: 0 if successful
 // Errors:  255 on failure because no data
-uint8_t OS_File_Read(uint8_t num, uint8_t location,
-                     uint8_t buf[512]);
+uint8_t OS_File_Read(uint16_t num, uint16_t location,
+                     uint8_t buf[EDISK_SECTOR_SIZE]);
+
+//********OS_File_Map*************
+// Return the address of one sector of the file in flash, so it
+// can be read in place without copying.  Bytes still waiting
+// in an OS_File_Write() buffer are not there until flushed.
+// Inputs:  num, file number, 0 to EFILE_NUM_FILES-1
+//          location, logical address, 0 to EFILE_META_START-1
+// Outputs: pointer to EDISK_SECTOR_SIZE bytes
+// Errors:  0 on failure because no data
+const uint8_t *OS_File_Map(uint16_t num, uint16_t location);
 
 //********OS_File_Flush*************
-// Update working buffers onto the disk
+// Update working buffers onto the disk, including partly full
+// OS_File_Write() buffers
 // Power can be removed after calling flush
+// The directory and FAT are always written, so every sector
+// programmed so far is kept even if a buffer could not be.
 // Inputs:  none
 // Outputs: 0 if success
-// Errors:  255 on disk write failure
+// Errors:  255 on disk write failure or disk full, the bytes
+//          still waiting in OS_File_Write() buffers are lost
 uint8_t OS_File_Flush(void);
 
 //********OS_File_Format*************
-// Erase all files and all data
+// Erase all files and all data, then write the superblock
+// A disk must be formatted once before it can be used
 // Inputs:  none
 // Outputs: 0 if success
 // Errors:  255 on disk write failure
@@ -28,25 +28,40 @@
         .align 2
         .global  RunPt            ; currently running thread
         .global  StartOS
-        .global  SysTick_Handler
+        .global  PendSV_Handler
+        .global  Scheduler
 
 RunPtAddr .field RunPt,32
-SysTick_Handler:  .asmfunc     ; 1) Saves R0-R3,R12,LR,PC,PSR
+; pended by SysTick_Handler in os.c
+; LR holds EXC_RETURN, bit 4 is 0 if the thread has used the FPU,
+; then the hardware reserved S0-S15,FPSCR in the frame (lazy stacking)
+PendSV_Handler:  .asmfunc       ; 1) Saves R0-R3,R12,LR,PC,PSR
     CPSID   I                  ; 2) Prevent interrupt during switch
+    TST     LR, #0x10          ;    thread used the FPU?
+    IT      EQ
+    VPUSHEQ {S16-S31}          ;    yes, save S16-S31, also stacks S0-S15
     PUSH    {R4-R11}           ; 3) Save remaining regs r4-11
     LDR     R0, RunPtAddr      ; 4) R0=pointer to RunPt, old thread
     LDR     R1, [R0]           ;    R1 = RunPt
     STR     SP, [R1]           ; 5) Save SP into TCB
-    LDR     R1, [R1,#4]        ; 6) R1 = RunPt->next
-    STR     R1, [R0]           ;    RunPt = R1
+    STR     LR, [R1,#4]        ;    RunPt->ExcReturn = LR
+    PUSH    {R0,LR}
+    BL      Scheduler
+    POP     {R0,LR}
     LDR     R1, [R0]           ; 6) R1 = RunPt, new thread
     LDR     SP, [R1]           ; 7) new thread SP; SP = RunPt->sp;
+    LDR     LR, [R1,#4]        ;    LR = RunPt->ExcReturn
     POP     {R4-R11}           ; 8) restore regs r4-11
+    TST     LR, #0x10          ;    new thread used the FPU?
+    IT      EQ
+    VPOPEQ  {S16-S31}          ;    yes, restore S16-S31
     CPSIE   I                  ; 9) tasks run with interrupts enabled
-    BX      LR                 ; 10) restore R0-R3,R12,LR,PC,PSR
+    BX      LR                 ; 10) restore R0-R3,R12,LR,PC,PSR,(S0-S15,FPSCR)
 
        .endasmfunc
 StartOS: .asmfunc
+    MOV     R0, #0             ; CONTROL.FPCA=0, main's FPU state is not
+    MSR     CONTROL, R0        ; part of the first thread's context
     LDR     R0, RunPtAddr      ; currently running thread
     LDR     R2, [R0]           ; R2 = value of RunPt
     LDR     SP, [R2]           ; new thread SP; SP = RunPt->stackPointer;
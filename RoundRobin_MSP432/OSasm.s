@@ -0,0 +1,79 @@
+;/*****************************************************************************/
+; OSasm.s: low-level OS commands, written in assembly                       */
+; Runs on LM4F120/TM4C123/MSP432
+; A very simple real time operating system with minimal features.
+; Daniel Valvano
+; February 8, 2016
+;
+; This example accompanies the book
+;   "Embedded Systems: Real Time Interfacing to ARM Cortex M Microcontrollers",
+;   ISBN: 978-1463590154, Jonathan Valvano, copyright (c) 2016
+;   "Embedded Systems: Real-Time Operating Systems for ARM Cortex-M Microcontrollers",
+;   ISBN: 978-1466468863, , Jonathan Valvano, copyright (c) 2016;
+;  Programs 4.4 through 4.12, section 4.2
+;
+;Copyright 2016 by Jonathan W. Valvano, valvano@mail.utexas.edu
+;    You may use, edit, run or distribute this file
+;    as long as the above copyright notice remains
+; THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED
+; OR STATUTORY, INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF
+; MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.
+; VALVANO SHALL NOT, IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL,
+; OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+; For more information about my classes, my research, and my books, see
+; http://users.ece.utexas.edu/~valvano/
+; */
+
+        AREA |.text|, CODE, READONLY, ALIGN=2
+        THUMB
+        REQUIRE8
+        PRESERVE8
+
+        EXTERN  RunPt            ; currently running thread
+        EXPORT  StartOS
+        EXPORT  PendSV_Handler
+        IMPORT  Scheduler
+
+
+
+
+PendSV_Handler                 ; 1) Saves R0-R3,R12,LR,PC,PSR
+    CPSID   I                  ; 2) Prevent interrupt during switch
+    TST     LR, #0x10          ;    thread used the FPU?
+    IT      EQ
+    VPUSHEQ {S16-S31}          ;    yes, save S16-S31, also stacks S0-S15
+    PUSH    {R4-R11}           ; 3) Save remaining regs r4-11
+    LDR     R0, =RunPt         ; 4) R0=pointer to RunPt, old thread
+    LDR     R1, [R0]           ;    R1 = RunPt
+    STR     SP, [R1]           ; 5) Save SP into TCB
+    STR     LR, [R1,#4]        ;    RunPt->ExcReturn = LR
+    PUSH    {R0,LR}
+    BL      Scheduler
+    POP     {R0,LR}
+    LDR     R1, [R0]           ; 6) R1 = RunPt, new thread
+    LDR     SP, [R1]           ; 7) new thread SP; SP = RunPt->sp;
+    LDR     LR, [R1,#4]        ;    LR = RunPt->ExcReturn
+    POP     {R4-R11}           ; 8) restore regs r4-11
+    TST     LR, #0x10          ;    new thread used the FPU?
+    IT      EQ
+    VPOPEQ  {S16-S31}          ;    yes, restore S16-S31
+    CPSIE   I                  ; 9) tasks run with interrupts enabled
+    BX      LR                 ; 10) restore R0-R3,R12,LR,PC,PSR,(S0-S15,FPSCR)
+
+StartOS
+    MOV     R0, #0             ; CONTROL.FPCA=0, main's FPU state is not
+    MSR     CONTROL, R0        ; part of the first thread's context
+    LDR     R0, =RunPt         ; currently running thread
+    LDR     R2, [R0]           ; R2 = value of RunPt
+    LDR     SP, [R2]           ; new thread SP; SP = RunPt->stackPointer;
+    POP     {R4-R11}           ; restore regs r4-11
+    POP     {R0-R3}            ; restore regs r0-3
+    POP     {R12}
+    ADD     SP,SP,#4           ; discard LR from initial stack
+    POP     {LR}               ; start location
+    ADD     SP,SP,#4           ; discard PSR
+    CPSIE   I                  ; Enable interrupts at processor level
+    BX      LR                 ; start first thread
+
+    ALIGN
+    END
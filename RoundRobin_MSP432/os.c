@@ -36,6 +36,7 @@ void StartOS(void);
 #define STACKSIZE   100      // number of 32-bit words in stack
 struct tcb{
   int32_t *sp;       // pointer to stack (valid for threads not running
+  uint32_t ExcReturn;// EXC_RETURN, bit 4 is 0 if S16-S31 are on the stack
   struct tcb *next;  // linked-list pointer
 };
 typedef struct tcb tcbType;
@@ -55,6 +56,7 @@ void OS_Init(void){
 
 void SetInitialStack(int i){
   tcbs[i].sp = &Stacks[i][STACKSIZE-16]; // thread stack pointer
+  tcbs[i].ExcReturn = 0xFFFFFFF9;        // thread mode, MSP, no FPU state
   Stacks[i][STACKSIZE-1] = 0x01000000;   // thumb bit
   Stacks[i][STACKSIZE-3] = 0x14141414;   // R14
   Stacks[i][STACKSIZE-4] = 0x12121212;   // R12
@@ -104,11 +106,20 @@ int OS_AddThreads(void(*task0)(void),
 void OS_Launch(uint32_t theTimeSlice){
   STCTRL = 0;                  // disable SysTick during setup
   STCURRENT = 0;               // any write to current clears it
-  SYSPRI3 =(SYSPRI3&0x00FFFFFF)|0xE0000000; // priority 7
+  SYSPRI3 =(SYSPRI3&0x0000FFFF)|0xC0E00000; // SysTick priority 6, PendSV priority 7
   STRELOAD = theTimeSlice - 1; // reload value
   STCTRL = 0x00000007;         // enable, core clock and interrupt arm
+  FPCCR |= 0xC0000000;         // ASPEN, LSPEN lazy stacking of S0-S15,FPSCR
   StartOS();                   // start on the first task
 }
+// SysTick ends the time slice and pends the switch; PendSV runs it
+// at the lowest priority, after any other ISR has finished
+void SysTick_Handler(void){ // every time slice
+  if(RunPt->next != RunPt){
+    INTCTRL = 0x10000000; // trigger PendSV, time slice expired
+  }
+}
+// called from PendSV_Handler in osasm
 void Scheduler(void){
   RunPt = RunPt->next;    // Round Robin
 }
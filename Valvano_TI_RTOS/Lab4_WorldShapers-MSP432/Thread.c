@@ -0,0 +1,132 @@
+// Thread.c
+// Runs on MSP432 or a host computer
+// Thread control blocks and stack memory for the Lab 4 kernel.
+// Free TCBs are kept on a stack, and stacks come from a pool of
+// fixed-size blocks in a few size classes (like Heap.c), so
+// creating and killing a thread take constant time.
+// Running threads are in a circular doubly linked list, so a
+// thread can be removed without searching for its predecessor.
+// The kernel calls these with interrupts disabled.
+
+#include <stdint.h>
+#include "Thread.h"
+
+tcbType Tcbs[NUMTHREADS];
+tcbType static *FreeTcb;   // top of the free TCB stack, linked by next
+// A free stack block links to the next one in its lowest word above
+// the guard.  With STACKMPU the guard words of the running thread are
+// no access, and OS_Kill releases the stack it is running on.
+#define FREELINK(pt) (*(int32_t **)((pt)+STACKGUARD))
+
+// 14 kbytes of stacks; the default STACKSIZE uses the middle class
+// 64-bit elements keep every block on a double word boundary
+// the MPU guard region must be aligned to its 32-byte size
+#if STACKMPU
+#pragma DATA_ALIGN(Stacks64, 32)
+#pragma DATA_ALIGN(Stacks128, 32)
+#pragma DATA_ALIGN(Stacks256, 32)
+#endif
+int64_t static Stacks64[8*64/2];
+int64_t static Stacks128[20*128/2];
+int64_t static Stacks256[2*256/2];
+stackClassType StackClass[STACKCLASSES] = {
+  { 64,  8, (int32_t *)Stacks64,  0, 0},
+  {128, 20, (int32_t *)Stacks128, 0, 0},
+  {256,  2, (int32_t *)Stacks256, 0, 0}
+};
+
+//------------Thread_Init------------
+// Put all TCBs on the free TCB stack and all stack blocks
+// on the free list of their class.
+// Input: none
+// Output: none
+void Thread_Init(void){ int i, c;
+  int32_t *pt;
+  FreeTcb = 0;
+  for(i=NUMTHREADS-1; i>=0; i--){
+    Tcbs[i].Id = 0;           // free
+    Tcbs[i].next = FreeTcb;   // Tcbs[0] is on top
+    FreeTcb = &Tcbs[i];
+  }
+  for(c=0; c<STACKCLASSES; c++){
+    pt = StackClass[c].FreePt = StackClass[c].Memory;
+    for(i=1; i<StackClass[c].Num; i++){
+      FREELINK(pt) = pt+StackClass[c].Size; // link to next free block
+      pt = pt + StackClass[c].Size;
+    }
+    FREELINK(pt) = 0;        // the last free block points to 0
+    StackClass[c].Used = 0;
+  }
+}
+
+//------------Thread_Allocate------------
+// Take a free TCB and a stack of at least the requested size,
+// from the smallest class that fits and has a free block.
+// Input: stackSize number of 32-bit words needed
+// Output: TCB with Stack, StackSize and StackClass set,
+//         or 0 if no TCB or no large enough stack is free
+tcbType *Thread_Allocate(uint32_t stackSize){ int c;
+  tcbType *pt;
+  stackClassType *cl;
+  pt = FreeTcb;
+  if(pt == 0){
+    return 0;                 // all TCBs in use
+  }
+  for(c=0; c<STACKCLASSES; c++){
+    cl = &StackClass[c];
+    if((cl->Size >= stackSize)&&(cl->FreePt)){
+      FreeTcb = pt->next;     // pop TCB
+      pt->Stack = cl->FreePt; // pop stack block
+      cl->FreePt = FREELINK(cl->FreePt);
+      cl->Used++;
+      pt->StackSize = cl->Size;
+      pt->StackClass = c;
+      return pt;
+    }
+  }
+  return 0;                   // no stack large enough
+}
+
+//------------Thread_Release------------
+// Return a TCB and its stack to the free lists, and mark
+// the TCB free.  The stack is reused by a later Thread_Allocate,
+// so a thread may release itself as long as it switches away
+// before any other thread is created.
+// Input: pt TCB from Thread_Allocate, not in the list
+// Output: none
+void Thread_Release(tcbType *pt){
+  stackClassType *cl = &StackClass[pt->StackClass];
+  FREELINK(pt->Stack) = cl->FreePt; // lowest words, unused by a live stack
+  cl->FreePt = pt->Stack;
+  cl->Used--;
+  pt->Id = 0;                 // mark as free
+  pt->next = FreeTcb;         // push TCB
+  FreeTcb = pt;
+}
+
+//------------Thread_Link------------
+// Insert a thread into the circular list just before another.
+// Input: pt thread to insert
+//        before thread already in the list, 0 if the list is empty
+// Output: none
+void Thread_Link(tcbType *pt, tcbType *before){
+  if(before == 0){
+    pt->next = pt;            // list of one
+    pt->prev = pt;
+    return;
+  }
+  pt->next = before;
+  pt->prev = before->prev;
+  before->prev->next = pt;
+  before->prev = pt;
+}
+
+//------------Thread_Unlink------------
+// Remove a thread from the circular list.  Its next pointer
+// is left alone, so it still leads back into the list.
+// Input: pt thread in a list of at least two threads
+// Output: none
+void Thread_Unlink(tcbType *pt){
+  pt->prev->next = pt->next;
+  pt->next->prev = pt->prev;
+}
@@ -0,0 +1,105 @@
+// Thread.h
+// Runs on MSP432 or a host computer
+// Thread control blocks and stack memory for the Lab 4 kernel.
+// Free TCBs are kept on a stack, and stacks come from a pool of
+// fixed-size blocks in a few size classes (like Heap.c), so
+// creating and killing a thread take constant time.
+// Running threads are in a circular doubly linked list, so a
+// thread can be removed without searching for its predecessor.
+// The kernel calls these with interrupts disabled.
+
+#ifndef __THREAD_H
+#define __THREAD_H  1
+
+#define NUMTHREADS  20       // maximum number of threads
+#define STACKSIZE   100      // default number of 32-bit words in stack per thread
+#define STACKCLASSES 3       // number of stack size classes
+#define STACKPAINT  0x5AA5A55A // stacks are filled with this when created
+#define STACKCANARY 0xDEADC0DE // in Stack[STACKGUARD], checked at every switch
+#define STACKMPU    0        // 1 for an MPU no-access region at the bottom
+                             // of the running thread's stack
+#if STACKMPU
+#define STACKGUARD  8        // words guarded by the MPU, 32 bytes
+#else
+#define STACKGUARD  0
+#endif
+
+struct tcb{
+  int32_t *sp;       // pointer to stack (valid for threads not running
+  uint32_t ExcReturn;// EXC_RETURN, bit 4 is 0 if S16-S31 are on the stack
+  struct tcb *next;  // linked-list pointer
+  struct tcb *prev;  // previous thread in list
+  uint32_t Id;       // 0 means TCB is free
+  int32_t *BlockPt;  // nonzero if blocked on this semaphore
+  uint32_t Sleep;    // nonzero if this thread is sleeping
+  uint32_t Priority; // 0 is highest
+  uint32_t Period;   // ms between releases, 0 if not periodic
+  uint32_t Deadline; // ms from release to deadline
+  uint32_t Wcet;     // ms, worst case execution time of one job
+  uint32_t Release;  // ms time of the current release
+  uint32_t AbsDeadline; // ms time the current job must finish by
+  uint32_t Misses;   // jobs finished after AbsDeadline
+  int32_t *Stack;    // lowest address of the stack block
+  uint32_t StackSize;// number of 32-bit words in the stack block
+  uint32_t StackClass; // size class the stack block came from
+  uint64_t RunCycles;// bus cycles spent running
+  uint64_t BlockedCycles; // bus cycles spent blocked on semaphores
+  uint64_t LastRun;  // RunCycles at the previous OS_Snapshot
+  uint32_t Switches; // number of times switched in
+  uint32_t BlockTime;// DWT_CYCCNT when it blocked
+  uint32_t WakeTime; // DWT_CYCCNT when OS_Signal or sleep made it ready
+  uint32_t Waking;   // 1 if WakeTime is valid
+  uint32_t MaxLatency; // most bus cycles from WakeTime to running
+};
+typedef struct tcb tcbType;
+extern tcbType Tcbs[NUMTHREADS];
+
+struct stackclass{
+  uint32_t Size;     // number of 32-bit words in each block, multiple of 2
+  uint32_t Num;      // number of blocks
+  int32_t *Memory;   // Size*Num words
+  int32_t *FreePt;   // first free block, 0 if none
+  uint32_t Used;     // number of blocks allocated
+};
+typedef struct stackclass stackClassType;
+extern stackClassType StackClass[STACKCLASSES];
+
+//------------Thread_Init------------
+// Put all TCBs on the free TCB stack and all stack blocks
+// on the free list of their class.
+// Input: none
+// Output: none
+void Thread_Init(void);
+
+//------------Thread_Allocate------------
+// Take a free TCB and a stack of at least the requested size,
+// from the smallest class that fits and has a free block.
+// Input: stackSize number of 32-bit words needed
+// Output: TCB with Stack, StackSize and StackClass set,
+//         or 0 if no TCB or no large enough stack is free
+tcbType *Thread_Allocate(uint32_t stackSize);
+
+//------------Thread_Release------------
+// Return a TCB and its stack to the free lists, and mark
+// the TCB free.  The stack is reused by a later Thread_Allocate,
+// so a thread may release itself as long as it switches away
+// before any other thread is created.
+// Input: pt TCB from Thread_Allocate, not in the list
+// Output: none
+void Thread_Release(tcbType *pt);
+
+//------------Thread_Link------------
+// Insert a thread into the circular list just before another.
+// Input: pt thread to insert
+//        before thread already in the list, 0 if the list is empty
+// Output: none
+void Thread_Link(tcbType *pt, tcbType *before);
+
+//------------Thread_Unlink------------
+// Remove a thread from the circular list.  Its next pointer
+// is left alone, so it still leads back into the list.
+// Input: pt thread in a list of at least two threads
+// Output: none
+void Thread_Unlink(tcbType *pt);
+
+#endif
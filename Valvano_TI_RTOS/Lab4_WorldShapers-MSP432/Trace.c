@@ -0,0 +1,116 @@
+// Trace.c
+// Runs on MSP432
+// Binary event trace of the Lab 4 kernel.  The scheduler,
+// semaphores, FIFO and interrupt service routines record 8-byte
+// events into a RAM ring buffer, time stamped with the DWT cycle
+// counter.  The buffer always holds the most recent TRACESIZE
+// events, so after a failure it can be dumped over UART0 with
+// Trace_Dump and converted on the PC with
+// Lab4_Host/TraceToChrome.c into Chrome trace JSON.
+
+#include <stdint.h>
+#include "Trace.h"
+#include "../inc/CortexM.h"
+#include "../inc/BSP.h"
+#include "../inc/msp432p401r.h"
+
+traceType TraceBuf[TRACESIZE]; // 8 bytes each
+uint32_t static TraceI;        // index of next event to record
+uint32_t static TraceCount;    // events recorded since Trace_Init
+uint32_t static TraceOn;       // 1 while recording
+
+//------------Trace_Init------------
+// Empty the trace buffer and start recording.
+// The DWT cycle counter must be enabled (OS_Init does this).
+// Input: none
+// Output: none
+void Trace_Init(void){
+  TraceI = 0;
+  TraceCount = 0;
+  TraceOn = 1;
+}
+
+//------------Trace_Event------------
+// Record one event, overwriting the oldest if the buffer is full.
+// Call through TRACEEVENT so it compiles out with TRACE 0.
+// Callable from threads and interrupt service routines.
+// Input: type TRACE_SWITCH ... TRACE_ISREXIT
+//        id thread Id, see the event type
+//        data see the event type
+// Output: none
+void Trace_Event(uint8_t type, uint8_t id, uint16_t data){ long sr;
+  traceType *pt;
+  sr = StartCritical();
+  if(TraceOn){
+    pt = &TraceBuf[TraceI];
+    pt->Time = DWT_CYCCNT;
+    pt->Type = type;
+    pt->Id = id;
+    pt->Data = data;
+    TraceI = (TraceI+1)&(TRACESIZE-1);
+    TraceCount++;
+  }
+  EndCritical(sr);
+}
+
+//------------Trace_Stop------------
+// Stop recording, so the events leading up to a failure are kept.
+// Input: none
+// Output: none
+void Trace_Stop(void){
+  TraceOn = 0;
+}
+
+// send n hex digits of data, most significant first
+void static outhex(void(*outChar)(char), uint32_t data, int n){
+  while(n > 0){
+    n--;
+    outChar("0123456789ABCDEF"[(data>>(4*n))&0x0F]);
+  }
+}
+// send unsigned decimal
+void static outdec(void(*outChar)(char), uint32_t n){
+  if(n >= 10){
+    outdec(outChar, n/10);
+  }
+  outChar('0'+n%10);
+}
+
+//------------Trace_Dump------------
+// Stop recording and send the buffer as text, oldest event first.
+// First line: T <bus clock Hz> <events dumped> <events lost>
+// Then one line per event, hex: <Time> <Type> <Id> <Data>
+// Last line: E
+// Runs with interrupts disabled, so it works after a crash.
+// Input: outChar function that sends one character,
+//        e.g. UART0_OutChar after UART0_Init
+// Output: none
+void Trace_Dump(void(*outChar)(char)){ long sr;
+  uint32_t i, n, first;
+  traceType *pt;
+  sr = StartCritical();
+  TraceOn = 0;
+  if(TraceCount < TRACESIZE){
+    n = TraceCount;
+    first = 0;
+  }else{
+    n = TRACESIZE;
+    first = TraceI;          // oldest event is overwritten next
+  }
+  outChar('T'); outChar(' ');
+  outdec(outChar, BSP_Clock_GetFreq()); outChar(' ');
+  outdec(outChar, n); outChar(' ');
+  outdec(outChar, TraceCount - n);
+  outChar('\r'); outChar('\n');
+  for(i=0; i<n; i++){
+    pt = &TraceBuf[(first+i)&(TRACESIZE-1)];
+    outhex(outChar, pt->Time, 8); outChar(' ');
+    outhex(outChar, pt->Type, 2); outChar(' ');
+    outhex(outChar, pt->Id, 2);   outChar(' ');
+    outhex(outChar, pt->Data, 4);
+    outChar('\r'); outChar('\n');
+  }
+  outChar('E');
+  outChar('\r'); outChar('\n');
+  EndCritical(sr);
+}
@@ -0,0 +1,91 @@
+// Trace.h
+// Runs on MSP432
+// Binary event trace of the Lab 4 kernel.  The scheduler,
+// semaphores, FIFO and interrupt service routines record 8-byte
+// events into a RAM ring buffer, time stamped with the DWT cycle
+// counter.  The buffer always holds the most recent TRACESIZE
+// events, so after a failure it can be dumped over UART0 with
+// Trace_Dump and converted on the PC with
+// Lab4_Host/TraceToChrome.c into Chrome trace JSON, which opens
+// in chrome://tracing or https://ui.perfetto.dev
+// The kernel stops recording when it crashes, so TraceBuf can also
+// be read in the debugger.
+// Recording an event is a short critical section and three stores.
+// Set TRACE to 0 to compile all the trace calls out.
+
+#ifndef __TRACE_H
+#define __TRACE_H  1
+
+#define TRACE      1         // 1 to record events, 0 for none
+#define TRACESIZE  1024      // events in the ring, power of 2, about
+                             // 150 ms of WorldShapers with its three 1 kHz ISRs
+
+struct trace{
+  uint32_t Time;     // DWT_CYCCNT, bus cycles
+  uint8_t Type;      // TRACE_SWITCH ... TRACE_ISREXIT
+  uint8_t Id;        // thread Id, see each type
+  uint16_t Data;     // see each type
+};
+typedef struct trace traceType;
+
+// event types, Id and Data
+#define TRACE_SWITCH   1  // Id thread switched in, Data thread switched out
+#define TRACE_WAIT     2  // Id running thread, Data semaphore address bits 15-0
+#define TRACE_BLOCK    3  // Id running thread, Data semaphore address bits 15-0
+#define TRACE_SIGNAL   4  // Id running thread, Data semaphore address bits 15-0
+#define TRACE_WAKE     5  // Id woken thread, Data semaphore address bits 15-0, 0 for sleep
+#define TRACE_SLEEP    6  // Id running thread, Data ms
+#define TRACE_KILL     7  // Id killed thread
+#define TRACE_FIFOPUT  8  // Id running thread, Data FIFO entries after put
+#define TRACE_FIFOGET  9  // Id running thread, Data FIFO entries after get
+#define TRACE_FIFOLOST 10 // Id running thread, Data FIFO entries (full)
+#define TRACE_ISRENTER 11 // Id interrupted thread, Data exception number
+#define TRACE_ISREXIT  12 // Id interrupted thread, Data exception number
+
+// exception numbers of the Lab 4 interrupts, 16 plus the IRQ number
+#define TRACE_SYSTICK  15 // SysTick_Handler, time slice
+#define TRACE_TA1      26 // TA1_0_IRQHandler, runperiodicevents
+#define TRACE_T32      41 // T32_INT1_IRQHandler, RealTimeEvents
+#define TRACE_PORT1    51 // PORT1_IRQHandler, edge events, PORTn is 50+n
+
+#if TRACE
+#define TRACEEVENT(type,id,data) Trace_Event(type,id,data)
+#else
+#define TRACEEVENT(type,id,data)
+#endif
+
+//------------Trace_Init------------
+// Empty the trace buffer and start recording.
+// The DWT cycle counter must be enabled (OS_Init does this).
+// Input: none
+// Output: none
+void Trace_Init(void);
+
+//------------Trace_Event------------
+// Record one event, overwriting the oldest if the buffer is full.
+// Call through TRACEEVENT so it compiles out with TRACE 0.
+// Callable from threads and interrupt service routines.
+// Input: type TRACE_SWITCH ... TRACE_ISREXIT
+//        id thread Id, see the event type
+//        data see the event type
+// Output: none
+void Trace_Event(uint8_t type, uint8_t id, uint16_t data);
+
+//------------Trace_Stop------------
+// Stop recording, so the events leading up to a failure are kept.
+// Input: none
+// Output: none
+void Trace_Stop(void);
+
+//------------Trace_Dump------------
+// Stop recording and send the buffer as text, oldest event first.
+// First line: T <bus clock Hz> <events dumped> <events lost>
+// Then one line per event, hex: <Time> <Type> <Id> <Data>
+// Last line: E
+// Runs with interrupts disabled, so it works after a crash.
+// Input: outChar function that sends one character,
+//        e.g. UART0_OutChar after UART0_Init
+// Output: none
+void Trace_Dump(void(*outChar)(char));
+
+#endif
@@ -31,6 +31,7 @@
 #include <stdint.h>
 #include "../inc/BSP.h"
 #include "../inc/CortexM.h"
+#include "../inc/msp432p401r.h"
 #include "Random.h"
 #include "Sound.h"
 #include "score.h"
@@ -790,37 +791,106 @@ void EnemyCreateTask(void){
 //------------ButtonTask handles switch input -------
 // *********ButtonTask*********
 // Main thread scheduled by OS priority scheduler
-// real-time task, signaled on touch
-//   with bouncing, may also be called on release
-// checks the switches, creates player rockets
+// real-time task, signaled once per press, the kernel debounces
+// creates player rockets
 // Inputs:  none
 // Outputs: none
 void ButtonTask(void){uint32_t i;
-  uint8_t current;
   OS_InitSemaphore(&Button,0); // signaled on touch button1
   while(1){
-    OS_Wait(&Button);      // OS signals on touch
+    OS_Wait(&Button);      // OS signals when pressed, after 10 ms of debouncing
     TExaS_Task3();         // records system time in array, toggles virtual logic analyzer
-    OS_Sleep(10);          // debounce the switches
-    current = BSP_Button1_Input();
-    if(current == 0){     // Button1 was pressed 
-      i = FindFreeRocket();
-      if(i){
-        Sound_Shoot();
-        if(Score > 1) Score--;
-        CreateSprite(i,rocket0,rocket1,10,rocket3,Things[SHIP].x+8,Things[SHIP].y-5,8,3,RocketSpeed,0,1);
-      }
+    i = FindFreeRocket();
+    if(i){
+      Sound_Shoot();
+      if(Score > 1) Score--;
+      CreateSprite(i,rocket0,rocket1,10,rocket3,Things[SHIP].x+8,Things[SHIP].y-5,8,3,RocketSpeed,0,1);
     }
-    OS_EdgeTrigger_Restart();
   }
 }
 
-int Freetime;
-void IdleTask(void){ // dummy task
-  Freetime = 0;      // this task cannot block, sleep or kill
-  while(1){
-    Freetime++; 
+//------------switch latency benchmark-------
+// main_switch replaces main to measure the thread switch
+// with the DWT cycle counter (one count per bus cycle)
+// phase 1: PingTask and PongTask have equal priority and yield to
+//   each other, cycles from OS_Suspend in one to running the other
+// phase 2: SignalTask signals the blocked, higher priority WakeTask,
+//   cycles from OS_Signal to WakeTask returning from OS_Wait
+// Both paths pend PendSV, neither one resets the SysTick time slice
+#define SWITCHRUNS 1000   // measurements per phase
+struct switchstat{
+  uint32_t Min;      // fewest cycles
+  uint32_t Max;      // most cycles, includes an occasional ISR
+  uint32_t Total;    // sum of cycles, average is Total/Count
+  uint32_t Count;    // number of measurements
+};
+typedef struct switchstat switchStatType;
+switchStatType YieldStat = {0xFFFFFFFF,0,0,0};
+switchStatType WakeStat = {0xFFFFFFFF,0,0,0};
+uint32_t volatile SwitchStart; // DWT_CYCCNT before the switch
+int32_t Wake;                  // WakeTask blocks on this
+
+void static switchrecord(switchStatType *stat){uint32_t cycles;
+  cycles = DWT_CYCCNT - SwitchStart;
+  if(cycles < stat->Min) stat->Min = cycles;
+  if(cycles > stat->Max) stat->Max = cycles;
+  stat->Total = stat->Total + cycles;
+  stat->Count++;
+}
+void PingTask(void){
+  while(YieldStat.Count < SWITCHRUNS){
+    SwitchStart = DWT_CYCCNT;
+    OS_Suspend();           // PongTask runs next
+    switchrecord(&YieldStat);
+  }
+  OS_Kill();                // let SignalTask run
+}
+void PongTask(void){
+  while(YieldStat.Count < SWITCHRUNS){
+    SwitchStart = DWT_CYCCNT;
+    OS_Suspend();           // PingTask runs next
+    switchrecord(&YieldStat);
+  }
+  OS_Kill();
+}
+void WakeTask(void){
+  OS_InitSemaphore(&Wake,0);
+  while(WakeStat.Count < SWITCHRUNS){
+    OS_Wait(&Wake);         // SignalTask runs while blocked
+    switchrecord(&WakeStat);
   }
+  OS_Kill();
+}
+void static switchshow(uint32_t y, char *name, switchStatType *stat){
+  BSP_LCD_DrawString(0, y, name, LCD_WHITE);
+  BSP_LCD_SetCursor(7, y);   BSP_LCD_OutUDec4(stat->Min, LCD_YELLOW);
+  BSP_LCD_SetCursor(12, y);  BSP_LCD_OutUDec4(stat->Total/stat->Count, LCD_YELLOW);
+  BSP_LCD_SetCursor(17, y);  BSP_LCD_OutUDec5(stat->Max, LCD_YELLOW);
+}
+void SignalTask(void){      // runs after PingTask and PongTask are killed
+  while(WakeStat.Count < SWITCHRUNS){
+    SwitchStart = DWT_CYCCNT;
+    OS_Signal(&Wake);       // WakeTask preempts
+  }
+  BSP_LCD_DrawString(0, 0, "Switch cycles", LCD_WHITE);
+  BSP_LCD_DrawString(7, 1, "min  avg  max", LCD_WHITE);
+  switchshow(2, "Yield", &YieldStat);
+  switchshow(3, "Wakeup", &WakeStat);
+  while(1){                 // cannot block, sleep or kill
+  }
+}
+int main_switch(void){
+  DisableInterrupts();
+  BSP_Clock_InitFastest();
+  BSP_LCD_Init();
+  BSP_LCD_FillScreen(LCD_BLACK);
+  OS_Init();                     // also enables the DWT cycle counter
+  OS_AddThread(&WakeTask,0);     // highest priority, blocked on Wake
+  OS_AddThread(&PingTask,1);
+  OS_AddThread(&PongTask,1);
+  OS_AddThread(&SignalTask,2);   // lowest priority, runs in phase 2
+  OS_Launch(BSP_Clock_GetFreq()/THREADFREQ); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
 }
 int main(void){uint16_t x,y; uint8_t button;
   DisableInterrupts();
@@ -838,7 +908,7 @@ int main(void){uint16_t x,y; uint8_t button;
   OS_Init();
   OS_PeriodTrigger0_Init(&RunGame,33); // timing engine for game
   OS_PeriodTrigger1_Init(&CreateEnemy,100); // create enemies 10 times a second
-  OS_EdgeTrigger_Init(&Button, 3);     // effect of button touch
+  OS_EdgeEvent_Add(5, 1, EDGE_FALL|EDGE_PULLUP, &Button, 0, 10, 3); // button1 P5.1, debounced
   TExaS_Init(LOGICANALYZER,BSP_Clock_GetFreq());
   Sound_EyesOfTexas();
   OS_InitSemaphore(&RunGame,0);     // signaled by timer to run engine
@@ -847,7 +917,8 @@ int main(void){uint16_t x,y; uint8_t button;
   OS_AddThread(&GameTask,0);
   OS_AddThread(&ButtonTask,0);   // high priority, signaled on button touch
   OS_AddThread(&EnemyCreateTask,2);
-  OS_AddThread(&IdleTask,7);     // lowest priority, dummy task
+  // the kernel idle thread runs when these are blocked or sleeping,
+  // in LPM0, since Sound.c needs SMCLK
   CreateSprite(SHIP,ship0,ship1,2,ship3,0,DesiredPlace,18,13,0,0,10);
   OS_Launch(BSP_Clock_GetFreq()/THREADFREQ); // doesn't return, interrupts enabled in here
   while(1){ // does not get here
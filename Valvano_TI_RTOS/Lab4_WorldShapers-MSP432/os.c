@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 #include "os.h"
+#include "Thread.h"
+#include "Trace.h"
 #include "../inc/CortexM.h"
 #include "../inc/BSP.h"
 #include "../inc/msp432p401r.h"
@@ -15,24 +17,34 @@
 // function definitions in osasm.s
 void StartOS(void);
 
-#define NUMTHREADS  20       // maximum number of threads
 #define NUMPERIODIC 2        // maximum number of periodic threads
-#define STACKSIZE   100      // number of 32-bit words in stack per thread
-struct tcb{
-  int32_t *sp;       // pointer to stack (valid for threads not running
-  struct tcb *next;  // linked-list pointer
-  uint32_t Id;       // 0 means TCB is free
-  int32_t *BlockPt;  // nonzero if blocked on this semaphore
-  uint32_t Sleep;    // nonzero if this thread is sleeping
-  uint32_t Priority; // 0 is highest
-};
-typedef struct tcb tcbType;
-tcbType tcbs[NUMTHREADS];
 tcbType *RunPt;
-int32_t Stacks[NUMTHREADS][STACKSIZE];
 void static runperiodicevents(void);
+void static idlestart(uint32_t theTimeSlice);
+void static edgerearm(void);
+uint32_t static edgenext(uint32_t next);
+void static edgecatchup(uint32_t ms);
 uint32_t NumThread=0;  // number of threads
 uint32_t static ThreadId=0;   // thread Ids are sequential from 1
+uint32_t OS_TickCount=0;      // number of time slices since OS_Launch
+uint32_t OS_MsTime=0;         // ms since OS_Init, counted by runperiodicevents
+uint32_t OS_DeadlineMisses=0; // late jobs of all periodic threads
+uint32_t OS_StackOverflow=0;  // Id of the thread that overflowed its stack
+tcbType KillTcb;              // stands in for a killed thread until PendSV
+uint32_t static SwitchTime;   // DWT_CYCCNT at the last thread switch
+uint32_t static CyclesPerMs;  // bus cycles in 1 ms
+uint64_t static LastTotal;    // DWT cycles at the previous OS_Snapshot
+uint64_t static TotalCycles;  // DWT cycles, all threads together
+
+#define NUMSEMSTATS 8         // semaphores with blocking statistics
+struct semstat{
+  int32_t *SemaPt;      // semaphore, 0 if entry is free
+  uint32_t Blocks;      // number of times a thread blocked and was woken
+  uint64_t BlockedCycles; // total bus cycles threads were blocked
+  uint32_t MaxBlocked;  // most bus cycles one thread was blocked
+};
+typedef struct semstat semStatType;
+semStatType SemStats[NUMSEMSTATS];
 
 // ******** OS_Init ************
 // Initialize operating system, disable interrupts
@@ -45,41 +57,33 @@ void OS_Init(void){
   BSP_Clock_InitFastest();// set processor clock to fastest speed
   NumThread=0;  // number of threads
   ThreadId=0;   // thread Ids are sequential from 1
+  Thread_Init();// all TCBs and stacks free
+  COREDEBUG_DEMCR |= 0x01000000; // enable trace, needed for DWT
+  DWT_CTRL |= 0x00000001;        // enable cycle counter, for statistics
+  CyclesPerMs = BSP_Clock_GetFreq()/1000;
+  Trace_Init(); // record kernel events, see Trace.h
 // perform any initializations needed, 
 // set up periodic timer to run runperiodicevents to implement sleeping
   BSP_PeriodicTask_InitB(&runperiodicevents, 1000, 0);
 }
 
 
-//******** OS_AddThread *************** 
-// add a foregound thread to the scheduler
-// Inputs: pointer to a void/void foreground function
-//         priority (0 is highest)
-// Outputs: Thread ID if successful, 0 if this thread can not be added
-// stack size must be divisable by 8 (aligned to double word boundary)
-int OS_AddThread(void(*task)(void), uint32_t priority){ int status;
-  int n;         // index to new thread TCB 
+// add a thread with a stack of at least stackSize words
+// returns its TCB, or 0 if no TCB or stack is free
+tcbType static *addthread(void(*task)(void), uint32_t priority, uint32_t stackSize){ int status;
   tcbType *NewPt;  // Pointer to nex thread TCB
-  tcbType *LastPt; // Pointer to last thread TCB
   int32_t *sp;      // stack pointer
   status = StartCritical();
-//  NewPt = malloc(stackSize+10);    // 9 extra bytes needed
-  for(n=0; n< NUMTHREADS; n++){
-    if(tcbs[n].Id == 0) break; // found it 
-    if(n == NUMTHREADS-1){  
-      EndCritical(status);
-      return 0;          // heap is full
-    }
+  NewPt = Thread_Allocate(stackSize+STACKGUARD+1); // constant time, plus guard and canary
+  if(NewPt == 0){
+    EndCritical(status);
+    return 0;          // heap is full
   }
-  NewPt = &tcbs[n]; 
   if(NumThread==0){
     RunPt = NewPt;  // points to first thread created
+    Thread_Link(NewPt, 0);
   } else{
-    LastPt = RunPt;
-    while(LastPt->next != RunPt){
-      LastPt = LastPt->next;
-    }
-    LastPt->next = NewPt; // Pointer to Next  
+    Thread_Link(NewPt, RunPt); // last in round robin order
   }
   NewPt->Priority =  priority;
   NumThread++;
@@ -87,8 +91,15 @@ int OS_AddThread(void(*task)(void), uint32_t priority){ int status;
   NewPt->Id = ThreadId;
   NewPt->BlockPt =  0;    // not blocked
   NewPt->Sleep =  0;      // not sleeping
+  NewPt->Period = 0;      // not periodic, set by OS_AddPeriodicThread
+  NewPt->RunCycles = NewPt->BlockedCycles = NewPt->LastRun = 0;
+  NewPt->Switches = NewPt->Waking = NewPt->MaxLatency = 0;
+  for(sp=NewPt->Stack; sp<&(NewPt->Stack[NewPt->StackSize]); sp++){
+    *sp = STACKPAINT;     // for the stack high-water mark
+  }
+  NewPt->Stack[STACKGUARD] = STACKCANARY; // lowest word the thread may use
 
-  sp = &Stacks[n][STACKSIZE-1];      // last entry of stack
+  sp = &(NewPt->Stack[NewPt->StackSize-1]); // last entry of stack
 
 
 // derived from uCOS-II
@@ -112,10 +123,150 @@ int OS_AddThread(void(*task)(void), uint32_t priority){ int status;
   *(--sp)  = (long)0x05050505L;             /* R5                                                 */
   *(--sp)  = (long)0x04040404L;             /* R4                                                 */
   NewPt->sp = sp;        // make stack "look like it was previously suspended"
-  NewPt->next = RunPt;   // Pointer to first, circular linked list 
+  NewPt->ExcReturn = 0xFFFFFFF9; // thread mode, MSP, basic frame without FPU state
+  EndCritical(status);
+  return NewPt;
+}
+
+//******** OS_AddThread *************** 
+// add a foregound thread to the scheduler
+// Inputs: pointer to a void/void foreground function
+//         priority (0 is highest)
+// Outputs: 1 if successful, 0 if this thread can not be added
+// the stack is STACKSIZE words
+int OS_AddThread(void(*task)(void), uint32_t priority){
+  return (addthread(task, priority, STACKSIZE) != 0);
+}
+
+//******** OS_AddThreadStack *************** 
+// add a foregound thread to the scheduler, with its own stack size
+// Inputs: pointer to a void/void foreground function
+//         priority (0 is highest)
+//         stackSize, number of 32-bit words of stack needed,
+//           see OS_StackReport, plus the guard and canary
+//           rounded up to a size class in Thread.c
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddThreadStack(void(*task)(void), uint32_t priority, uint32_t stackSize){
+  return (addthread(task, priority, stackSize) != 0);
+}
+// density Wcet/min(Deadline,Period), 1000 is 100%, rounded up
+// so a set of threads slightly over 100% can not add up to 1000
+uint32_t static density(uint32_t period, uint32_t deadline, uint32_t wcet){
+  if(deadline > period){
+    deadline = period;
+  }
+  return (1000*wcet + deadline - 1)/deadline;
+}
+// sum of the densities of the periodic threads at priority level or higher
+uint32_t static leveldensity(uint32_t level){int n;
+  uint32_t sum = 0;
+  for(n=0; n<NUMTHREADS; n++){
+    if((Tcbs[n].Id)&&(Tcbs[n].Period)&&(Tcbs[n].Priority <= level)){
+      sum = sum + density(Tcbs[n].Period, Tcbs[n].Deadline, Tcbs[n].Wcet);
+    }
+  }
+  return sum;
+}
+//******** OS_AddPeriodicThread *************** 
+// add a periodic thread; threads of equal priority run
+// earliest deadline first, ahead of equal priority threads
+// that are not periodic, which run round robin
+// The thread loops, calling OS_WaitPeriod after each job
+// Admission: for each priority level of a periodic thread, the
+// densities Wcet/min(Deadline,Period) of all periodic threads
+// at that or higher priority must total at most 1, which is
+// exact for EDF when Deadline equals Period.  The new thread
+// adds to its own level and to every lower one, so all of
+// those are checked again.
+// Inputs: pointer to a void/void foreground function
+//         priority (0 is highest)
+//         period, deadline and wcet in ms
+//         (deadline 0 means equal to the period)
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddPeriodicThread(void(*task)(void), uint32_t priority,
+  uint32_t period, uint32_t deadline, uint32_t wcet){ int status;
+  int n;
+  tcbType *NewPt;
+  uint32_t d;       // density of the new thread, 1000 is 100%
+  if(deadline == 0){
+    deadline = period;
+  }
+  if((period == 0)||(wcet == 0)||(wcet > deadline)){
+    return 0;     // can never meet its deadline
+  }
+  d = density(period, deadline, wcet);
+  status = StartCritical();
+  if(leveldensity(priority) + d > 1000){
+    EndCritical(status);
+    return 0;     // not schedulable at its own level
+  }
+  for(n=0; n<NUMTHREADS; n++){ // lower levels that already have periodic threads
+    if((Tcbs[n].Id)&&(Tcbs[n].Period)&&(Tcbs[n].Priority > priority)&&
+       (leveldensity(Tcbs[n].Priority) + d > 1000)){
+      EndCritical(status);
+      return 0;   // would make an admitted thread miss its deadlines
+    }
+  }
+  NewPt = addthread(task, priority, STACKSIZE);
+  if(NewPt == 0){
+    EndCritical(status);
+    return 0;     // no free TCB
+  }
+  NewPt->Period = period;
+  NewPt->Deadline = deadline;
+  NewPt->Wcet = wcet;
+  NewPt->Release = OS_MsTime;  // first job released now
+  NewPt->AbsDeadline = OS_MsTime + deadline;
+  NewPt->Misses = 0;
   EndCritical(status);
   return 1;
 }
+
+//******** OS_WaitPeriod *************** 
+// called by a periodic thread when its job is done
+// counts a miss if past its deadline, then sleeps
+// until its next release, which is one period after the last
+// Inputs: none
+// Outputs: none
+void OS_WaitPeriod(void){ int32_t wait;
+  DisableInterrupts();
+  if((int32_t)(OS_MsTime - RunPt->AbsDeadline) > 0){
+    RunPt->Misses++;    // late
+    OS_DeadlineMisses++;
+  }
+  RunPt->Release = RunPt->Release + RunPt->Period;
+  RunPt->AbsDeadline = RunPt->Release + RunPt->Deadline;
+  wait = RunPt->Release - OS_MsTime;
+  if(wait > 0){
+    RunPt->Sleep = wait; // else released already, run again
+  }
+  EnableInterrupts();
+  OS_Suspend();
+}
+
+//******** OS_Misses *************** 
+// number of late jobs of the running periodic thread
+// Input:  none
+// Output: misses, total over all threads is OS_DeadlineMisses
+uint32_t OS_Misses(void){
+  return RunPt->Misses;
+}
+
+// 1 if thread a should run before thread b
+// lower priority number first, then periodic threads earliest deadline first
+int static earlier(tcbType *a, tcbType *b){
+  if(a->Priority != b->Priority){
+    return (a->Priority < b->Priority);
+  }
+  if(a->Period == 0){
+    return 0;     // round robin among threads that are not periodic
+  }
+  if(b->Period == 0){
+    return 1;
+  }
+  return ((int32_t)(a->AbsDeadline - b->AbsDeadline) < 0);
+}
+
 // ****OS_Id**********
 // returns the Id for the currently running thread
 // Input:  none
@@ -127,13 +278,25 @@ uint32_t OS_Id(void){
 
 void static runperiodicevents(void){int i;
   tcbType *searchPt;
+  TRACEEVENT(TRACE_ISRENTER, RunPt->Id, TRACE_TA1);
+  OS_MsTime++;
   searchPt = RunPt;
-  for(i=0; i<NUMTHREADS; i=i+1){
+  for(i=0; i<NumThread; i=i+1){ // each thread once
+    searchPt = searchPt->next;
     if((searchPt->Sleep) > 0){
       searchPt->Sleep = searchPt->Sleep - 1;
+      if(searchPt->Sleep == 0){
+        searchPt->WakeTime = DWT_CYCCNT;
+        searchPt->Waking = 1;
+        TRACEEVENT(TRACE_WAKE, searchPt->Id, 0);
+        if(earlier(searchPt, RunPt)){
+          INTCTRL = 0x10000000; // trigger PendSV, woke a thread that runs first
+        }
+      }
     }
-    searchPt = searchPt->next;
   }
+  edgerearm();               // debounced pins that have settled
+  TRACEEVENT(TRACE_ISREXIT, RunPt->Id, TRACE_TA1);
 }
 
 //******** OS_Launch ***************
@@ -144,32 +307,105 @@ void static runperiodicevents(void){int i;
 void OS_Launch(uint32_t theTimeSlice){
   STCTRL = 0;                  // disable SysTick during setup
   STCURRENT = 0;               // any write to current clears it
-  SYSPRI3 =(SYSPRI3&0x0000FFFF)|0xE0E00000; // priority 7, SysTick and PendSV
+  SYSPRI3 =(SYSPRI3&0x0000FFFF)|0xC0E00000; // SysTick priority 6, PendSV priority 7
   STRELOAD = theTimeSlice - 1; // reload value
   STCTRL = 0x00000007;         // enable, core clock and interrupt arm
+  FPCCR |= 0xC0000000;         // ASPEN, LSPEN lazy stacking of S0-S15,FPSCR
+#if STACKMPU
+  MPU_RBAR = (uint32_t)RunPt->Stack|0x10; // VALID, region 0
+  MPU_RASR = 0x10000009;       // XN, no access, 32 bytes, enable
+  MPU_CTRL = 0x00000005;       // PRIVDEFENA, MPU off in HardFault, enable
+#endif
+  idlestart(theTimeSlice);     // kernel idle thread, lowest priority
+  SwitchTime = DWT_CYCCNT;     // first thread starts running
+  RunPt->Switches = 1;
   StartOS();                   // start on the first task
 }
 // runs every ms
-void Scheduler(void){      // every time slice
-// ****IMPLEMENT THIS****
+// SysTick only accounts time, the thread switch itself runs in PendSV
+// at the lowest priority, after all other ISRs have finished.
+// A wake or signal that lets a thread run first has already pended
+// PendSV, so at the end of a time slice a switch is needed only to
+// share the processor with another ready thread of the same priority.
+// 1 if a thread other than RunPt, at RunPt's priority, is not
+// blocked and not sleeping
+int static roundrobin(void){int i;
+  tcbType *pt = RunPt;
+  for(i=0; i<NumThread; i=i+1){ // each thread once, RunPt may be KillTcb
+    pt = pt->next;
+    if((pt != RunPt)&&(pt->Priority == RunPt->Priority)&&
+       ((pt->BlockPt)==0)&&((pt->Sleep)==0)){
+      return 1;
+    }
+  }
+  return 0;
+}
+void SysTick_Handler(void){ // every time slice
+  TRACEEVENT(TRACE_ISRENTER, RunPt->Id, TRACE_SYSTICK);
+  OS_TickCount++;
+  if((RunPt->BlockPt)||(RunPt->Sleep)||roundrobin()){
+    INTCTRL = 0x10000000; // trigger PendSV, time slice expired
+  }
+  TRACEEVENT(TRACE_ISREXIT, RunPt->Id, TRACE_SYSTICK);
+}
+// stop with the Id of the thread whose stack overflowed
+void static stackoverflow(void){
+  OS_StackOverflow = RunPt->Id;
+  Trace_Stop(); // keep the events that led here
+  while(1){};   // crash
+}
+#if STACKMPU
+// a write to the guard region, including exception stacking,
+// escalates to HardFault, which runs with the MPU off
+void HardFault_Handler(void){
+  if(SCB_CFSR&0x00000012){ // MSTKERR or DACCVIOL
+    stackoverflow();
+  }
+  Trace_Stop(); // keep the events that led here
+  while(1){};   // crash
+}
+#endif
+// called from PendSV_Handler in osasm.asm
+void Scheduler(void){      // every thread switch
 // look at all threads in TCB list choose
 // highest priority thread not blocked and not sleeping 
-// If there are multiple highest priority (not blocked, not sleeping) run these round robin
-  uint32_t priority = 255; // max
+// If there are multiple highest priority (not blocked, not sleeping) run
+// periodic ones earliest deadline first, then the others round robin
+  uint32_t i;
+  uint32_t now = DWT_CYCCNT;
   tcbType *pt;
   tcbType *bestPt;
+  if(RunPt->Stack&&(RunPt->Stack[STACKGUARD] != STACKCANARY)){
+    stackoverflow();        // ran past the bottom of its stack
+  }
+  RunPt->RunCycles += now - SwitchTime; // KillTcb for a killed thread
+  TotalCycles += now - SwitchTime;
+  SwitchTime = now;
   pt = RunPt;    // search for highest thread not blocked or sleeping
   bestPt = 0;
-  do{
-    pt = pt->next; // skips at least one
-    if((pt->Priority < priority)&&((pt->BlockPt)==0)&&((pt->Sleep)==0)){
-      priority = pt->Priority;
+  for(i=0; i<NumThread; i++){ // look at all possible threads
+    pt = pt->next; // skips at least one, RunPt is last
+    if(((pt->BlockPt)==0)&&((pt->Sleep)==0)&&((bestPt==0)||earlier(pt, bestPt))){
       bestPt = pt;
     }
-  }  while(RunPt != pt); // look at all possible threads
+  }
   if(bestPt){
+    if(bestPt != RunPt){
+      bestPt->Switches++;
+      TRACEEVENT(TRACE_SWITCH, bestPt->Id, RunPt->Id);
+    }
+    if(bestPt->Waking){     // OS_Signal or sleep end to run
+      if(now - bestPt->WakeTime > bestPt->MaxLatency){
+        bestPt->MaxLatency = now - bestPt->WakeTime;
+      }
+      bestPt->Waking = 0;
+    }
     RunPt = bestPt; 
+#if STACKMPU
+    MPU_RBAR = (uint32_t)RunPt->Stack|0x10; // region 0 guards its stack
+#endif
   }else{
+    Trace_Stop(); // keep the events that led here
     while(1){}; // crash
   }
 }
@@ -180,54 +416,32 @@ void Scheduler(void){      // every time slice
 // Outputs: none
 // Will be run again depending on sleep/block status
 void OS_Suspend(void){
-  STCURRENT = 0;        // any write to current clears it
-  INTCTRL = 0x04000000; // trigger SysTick
-// next thread gets a full time slice
+  INTCTRL = 0x10000000; // trigger PendSV
+// SysTick keeps counting, so the time slice is not reset
 }
 // ******** OS_Kill ************
 // kill the currently running thread, release its TCB memory
 // input:  none
 // output: none
-tcbType *previousPt;   // Pointer to previous thread in list before current thread
-tcbType *nextPt;       // Pointer to next thread in list after current thread
+// constant time, the doubly linked list has the previous thread
 tcbType *killPt;       // Pointer to thread being killed
 // RunPt will point to thread will be killed 
 void OS_Kill(void){  // no local variables allowed
   DisableInterrupts();        // atomic
   NumThread--;
   if(NumThread==0){
+    Trace_Stop(); // keep the events that led here
     for(;;){};     // crash
   }
-  RunPt->Sleep = 0xFFFFFFFF;  // can't rerun this thread, it will be dead
   killPt = RunPt;             // kill current thread
-  Scheduler();                // RunPt points to thread to run next
-//********initially RunPt points to thread to kill********
-//               /----\           /----\          /----\
-//               |    |  killPt-> |    |          |    |
-//               |next----------> |next---------> |next--->
-//               |    |           |    |          |    |
-//               \----/           \----/          \----/
-  killPt->Id = 0;         // mark as free
- 
-  previousPt = killPt;    // eventually, it will point to previous thread 
-  nextPt = killPt->next;  // nextPt points to the thread after 
-  while((previousPt->next)!=killPt){
-    previousPt = previousPt->next;  
-  }
-//****previousPt -> one before, RunPt to thread to kill *********
-//               /----\           /----\          /----\
-// previousPt -> |    |  killPt-> |    | nextPt-> |    |
-//               |next----------> |next---------> |next--->
-//               |    |           |    |          |    |
-//               \----/           \----/          \----/
-  previousPt->next = nextPt; // remove from list
-//****remove thread which we are killing *********
-//               /----\                           /----\
-// previousPt -> |    |                  nextPt-> |    |
-//               |next--------------------------> |next--->
-//               |    |                           |    |
-//               \----/                           \----/
-  STCURRENT = 0;        // next thread get full slice
+  TRACEEVENT(TRACE_KILL, killPt->Id, 0);
+  KillTcb.next = killPt->next;
+  Thread_Unlink(killPt);      // remove from list
+  Thread_Release(killPt);     // TCB and stack free, still running on the stack
+// PendSV saves this dead context into KillTcb, then
+// Scheduler searches the NumThread threads starting at KillTcb.next
+// no thread can be created, and reuse the stack, before then
+  RunPt = &KillTcb;
   EnableInterrupts();
   INTCTRL = 0x10000000; // trigger pendSV to start next thread
   for(;;){};            // can not return
@@ -238,6 +452,7 @@ void OS_Kill(void){  // no local variables allowed
 // output: none
 // OS_Sleep(0) implements cooperative multitasking
 void OS_Sleep(uint32_t sleepTime){
+  TRACEEVENT(TRACE_SLEEP, RunPt->Id, sleepTime);
   RunPt->Sleep = sleepTime; // match to BSP_periodic ISR
   OS_Suspend();     // stops running
 }
@@ -264,9 +479,12 @@ void OS_Wait(int32_t *semaPt){
  // int32_t status;
   //status = StartCritical();
   DisableInterrupts();
+  TRACEEVENT(TRACE_WAIT, RunPt->Id, (uint32_t)semaPt);
   *semaPt = *semaPt - 1;
   if(*semaPt < 0){
     RunPt->BlockPt = semaPt; // block
+    RunPt->BlockTime = DWT_CYCCNT;
+    TRACEEVENT(TRACE_BLOCK, RunPt->Id, (uint32_t)semaPt);
    // EndCritical(status); // end critical section
     EnableInterrupts();
     OS_Suspend();        // this thread stops running
@@ -276,6 +494,21 @@ void OS_Wait(int32_t *semaPt){
  // EndCritical(status);   // end critical section
 }
 
+// add one blocking to the statistics of a semaphore
+void static semstat(int32_t *semaPt, uint32_t blocked){int i;
+  for(i=0; i<NUMSEMSTATS; i++){
+    if((SemStats[i].SemaPt == semaPt)||(SemStats[i].SemaPt == 0)){
+      SemStats[i].SemaPt = semaPt;  // first use takes a free entry
+      SemStats[i].Blocks++;
+      SemStats[i].BlockedCycles += blocked;
+      if(blocked > SemStats[i].MaxBlocked){
+        SemStats[i].MaxBlocked = blocked;
+      }
+      return;
+    }
+  }                                 // table full, not counted
+}
+
 // ******** OS_Signal ************
 // Increment semaphore
 // Lab2 spinlock
@@ -284,8 +517,10 @@ void OS_Wait(int32_t *semaPt){
 // Outputs: none
 void OS_Signal(int32_t *semaPt){
   tcbType *searchPt;
+  uint32_t now;
   int32_t status;
   status = StartCritical();
+  TRACEEVENT(TRACE_SIGNAL, RunPt->Id, (uint32_t)semaPt);
   *semaPt = *semaPt + 1;
   if((*semaPt) < 1){
     searchPt = RunPt->next;
@@ -293,6 +528,15 @@ void OS_Signal(int32_t *semaPt){
       searchPt = searchPt->next; // find one blocked on this semaphore
     }
     searchPt->BlockPt = 0; // wake up first one it finds
+    now = DWT_CYCCNT;
+    searchPt->BlockedCycles += now - searchPt->BlockTime;
+    semstat(semaPt, now - searchPt->BlockTime);
+    searchPt->WakeTime = now;
+    searchPt->Waking = 1;
+    TRACEEVENT(TRACE_WAKE, searchPt->Id, (uint32_t)semaPt);
+    if(earlier(searchPt, RunPt)){
+      INTCTRL = 0x10000000; // trigger PendSV, preempt for higher priority
+    }
   }
   EndCritical(status);
 }
@@ -329,11 +573,13 @@ void OS_FIFO_Init(void){
 int OS_FIFO_Put(uint32_t data){
   if(CurrentSize == FSIZE){
     LostData++;
+    TRACEEVENT(TRACE_FIFOLOST, RunPt->Id, CurrentSize);
     return -1;  // full
   } else{
     Fifo[PutI] = data;       // Put
     PutI = (PutI+1)%FSIZE;
     OS_Signal(&CurrentSize);
+    TRACEEVENT(TRACE_FIFOPUT, RunPt->Id, CurrentSize);
     return 0;   // success
   }
 }
@@ -349,6 +595,7 @@ uint32_t OS_FIFO_Get(void){uint32_t data;
   OS_Wait(&CurrentSize);   // block if empty
   data = Fifo[GetI];       // get
   GetI = (GetI+1)%FSIZE;   // place to get next
+  TRACEEVENT(TRACE_FIFOGET, RunPt->Id, CurrentSize);
   return data;
 }
 // *****periodic events****************
@@ -356,15 +603,25 @@ int32_t *PeriodicSemaphore0;
 uint32_t Period0; // time between signals
 int32_t *PeriodicSemaphore1;
 uint32_t Period1; // time between signals
+int32_t static RealCount = -10; // let all the threads execute once
+// the smaller of next and ms until RealTimeEvents signals every period
+uint32_t static realnext(uint32_t next, uint32_t period){uint32_t ms;
+  if(RealCount < 0){
+    ms = -RealCount;
+  }else{
+    ms = period - (RealCount%period);
+  }
+  return (ms < next) ? ms : next;
+}
 void RealTimeEvents(void){int flag=0;
-  static int32_t realCount = -10; // let all the threads execute once
-  realCount++;
-  if(realCount >= 0){
-    if((realCount%Period0)==0){
+  TRACEEVENT(TRACE_ISRENTER, RunPt->Id, TRACE_T32);
+  RealCount++;
+  if(RealCount >= 0){
+    if((RealCount%Period0)==0){
       OS_Signal(PeriodicSemaphore0);
       flag = 1;
     }
-    if((realCount%Period1)==0){
+    if((RealCount%Period1)==0){
       OS_Signal(PeriodicSemaphore1);
       flag=1;
     }
@@ -372,6 +629,7 @@ void RealTimeEvents(void){int flag=0;
       OS_Suspend();
     }
   }
+  TRACEEVENT(TRACE_ISREXIT, RunPt->Id, TRACE_T32);
 }
 // ******** OS_PeriodTrigger0_Init ************
 // Initialize periodic timer interrupt to signal 
@@ -396,21 +654,399 @@ void OS_PeriodTrigger1_Init(int32_t *semaPt, uint32_t period){
   BSP_PeriodicTask_Init(&RealTimeEvents,1000,0);
 }
 
-//****edge-triggered event************
-int32_t *edgeSemaphore;
+//****low-power idle************
+// OS_Launch adds a kernel idle thread below every other priority.
+// It sleeps in LPM0 (CPU off, clocks on) until the next interrupt,
+// or, after OS_LowPower(3), in LPM3 (only ACLK and BCLK on) for as
+// long as no thread sleep or RealTimeEvents signal is due.  The
+// 1 kHz SysTick, sleep and RealTimeEvents timers stop in LPM3, so
+// on waking OS_MsTime, OS_TickCount, the sleep counters and the
+// RealTimeEvents count are advanced by the time slept, measured
+// with the RTC prescaler (like ValvanoWare/LowPower_MSP432), which
+// counts REFO at 32,768 Hz in every mode.  A thread sleep or signal
+// that is due is always left for the timer ISR, so it happens on time.
+#define IDLEPRIORITY 255   // below every application thread
+#define IDLESTACK    40    // words of stack for the idle thread
+#define IDLELPM3MS   4     // LPM3 only if nothing is due for this many ms
+#define IDLEMAXMS    1000  // longest LPM3, the RTC prescaler wraps at 2 s
+uint32_t static LowPowerMode=0;   // deepest mode allowed, 0 or 3
+uint32_t static SliceCycles;      // bus cycles per time slice
+uint32_t static IdleFraction;     // ms slept, not yet counted, in 1/4096 ms
+uint64_t static Lpm0Counts;       // RTC counts (32,768/s) in LPM0
+uint64_t static Lpm3Counts;       // RTC counts in LPM3
+uint32_t static Lpm3Entries;      // times LPM3 was entered
+
+// ms until a thread sleep ends, a debounced pin is re-armed
+// or RealTimeEvents signals, at most IDLEMAXMS
+uint32_t static nextwakeup(void){int i;
+  uint32_t next = IDLEMAXMS;
+  tcbType *pt = RunPt;
+  for(i=0; i<NumThread; i++){
+    if((pt->Sleep > 0)&&(pt->Sleep < next)){
+      next = pt->Sleep;
+    }
+    pt = pt->next;
+  }
+  next = edgenext(next);    // debounced pins
+  if(PeriodicSemaphore0){   // RealTimeEvents is running
+    next = realnext(next, Period0);
+    if(PeriodicSemaphore1){
+      next = realnext(next, Period1);
+    }
+  }
+  return next;
+}
+// advance the 1 kHz kernel time by ms, while the timers were stopped
+// ms is less than nextwakeup(), so nothing becomes due
+void static catchup(uint32_t ms){int i;
+  tcbType *pt = RunPt;
+  OS_MsTime = OS_MsTime + ms;
+  OS_TickCount = OS_TickCount + (ms*CyclesPerMs)/SliceCycles;
+  RealCount = RealCount + ms;
+  edgecatchup(ms);
+  for(i=0; i<NumThread; i++){
+    if(pt->Sleep > 0){
+      pt->Sleep = pt->Sleep - ms;
+    }
+    pt = pt->next;
+  }
+}
+// wake from LPM3 within ms, using the RTC prescaler interrupt
+// with the longest interval 2^n/32,768 s that is at most ms
+void static rtcwake(uint32_t ms){uint32_t n = 6; // 1.95 ms
+  while((n < 15)&&((1000U<<(n+1)) <= ms*32768)){
+    n++;                      // at most 2^15, 1 s
+  }
+  if(n <= 8){                 // RT0PS, 32,768 Hz divided by 2^n
+    RTCPS1CTL = 0;
+    RTCPS0CTL = ((n-1)<<2)|0x0002; // RT0IP, RT0PSIE
+  }else{                      // RT1PS, 128 Hz divided by 2^(n-8)
+    RTCPS0CTL = 0;
+    RTCPS1CTL = ((n-9)<<2)|0x0002; // RT1IP, RT1PSIE
+  }
+}
+void RTC_C_IRQHandler(void){
+  RTCPS0CTL = 0;              // acknowledge and disarm, one wake only
+  RTCPS1CTL = 0;
+}
+void static idle(void){uint32_t ms, start, counts;
+  while(1){
+    DisableInterrupts();      // an interrupt still ends WaitForInterrupt
+    ms = nextwakeup();
+    start = RTCPS;
+    if((LowPowerMode == 3)&&(ms >= IDLELPM3MS)){
+      rtcwake(ms-1);
+      PCMCTL0 = 0x695A0000|(PCMCTL0&0x0000000F); // LPMR=0, deep sleep is LPM3
+      SCB_SCR |= SCB_SCR_SLEEPDEEP;
+      WaitForInterrupt();     // HFXT restarts on wake
+      SCB_SCR &= ~SCB_SCR_SLEEPDEEP;
+      RTCPS0CTL = 0;          // woken by something else
+      RTCPS1CTL = 0;
+      counts = (uint16_t)(RTCPS - start);
+      Lpm3Counts = Lpm3Counts + counts;
+      Lpm3Entries++;
+      IdleFraction = IdleFraction + counts*125; // 1000/32768 = 125/4096
+      ms = ms-1;              // the due event is left to the timer ISR
+      if((IdleFraction>>12) < ms){
+        ms = IdleFraction>>12;
+      }
+      IdleFraction = IdleFraction - (ms<<12);
+      catchup(ms);
+    }else{
+      WaitForInterrupt();     // LPM0, the 1 kHz timers keep running
+      Lpm0Counts = Lpm0Counts + (uint16_t)(RTCPS - start);
+    }
+    EnableInterrupts();       // run the ISR that woke us
+  }
+}
+// start the RTC prescaler from REFO and add the idle thread
+void static idlestart(uint32_t theTimeSlice){
+  SliceCycles = theTimeSlice;
+  CSKEY = 0x695A;             // unlock CS module
+  CSCTL1 |= 0x00001000;       // SELB, BCLK from REFO, on in LPM3
+  CSKEY = 0;                  // lock CS module
+  SYSCTL_SRAM_BANKRET |= 0x000000FE; // keep all SRAM banks in LPM3
+  RTCCTL0_H = RTCKEY_H;       // unlock RTC key protected registers
+  RTCCTL1 = RTCHOLD|RTCMODE;  // calendar mode, held
+  RTCCTL1 &= ~RTCHOLD;        // start the RTC and its prescalers
+  RTCCTL0_H = 0;              // lock the RTC registers
+  RTCPS0CTL = 0;
+  RTCPS1CTL = 0;
+  NVIC_IPR7 = (NVIC_IPR7&0xFFFF00FF)|0x00004000; // priority 2, RTC_C is interrupt 29
+  NVIC_ISER0 = 0x20000000;    // enable interrupt 29 in NVIC
+  addthread(&idle, IDLEPRIORITY, IDLESTACK);
+}
+// ******** OS_LowPower ************
+// Choose the deepest mode the idle thread may sleep in
+// 0: LPM0, woken every ms by the kernel timers (the default)
+// 3: LPM3 whenever nothing is due for IDLELPM3MS ms; SMCLK and
+//    MCLK stop, so use it only if no interrupt depends on them
+//    (e.g. not with Sound.c, which runs on Timer A2)
+// Inputs:  mode 0 or 3
+// Outputs: none
+void OS_LowPower(uint32_t mode){
+  LowPowerMode = mode;
+}
+// ******** OS_PowerReport ************
+// Time spent in each power mode since OS_Launch
+// Inputs:  pointer to the report to fill
+// Outputs: none
+void OS_PowerReport(powerStatType *report){int32_t status;
+  status = StartCritical();
+  report->Lpm0Ms = (Lpm0Counts*125)>>12;
+  report->Lpm3Ms = (Lpm3Counts*125)>>12;
+  report->ActiveMs = OS_MsTime - report->Lpm0Ms - report->Lpm3Ms;
+  report->Lpm3Entries = Lpm3Entries;
+  EndCritical(status);
+}
+
+//****edge-triggered events************
+// A table of pins on PORT1 to PORT6, each signaling a semaphore
+// and/or calling a function on a falling edge, rising edge or both.
+// Without debouncing, the event happens in the port ISR.  With a
+// debounce time, the first edge disarms the pin and records the
+// time, runperiodicevents re-arms it the given number of ms later,
+// and the event happens then, only if the settled level is a new
+// level in a requested direction, so bounces and short glitches
+// make no events and no thread has to sleep to debounce.
+#define NUMEDGES 8           // maximum number of edge-triggered pins
+struct edge{
+  uint32_t Port;     // 1 to 6, 0 if the entry is free
+  uint8_t Mask;      // bit of the pin in the port registers
+  uint8_t Flags;     // EDGE_FALL, EDGE_RISE, EDGE_PULLUP, EDGE_ONESHOT
+  uint8_t Level;     // pin level after the last event, 0 or 1
+  uint8_t Armed;     // 0 after a one-shot event, until OS_EdgeEvent_Arm
+  int32_t *SemaPt;   // semaphore to signal, 0 for none
+  void(*Task)(uint32_t level); // function to call in the ISR, 0 for none
+  uint32_t Debounce; // ms from the first edge to the event, 0 for none
+  uint32_t Rearm;    // ms left until re-armed, 0 if armed
+  uint32_t Time;     // DWT_CYCCNT at the first edge of the last event
+  uint32_t Count;    // number of events
+};
+typedef struct edge edgeType;
+edgeType Edges[NUMEDGES];
+struct edgeport{
+  volatile uint8_t *In, *Out, *Dir, *Ren, *Sel0, *Sel1, *Ies, *Ie, *Ifg;
+};
+const struct edgeport EdgePorts[6] = {
+  {&P1IN, &P1OUT, &P1DIR, &P1REN, &P1SEL0, &P1SEL1, &P1IES, &P1IE, &P1IFG},
+  {&P2IN, &P2OUT, &P2DIR, &P2REN, &P2SEL0, &P2SEL1, &P2IES, &P2IE, &P2IFG},
+  {&P3IN, &P3OUT, &P3DIR, &P3REN, &P3SEL0, &P3SEL1, &P3IES, &P3IE, &P3IFG},
+  {&P4IN, &P4OUT, &P4DIR, &P4REN, &P4SEL0, &P4SEL1, &P4IES, &P4IE, &P4IFG},
+  {&P5IN, &P5OUT, &P5DIR, &P5REN, &P5SEL0, &P5SEL1, &P5IES, &P5IE, &P5IFG},
+  {&P6IN, &P6OUT, &P6DIR, &P6REN, &P6SEL0, &P6SEL1, &P6IES, &P6IE, &P6IFG}
+};
+
+// set the pin to interrupt on the edge away from the level it is at
+void static edgewatch(edgeType *pt, uint32_t level){
+  const struct edgeport *port = &EdgePorts[pt->Port-1];
+  if(level){
+    *(port->Ies) |= pt->Mask;   // high now, next edge is falling
+  }else{
+    *(port->Ies) &= ~pt->Mask;  // low now, next edge is rising
+  }
+  *(port->Ifg) &= ~pt->Mask;    // writing IES may set the flag
+}
+// the pin is now at a new level; signal if it is a requested edge
+void static edgeevent(edgeType *pt, uint32_t level){
+  pt->Level = level;
+  if(((level == 0)&&(pt->Flags&EDGE_FALL))||((level)&&(pt->Flags&EDGE_RISE))){
+    pt->Count++;
+    if(pt->Flags&EDGE_ONESHOT){
+      pt->Armed = 0;
+    }
+    if(pt->SemaPt){
+      OS_Signal(pt->SemaPt);
+    }
+    if(pt->Task){
+      (*pt->Task)(level);
+    }
+  }
+}
+void static edgeinterrupt(uint32_t port){int i;
+  const struct edgeport *regs = &EdgePorts[port-1];
+  edgeType *pt;
+  uint32_t level;
+  TRACEEVENT(TRACE_ISRENTER, RunPt->Id, TRACE_PORT1-1+port);
+  for(i=0; i<NUMEDGES; i++){
+    pt = &Edges[i];
+    if((pt->Port == port)&&(*(regs->Ifg)&*(regs->Ie)&pt->Mask)){
+      *(regs->Ifg) &= ~pt->Mask;  // acknowledge
+      pt->Time = DWT_CYCCNT;
+      if(pt->Debounce){
+        *(regs->Ie) &= ~pt->Mask; // disarm while it bounces
+        pt->Rearm = pt->Debounce;
+      }else{
+        level = ((*(regs->In))&pt->Mask) != 0;
+        if((pt->Flags&EDGE_BOTH) == EDGE_BOTH){
+          edgewatch(pt, level);
+        }else{
+          level = ((pt->Flags&EDGE_RISE) != 0); // the edge it is set for
+        }
+        edgeevent(pt, level);
+        if(pt->Armed == 0){
+          *(regs->Ie) &= ~pt->Mask; // one-shot, until OS_EdgeEvent_Arm
+        }
+      }
+    }
+  }
+  TRACEEVENT(TRACE_ISREXIT, RunPt->Id, TRACE_PORT1-1+port);
+}
+void PORT1_IRQHandler(void){ edgeinterrupt(1); }
+void PORT2_IRQHandler(void){ edgeinterrupt(2); }
+void PORT3_IRQHandler(void){ edgeinterrupt(3); }
+void PORT4_IRQHandler(void){ edgeinterrupt(4); }
+void PORT5_IRQHandler(void){ edgeinterrupt(5); }
+void PORT6_IRQHandler(void){ edgeinterrupt(6); }
+
+// called every ms by runperiodicevents, re-arm debounced pins
+// and make the event if the settled level is new
+void static edgerearm(void){int i;
+  edgeType *pt;
+  uint32_t level;
+  for(i=0; i<NUMEDGES; i++){
+    pt = &Edges[i];
+    if(pt->Rearm){
+      pt->Rearm--;
+      if(pt->Rearm == 0){
+        level = ((*(EdgePorts[pt->Port-1].In))&pt->Mask) != 0;
+        edgewatch(pt, level);     // both edges, to follow the level
+        if(level != pt->Level){
+          edgeevent(pt, level);
+        }
+        if(pt->Armed){
+          *(EdgePorts[pt->Port-1].Ie) |= pt->Mask;
+        }
+      }
+    }
+  }
+}
+// the smaller of next and ms until a debounced pin is re-armed
+uint32_t static edgenext(uint32_t next){int i;
+  for(i=0; i<NUMEDGES; i++){
+    if((Edges[i].Rearm)&&(Edges[i].Rearm < next)){
+      next = Edges[i].Rearm;
+    }
+  }
+  return next;
+}
+// advance the debounce times by ms, less than edgenext()
+void static edgecatchup(uint32_t ms){int i;
+  for(i=0; i<NUMEDGES; i++){
+    if(Edges[i].Rearm){
+      Edges[i].Rearm = Edges[i].Rearm - ms;
+    }
+  }
+}
+
+// ******** OS_EdgeEvent_Add ************
+// Make a pin signal a semaphore and/or call a function on its edges
+// Inputs:  port 1 to 6
+//          pin 0 to 7
+//          flags EDGE_FALL, EDGE_RISE or EDGE_BOTH, plus
+//            EDGE_PULLUP to enable the internal pull-up resistor
+//            EDGE_ONESHOT to disarm after each event until OS_EdgeEvent_Arm
+//          semaPt semaphore to signal, 0 for none
+//          task function to call with the new level (runs in an ISR), 0 for none
+//          debounce ms the level must settle for, 0 for clean signals
+//          priority 0 to 7 of the port interrupt, shared by its pins
+// Outputs: handle for the other OS_EdgeEvent functions,
+//          0 if the table is full or the port or pin is invalid
+int OS_EdgeEvent_Add(uint32_t port, uint32_t pin, uint32_t flags,
+  int32_t *semaPt, void(*task)(uint32_t level), uint32_t debounce, uint8_t priority){
+  int i;
+  int32_t status;
+  const struct edgeport *regs;
+  edgeType *pt;
+  if((port < 1)||(port > 6)||(pin > 7)||((flags&EDGE_BOTH) == 0)){
+    return 0;
+  }
+  status = StartCritical();
+  for(i=0; i<NUMEDGES; i++){
+    if(Edges[i].Port == 0){
+      break;
+    }
+  }
+  if(i == NUMEDGES){
+    EndCritical(status);
+    return 0;                       // table full
+  }
+  pt = &Edges[i];
+  regs = &EdgePorts[port-1];
+  pt->Port = port;
+  pt->Mask = 1<<pin;
+  pt->Flags = flags;
+  pt->SemaPt = semaPt;
+  pt->Task = task;
+  pt->Debounce = debounce;
+  pt->Rearm = 0;
+  pt->Count = 0;
+  pt->Armed = 1;
+  *(regs->Sel0) &= ~pt->Mask;       // GPIO
+  *(regs->Sel1) &= ~pt->Mask;
+  *(regs->Dir) &= ~pt->Mask;        // input
+  if(flags&EDGE_PULLUP){
+    *(regs->Ren) |= pt->Mask;       // enable pull resistor
+    *(regs->Out) |= pt->Mask;       // pull-up
+  }
+  pt->Level = ((*(regs->In))&pt->Mask) != 0;
+  if(debounce||((flags&EDGE_BOTH) == EDGE_BOTH)){
+    edgewatch(pt, pt->Level);       // follow the level
+  }else if(flags&EDGE_FALL){
+    *(regs->Ies) |= pt->Mask;       // falling edge event
+  }else{
+    *(regs->Ies) &= ~pt->Mask;      // rising edge event
+  }
+  *(regs->Ifg) &= ~pt->Mask;        // clear flag
+  *(regs->Ie) |= pt->Mask;          // arm interrupt on the pin
+  ((volatile uint8_t *)&NVIC_IPR0)[34+port] = priority<<5; // PORT1 is interrupt 35
+  NVIC_ISER1 = 1<<(port+2);         // enable interrupt 34+port in NVIC
+  EndCritical(status);
+  return i+1;
+}
+// ******** OS_EdgeEvent_Arm ************
+// Re-arm a pin added with EDGE_ONESHOT after its event
+// Inputs:  handle from OS_EdgeEvent_Add
+// Outputs: none
+void OS_EdgeEvent_Arm(int handle){int32_t status;
+  edgeType *pt = &Edges[handle-1];
+  status = StartCritical();
+  pt->Armed = 1;
+  if(pt->Rearm == 0){               // else armed when it has settled
+    if(pt->Debounce||((pt->Flags&EDGE_BOTH) == EDGE_BOTH)){
+      pt->Level = ((*(EdgePorts[pt->Port-1].In))&pt->Mask) != 0;
+      edgewatch(pt, pt->Level);     // it may have changed while disarmed
+    }
+    *(EdgePorts[pt->Port-1].Ifg) &= ~pt->Mask; // ignore edges while disarmed
+    *(EdgePorts[pt->Port-1].Ie) |= pt->Mask;
+  }
+  EndCritical(status);
+}
+// ******** OS_EdgeEvent_Time ************
+// Time of the most recent event, at its first edge
+// Inputs:  handle from OS_EdgeEvent_Add
+// Outputs: DWT_CYCCNT, bus cycles, when the edge occurred
+uint32_t OS_EdgeEvent_Time(int handle){
+  return Edges[handle-1].Time;
+}
+// ******** OS_EdgeEvent_Level ************
+// Pin level after the most recent event
+// Inputs:  handle from OS_EdgeEvent_Add
+// Outputs: 0 after a falling edge, 1 after a rising edge
+uint32_t OS_EdgeEvent_Level(int handle){
+  return Edges[handle-1].Level;
+}
+
+int static EdgeTrigger;      // handle of button1
 // ******** OS_EdgeTrigger_Init ************
 // Initialize button1, P5.1, to signal on a falling edge interrupt
+// It is disarmed after each signal, until OS_EdgeTrigger_Restart
 // Inputs:  semaphore to signal
 //          priority
 // Outputs: none
 void OS_EdgeTrigger_Init(int32_t *semaPt, uint8_t priority){
-  edgeSemaphore = semaPt;
   BSP_Button1_Init(); // P5.1 input with pullup
-  P5IES |= 0x02;                // (c) P5.1 is falling edge event
-  P5IFG &= ~0x02;               // (d) clear flag1 
-  P5IE |= 0x02;                 // (e) arm interrupt on P5.1
-  NVIC_IPR9 = (NVIC_IPR9&0x00FFFFFF)|(priority<<29); // (f) priority 
-  NVIC_ISER1 = 0x00000080;      // (g) enable interrupt 39 in NVIC
+  EdgeTrigger = OS_EdgeEvent_Add(5, 1, EDGE_FALL|EDGE_ONESHOT, semaPt, 0, 0, priority);
 }
 
 // ******** OS_EdgeTrigger_Restart ************
@@ -419,16 +1055,114 @@ void OS_EdgeTrigger_Init(int32_t *semaPt, uint8_t priority){
 // Inputs:  none
 // Outputs: none
 void OS_EdgeTrigger_Restart(void){
-  NVIC_ISER1 = 0x00000080;      // (g) enable interrupt 39 in NVIC
-  P5IFG &= ~0x02;               // (d) clear flag1 
-}
-void PORT5_IRQHandler(void){
-  // step 1 acknowledge by clearing flag
-  P5IFG &= ~0x02;               // (d) clear flag1 
-  // step 2 signal semaphore (no need to run scheduler)
-  OS_Signal(edgeSemaphore);       // signal button1 occurred
-  // step 3 disarm interrupt to prevent bouncing to create multiple signals
-  NVIC_ICER1 = 0x00000080;      // (g) disarm interrupt 39 in NVIC
+  OS_EdgeEvent_Arm(EdgeTrigger);
 }
 
+//****kernel statistics************
+void static put16(uint8_t *pt, uint32_t data){
+  pt[0] = data;                 // little endian
+  pt[1] = data>>8;
+}
+void static put32(uint8_t *pt, uint32_t data){
+  put16(pt, data);
+  put16(pt+2, data>>16);
+}
+// number of words the thread may use but has never written,
+// counted up from just above the guard and canary
+uint32_t static stackfree(tcbType *pt){uint32_t n=STACKGUARD+1;
+  while((n < pt->StackSize)&&(pt->Stack[n] == STACKPAINT)){
+    n++;
+  }
+  return n-(STACKGUARD+1);
+}
+// ******** OS_Snapshot ************
+// Pack kernel statistics into 20-byte little-endian records,
+// one BLE notification each, or send the buffer over UART0
+// record 0, header
+//   'K', version 1, number of threads, number of semaphores
+//   OS_MsTime, OS_TickCount, OS_DeadlineMisses, DWT cycles/ms
+// one record per thread, in round robin order from the running one
+//   Id, Priority, state (bit0 blocked, bit1 sleeping, bit2 periodic), 0
+//   16-bit stack words never used, 16-bit CPU use in 0.1% since
+//   the previous snapshot, switched in count, most bus cycles
+//   from OS_Signal or sleep end to running, ms blocked
+// one record per semaphore threads have blocked on
+//   semaphore address, times blocked, ms blocked, most cycles
+//   blocked at once, current value
+// Inputs:  buf, at least 20 bytes
+//          size, number of bytes in buf
+// Outputs: number of bytes written, a multiple of 20,
+//          records that do not fit are left out
+int OS_Snapshot(uint8_t *buf, int size){int32_t status;
+  uint32_t i, numSems, now;
+  uint64_t dTotal, dRun;       // cycles since the last snapshot, can pass 2^32 in 90 s
+  uint8_t *pt = buf;
+  tcbType *thePt;
+  if(size < 20){
+    return 0;
+  }
+  status = StartCritical();
+  for(numSems=0; (numSems<NUMSEMSTATS)&&SemStats[numSems].SemaPt; numSems++){};
+  pt[0] = 'K';  pt[1] = 1;  pt[2] = NumThread;  pt[3] = numSems;
+  put32(pt+4, OS_MsTime);
+  put32(pt+8, OS_TickCount);
+  put32(pt+12, OS_DeadlineMisses);
+  put32(pt+16, CyclesPerMs);
+  pt = pt + 20;
+  now = DWT_CYCCNT;
+  RunPt->RunCycles += now - SwitchTime; // charge the caller up to now
+  TotalCycles += now - SwitchTime;
+  SwitchTime = now;
+  dTotal = TotalCycles - LastTotal;
+  LastTotal = TotalCycles;
+  thePt = RunPt;
+  for(i=0; (i<NumThread)&&(pt+20 <= buf+size); i++){
+    pt[0] = thePt->Id;
+    pt[1] = thePt->Priority;
+    pt[2] = (thePt->BlockPt != 0)|((thePt->Sleep != 0)<<1)|((thePt->Period != 0)<<2);
+    pt[3] = 0;
+    put16(pt+4, stackfree(thePt));
+    dRun = thePt->RunCycles - thePt->LastRun;
+    put16(pt+6, dTotal ? (dRun*1000)/dTotal : 0);
+    thePt->LastRun = thePt->RunCycles;
+    put32(pt+8, thePt->Switches);
+    put32(pt+12, thePt->MaxLatency);
+    put32(pt+16, thePt->BlockedCycles/CyclesPerMs);
+    pt = pt + 20;
+    thePt = thePt->next;
+  }
+  for(i=0; (i<numSems)&&(pt+20 <= buf+size); i++){
+    put32(pt, (uint32_t)SemStats[i].SemaPt);
+    put32(pt+4, SemStats[i].Blocks);
+    put32(pt+8, SemStats[i].BlockedCycles/CyclesPerMs);
+    put32(pt+12, SemStats[i].MaxBlocked);
+    put32(pt+16, *(SemStats[i].SemaPt));
+    pt = pt + 20;
+  }
+  EndCritical(status);
+  return pt - buf;
+}
 
+// ******** OS_StackReport ************
+// Measure how much of its stack each thread has ever used, from
+// the paint left by OS_AddThread.  Run the application through
+// its worst case, then give each thread OS_AddThreadStack with
+// its Used plus a margin, instead of STACKSIZE.
+// Inputs:  report, array of at least max entries
+//          max, number of entries in report
+// Outputs: number of entries filled, one per thread in round
+//          robin order from the running one
+int OS_StackReport(stackReportType *report, int max){int32_t status;
+  int n;
+  tcbType *pt;
+  status = StartCritical();
+  pt = RunPt;
+  for(n=0; (n<NumThread)&&(n<max); n++){
+    report[n].Id = pt->Id;
+    report[n].Size = pt->StackSize-(STACKGUARD+1);
+    report[n].Used = report[n].Size-stackfree(pt);
+    pt = pt->next;
+  }
+  EndCritical(status);
+  return n;
+}
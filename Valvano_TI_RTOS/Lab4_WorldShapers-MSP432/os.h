@@ -45,6 +45,49 @@ void OS_Init(void);
 // stack size must be divisable by 8 (aligned to double word boundary)
 int OS_AddThread(void(*task)(void), uint32_t priority);
 
+//******** OS_AddThreadStack *************** 
+// add a foregound thread to the scheduler, with its own stack size
+// Inputs: pointer to a void/void foreground function
+//         priority (0 is highest)
+//         stackSize, number of 32-bit words of stack needed,
+//           see OS_StackReport, plus the guard and canary
+//           rounded up to a size class in Thread.c
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddThreadStack(void(*task)(void), uint32_t priority, uint32_t stackSize);
+
+//******** OS_AddPeriodicThread *************** 
+// add a periodic thread; threads of equal priority run
+// earliest deadline first, ahead of equal priority threads
+// that are not periodic, which run round robin
+// The thread loops, calling OS_WaitPeriod after each job
+// Admission: for each priority level of a periodic thread, the
+// densities Wcet/min(Deadline,Period), rounded up to 0.1%, of
+// all periodic threads at that or higher priority must total
+// at most 1, which is exact for EDF when Deadline equals Period.
+// A new thread is checked at its own level and every lower one.
+// Inputs: pointer to a void/void foreground function
+//         priority (0 is highest)
+//         period, deadline and wcet in ms
+//         (deadline 0 means equal to the period)
+// Outputs: 1 if successful, 0 if this thread can not be added
+int OS_AddPeriodicThread(void(*task)(void), uint32_t priority,
+  uint32_t period, uint32_t deadline, uint32_t wcet);
+
+//******** OS_WaitPeriod *************** 
+// called by a periodic thread when its job is done
+// counts a miss if past its deadline, then sleeps
+// until its next release, which is one period after the last
+// Inputs: none
+// Outputs: none
+void OS_WaitPeriod(void);
+
+//******** OS_Misses *************** 
+// number of late jobs of the running periodic thread
+// Input:  none
+// Output: misses, total over all threads is OS_DeadlineMisses
+uint32_t OS_Misses(void);
+extern uint32_t OS_DeadlineMisses;
+
 // ****OS_Id**********
 // returns the Id for the currently running thread
 // Input:  none
@@ -54,6 +97,8 @@ uint32_t OS_Id(void);
 
 //******** OS_Launch ***************
 // Start the scheduler, enable interrupts
+// Adds the kernel idle thread, so the application needs none,
+// see OS_LowPower
 // Inputs: number of clock cycles for each time slice
 // Outputs: none (does not return)
 // Errors: theTimeSlice must be less than 16,777,216
@@ -148,8 +193,53 @@ void OS_PeriodTrigger0_Init(int32_t *semaPt, uint32_t period);
 // Outputs: none
 void OS_PeriodTrigger1_Init(int32_t *semaPt, uint32_t period);
 
+// ******** OS_EdgeEvent_Add ************
+// Make a pin signal a semaphore and/or call a function on its edges
+// Without debouncing, the event happens in the port ISR.  With a
+// debounce time, the first edge disarms the pin, and the event
+// happens debounce ms later, only if the pin has settled at a new
+// level in a requested direction, so no thread has to sleep to
+// debounce.  PORT1_IRQHandler to PORT6_IRQHandler are in os.c.
+// Inputs:  port 1 to 6
+//          pin 0 to 7
+//          flags EDGE_FALL, EDGE_RISE or EDGE_BOTH, plus
+//            EDGE_PULLUP to enable the internal pull-up resistor
+//            EDGE_ONESHOT to disarm after each event until OS_EdgeEvent_Arm
+//          semaPt semaphore to signal, 0 for none
+//          task function to call with the new level (runs in an ISR), 0 for none
+//          debounce ms the level must settle for, 0 for clean signals
+//          priority 0 to 7 of the port interrupt, shared by its pins
+// Outputs: handle for the other OS_EdgeEvent functions,
+//          0 if the table is full or the port or pin is invalid
+#define EDGE_FALL    0x01
+#define EDGE_RISE    0x02
+#define EDGE_BOTH    0x03
+#define EDGE_PULLUP  0x04
+#define EDGE_ONESHOT 0x08
+int OS_EdgeEvent_Add(uint32_t port, uint32_t pin, uint32_t flags,
+  int32_t *semaPt, void(*task)(uint32_t level), uint32_t debounce, uint8_t priority);
+
+// ******** OS_EdgeEvent_Arm ************
+// Re-arm a pin added with EDGE_ONESHOT after its event
+// Inputs:  handle from OS_EdgeEvent_Add
+// Outputs: none
+void OS_EdgeEvent_Arm(int handle);
+
+// ******** OS_EdgeEvent_Time ************
+// Time of the most recent event, at its first edge
+// Inputs:  handle from OS_EdgeEvent_Add
+// Outputs: DWT_CYCCNT, bus cycles, when the edge occurred
+uint32_t OS_EdgeEvent_Time(int handle);
+
+// ******** OS_EdgeEvent_Level ************
+// Pin level after the most recent event
+// Inputs:  handle from OS_EdgeEvent_Add
+// Outputs: 0 after a falling edge, 1 after a rising edge
+uint32_t OS_EdgeEvent_Level(int handle);
+
 // ******** OS_EdgeTrigger_Init ************
 // Initialize button1, P5.1, to signal on a falling edge interrupt
+// It is disarmed after each signal, until OS_EdgeTrigger_Restart
 // Inputs:  semaphore to signal
 //          priority
 // Outputs: none
@@ -162,5 +252,75 @@ void OS_EdgeTrigger_Init(int32_t *semaPt, uint8_t priority);
 // Outputs: none
 void OS_EdgeTrigger_Restart(void);
 
+// ******** OS_Snapshot ************
+// Pack kernel statistics into 20-byte little-endian records,
+// one BLE notification each, or send the buffer over UART0
+// record 0, header
+//   'K', version 1, number of threads, number of semaphores
+//   OS_MsTime, OS_TickCount, OS_DeadlineMisses, DWT cycles/ms
+// one record per thread, in round robin order from the running one
+//   Id, Priority, state (bit0 blocked, bit1 sleeping, bit2 periodic), 0
+//   16-bit stack words never used, 16-bit CPU use in 0.1% since
+//   the previous snapshot, switched in count, most bus cycles
+//   from OS_Signal or sleep end to running, ms blocked
+// one record per semaphore threads have blocked on
+//   semaphore address, times blocked, ms blocked, most cycles
+//   blocked at once, current value
+// Inputs:  buf, at least 20 bytes
+//          size, number of bytes in buf
+// Outputs: number of bytes written, a multiple of 20,
+//          records that do not fit are left out
+int OS_Snapshot(uint8_t *buf, int size);
+
+// Stack overflow is caught two ways:
+// each stack has STACKCANARY in its lowest usable word, checked
+// whenever its thread is switched out, and with STACKMPU 1 in
+// Thread.h the 32 bytes below that are an MPU no-access region
+// while the thread runs, which catches the write itself.
+// Either way the kernel stops with the thread Id in OS_StackOverflow.
+extern uint32_t OS_StackOverflow;
+
+struct stackreport{
+  uint32_t Id;       // thread Id
+  uint32_t Size;     // 32-bit words the thread may use
+  uint32_t Used;     // most words it has used so far
+};
+typedef struct stackreport stackReportType;
+
+// ******** OS_StackReport ************
+// Measure how much of its stack each thread has ever used, from
+// the paint left by OS_AddThread.  Run the application through
+// its worst case, then give each thread OS_AddThreadStack with
+// its Used plus a margin, instead of STACKSIZE.
+// Inputs:  report, array of at least max entries
+//          max, number of entries in report
+// Outputs: number of entries filled, one per thread in round
+//          robin order from the running one
+int OS_StackReport(stackReportType *report, int max);
+
+// ******** OS_LowPower ************
+// Choose the deepest mode the idle thread may sleep in
+// 0: LPM0, woken every ms by the kernel timers (the default)
+// 3: LPM3 whenever nothing is due for IDLELPM3MS ms; SMCLK and
+//    MCLK stop, so use it only if no interrupt depends on them
+//    (e.g. not with Sound.c, which runs on Timer A2)
+// Inputs:  mode 0 or 3
+// Outputs: none
+void OS_LowPower(uint32_t mode);
+
+struct powerstat{
+  uint32_t ActiveMs; // ms running threads and ISRs
+  uint32_t Lpm0Ms;   // ms in LPM0
+  uint32_t Lpm3Ms;   // ms in LPM3
+  uint32_t Lpm3Entries; // times LPM3 was entered
+};
+typedef struct powerstat powerStatType;
+
+// ******** OS_PowerReport ************
+// Time spent in each power mode since OS_Launch
+// Inputs:  pointer to the report to fill
+// Outputs: none
+void OS_PowerReport(powerStatType *report);
+
 #endif
 
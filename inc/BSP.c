@@ -232,7 +232,10 @@ void static adcinit(void){
   REFCTL0 = 0x0039;                // 1) configure reference for static 2.5V
   while((REFCTL0&0x1000) == 0){};  // wait for the reference to stabilize before continuing (optional, see REF8 in errata)
 */
-  ADC14CTL0 &= ~0x00000002;        // 2) ADC14ENC = 0 to allow programming
+  // clearing ENC alone lets a timer-paced scan or stream wait for
+  // the rest of its sequence, which never comes with the timer
+  // halted, so clear CONSEQx at the same time to stop at once
+  ADC14CTL0 &= ~0x00060002;        // 2) ADC14ENC = 0 and CONSEQx = 0 to allow programming
   while(ADC14CTL0&0x00010000){};   // 3) wait for BUSY to be zero
   // 31-30 ADC14PDIV  predivider,            00b = Predivide by 1
   // 29-27 ADC14SHSx  SHM source            000b = ADC14SC bit
@@ -263,6 +266,135 @@ void static adcinit(void){
   ADC14IER1 = 0;                   // 7) no interrupts
 }
 
+// Scan mode, see BSP_Analog_StartScan()
+uint32_t static AnalogScanning = 0;      // 1 while the scan owns the ADC
+analogFrameType static volatile AnalogFrame[2]; // one is read while the other fills
+uint32_t static volatile AnalogLatest;   // index of the newest complete frame
+uint32_t static volatile AnalogCount;    // scans finished
+
+// ------------BSP_Analog_StartScan------------
+// Convert all six analog inputs of the BoosterPack in one
+// ADC14 repeat-sequence, MEM0 to MEM5, paced by Timer A3
+// output 1 (one conversion per timer edge, six edges per
+// scan).  At the end of each scan the ADC14 interrupt
+// stores the results in a frame.  While scanning,
+// BSP_Joystick_Input(), BSP_Accelerometer_Input() and
+// BSP_Microphone_Input() return values from the latest
+// frame instead of starting conversions, so tasks that
+// use different inputs no longer reprogram the ADC.
+// Input: freq is scans per second, 10 to 3,000
+//        priority is a number 0 to 6
+// Output: none
+// Assumes: BSP_Time_Init() has been called, timer A3 is not
+//          otherwise used (see BSP_Microphone_StartStream()),
+//          and the TExaS scope, which restarts the ADC at
+//          ADC14MEM6, is off
+// comment: rate is accurate if BSP_Clock_GetFreq()/96/freq is an integer
+// comment: a running scan is restarted, a running microphone stream is stopped
+void BSP_Analog_StartScan(uint32_t freq, uint8_t priority){long sr;
+  uint32_t period;
+  if((freq < 10) || (freq > 3000)){
+    return;                        // invalid input
+  }
+  if(priority > 6){
+    priority = 6;
+  }
+  sr = StartCritical();
+  AnalogLatest = 0;
+  AnalogCount = 0;
+  AnalogFrame[0].Count = 0;
+  TA3CTL &= ~0x0030;               // 1) halt Timer A3
+  NVIC_ICER1 = 0x00000002;         //    stop a microphone stream, DMA_INT1 is interrupt 33
+  DMA_ENACLR = 0x00000080;         //    and DMA channel 7, see MICDMACH
+  adcinit();                       // 2) stop any sequence, ADC14ENC = 0 to allow programming
+  // 29-27 ADC14SHSx  SHM source            111b = TA3_C1
+  // 26    ADC14SHP   SHM pulse-mode          1b = SAMPCON the sampling timer
+  // 21-19 ADC14SSELx clock source select   100b = SMCLK
+  // 18-17 ADC14CONSEQx mode select          11b = Repeat-sequence-of-channels
+  // 15-8  ADC14SHTx  sample-and-hold time 0x33 = 32 clocks
+  // 7     ADC14MSC   multiple sample         0b = each conversion needs a timer edge
+  // 4     ADC14ON    ADC14 on                1b = powered up
+  ADC14CTL0 = 0x3C263310;          // 3) timer triggered, SMCLK, repeat sequence
+  ADC14CTL1 = (0 << 16)|0x00000030;// 4) STARTADDx = 0, 14-bit
+  ADC14MCTL0 = 0x0000000F;         // 5) A15, joystick X
+  ADC14MCTL1 = 0x00000009;         //    A9, joystick Y, not end of sequence
+  ADC14MCTL2 = 0x0000000E;         //    A14, accelerometer X
+  ADC14MCTL3 = 0x0000000D;         //    A13, accelerometer Y
+  ADC14MCTL4 = 0x0000000B;         //    A11, accelerometer Z, not end of sequence
+  ADC14MCTL5 = 0x0000008A;         //    A10, microphone, end of sequence
+  ADC14IER0 = 0x00000020;          // 6) interrupt when ADC14MEM5 is loaded
+  P6SEL0 |= 0x03;
+  P6SEL1 |= 0x03;                  // 7) analog mode on P6.0/A15 and P6.1/A14
+  P4SEL0 |= 0x1D;
+  P4SEL1 |= 0x1D;                  //    analog mode on P4.0, P4.2, P4.3 and P4.4
+  TA3CTL = 0x0280;                 // 8) SMCLK, /4, stop mode
+  TA3EX0 = 0x0000;                 //    no extra divide
+  period = BSP_Clock_GetFreq()/96/freq;  // six conversions per scan
+  TA3CCR0 = period - 1;
+  TA3CCR1 = period/2;
+  TA3CCTL1 = 0x00E0;               //    output mode 7, reset/set
+// interrupts enabled in the main program after all devices initialized
+  NVIC_IPR6 = (NVIC_IPR6&0xFFFFFF00)|(priority<<5); // ADC14 is interrupt 24
+  NVIC_ISER0 = 0x01000000;         // 9) enable interrupt 24 in NVIC
+  AnalogScanning = 1;
+  ADC14CTL0 |= 0x00000002;         // 10) enable conversions
+  TA3CTL |= 0x0014;                // 11) reset and start Timer A3 in up mode
+  EndCritical(sr);
+}
+
+// ------------BSP_Analog_StopScan------------
+// Stop scanning and return the ADC to software-started
+// conversions for each input.
+// Input: none
+// Output: none
+void BSP_Analog_StopScan(void){
+  TA3CTL &= ~0x0030;               // halt Timer A3
+  NVIC_ICER0 = 0x01000000;         // disable interrupt 24 in NVIC
+  AnalogScanning = 0;
+  adcinit();                       // single sequences, no interrupts
+  ADC14MCTL1 = 0x00000089;         // joystick sequence ends at ADC14MEM1
+  ADC14MCTL4 = 0x0000008B;         // accelerometer sequence ends at ADC14MEM4
+  ADC14CTL0 |= 0x00000002;         // enable
+}
+
+void ADC14_IRQHandler(void){ uint32_t next;
+  next = AnalogLatest^1;           // the frame readers are not using
+  AnalogFrame[next].Time = BSP_Time_Get();
+  AnalogFrame[next].Count = AnalogCount + 1;
+  AnalogFrame[next].JoyX = ADC14MEM0>>4;
+  AnalogFrame[next].JoyY = ADC14MEM1>>4;
+  AnalogFrame[next].AccX = ADC14MEM2>>4;
+  AnalogFrame[next].AccY = ADC14MEM3>>4;
+  AnalogFrame[next].AccZ = ADC14MEM4>>4;
+  AnalogFrame[next].Mic = ADC14MEM5>>4; // reading ADC14MEM5 clears ADC14IFG5
+  AnalogLatest = next;
+  AnalogCount = AnalogCount + 1;   // publish
+}
+
+// ------------BSP_Analog_GetFrame------------
+// Copy the latest complete scan without disabling
+// interrupts.  The scan interrupt fills one of two frames
+// while the other is read, and the copy is retried if a
+// scan finished during it, so it can be called from any
+// thread or interrupt.
+// Input: frame is pointer to store the scan
+// Output: none
+// Assumes: BSP_Analog_StartScan() has been called
+void BSP_Analog_GetFrame(analogFrameType *frame){ uint32_t count, i;
+  do{
+    count = AnalogCount;
+    i = AnalogLatest;
+    frame->Time = AnalogFrame[i].Time;
+    frame->Count = AnalogFrame[i].Count;
+    frame->JoyX = AnalogFrame[i].JoyX;
+    frame->JoyY = AnalogFrame[i].JoyY;
+    frame->AccX = AnalogFrame[i].AccX;
+    frame->AccY = AnalogFrame[i].AccY;
+    frame->AccZ = AnalogFrame[i].AccZ;
+    frame->Mic = AnalogFrame[i].Mic;
+  } while(count != AnalogCount);   // a scan finished while copying
+}
+
 // ------------BSP_Joystick_Init------------
 // Initialize a GPIO pin for input, which corresponds
 // with BoosterPack pin J1.5 (Select button).
@@ -313,7 +445,14 @@ void BSP_Joystick_Init(void){
 // Output: none
 // Assumes: BSP_Joystick_Init() has been called
 #define SELECT    (*((volatile uint8_t *)(0x42000000+32*0x4C21+4*1)))  /* Port 4.1 Input */
-void BSP_Joystick_Input(uint16_t *x, uint16_t *y, uint8_t *select){
+void BSP_Joystick_Input(uint16_t *x, uint16_t *y, uint8_t *select){analogFrameType frame;
+  if(AnalogScanning){              // latest scan, see BSP_Analog_StartScan()
+    BSP_Analog_GetFrame(&frame);
+    *x = frame.JoyX;
+    *y = frame.JoyY;
+    *select = SELECT;
+    return;
+  }
   ADC14CTL0 &= ~0x00000002;        // 1) ADC14ENC = 0 to allow programming
   while(ADC14CTL0&0x00010000){};   // 2) wait for BUSY to be zero
   ADC14CTL1 = (ADC14CTL1&~0x001F0000) | // clear STARTADDx bit field
@@ -645,7 +784,14 @@ void BSP_Accelerometer_Init(void){
 //        z is pointer to store Z-measurement (0 to 1023)
 // Output: none
 // Assumes: BSP_Accelerometer_Init() has been called
-void BSP_Accelerometer_Input(uint16_t *x, uint16_t *y, uint16_t *z){
+void BSP_Accelerometer_Input(uint16_t *x, uint16_t *y, uint16_t *z){analogFrameType frame;
+  if(AnalogScanning){              // latest scan, see BSP_Analog_StartScan()
+    BSP_Analog_GetFrame(&frame);
+    *x = frame.AccX;
+    *y = frame.AccY;
+    *z = frame.AccZ;
+    return;
+  }
   ADC14CTL0 &= ~0x00000002;        // 1) ADC14ENC = 0 to allow programming
   while(ADC14CTL0&0x00010000){};   // 2) wait for BUSY to be zero
   ADC14CTL1 = (ADC14CTL1&~0x001F0000) | // clear STARTADDx bit field
@@ -688,7 +834,12 @@ void BSP_Microphone_Init(void){
 // Input: mic is pointer to store sound measurement (0 to 1023)
 // Output: none
 // Assumes: BSP_Microphone_Init() has been called
-void BSP_Microphone_Input(uint16_t *mic){
+void BSP_Microphone_Input(uint16_t *mic){analogFrameType frame;
+  if(AnalogScanning){              // latest scan, see BSP_Analog_StartScan()
+    BSP_Analog_GetFrame(&frame);
+    *mic = frame.Mic;
+    return;
+  }
   ADC14CTL0 &= ~0x00000002;        // 1) ADC14ENC = 0 to allow programming
   while(ADC14CTL0&0x00010000){};   // 2) wait for BUSY to be zero
   ADC14CTL1 = (ADC14CTL1&~0x001F0000) | // clear STARTADDx bit field
@@ -700,6 +851,158 @@ void BSP_Microphone_Input(uint16_t *mic){
   *mic = ADC14MEM5>>4;             // 8) P4.3/A10 result 0 to 1023
 }
 
+// The DMA controller reads its channel control structures
+// from RAM.  With 8 channels the primary structures take
+// 128 bytes on a 256-byte boundary and the alternate
+// structures follow at DMA_ATLBASE.  Each structure is
+// source end pointer, destination end pointer, control word
+// and one unused word.
+#define MICDMACH 7                 // DMA channel 7 source 7 is ADC14
+uint32_t static DMAMemory[128];    // 512 bytes, holds one 256-byte aligned table
+uint32_t static *DMAPrimary;       // control structures for channels 0 to 7
+uint32_t static *DMAAlternate;
+uint16_t static *MicBuf[2];        // ping-pong buffers
+uint32_t static MicN;              // samples per buffer
+uint32_t static MicNext;           // 0 or 1, buffer the DMA fills first
+uint32_t static MicControl;        // control word to re-arm a structure
+void (*MicTask)(uint16_t *buf, uint32_t n); // user function
+
+// ------------BSP_Microphone_StartStream------------
+// Sample the microphone at a fixed rate with no software
+// run per sample.  Timer A3 output 1 triggers each ADC14
+// conversion of P4.3/A10 (repeat-single-channel mode), and
+// DMA channel 7 moves each result into RAM, filling buf0
+// then buf1 then buf0 again (ping-pong).  When a buffer is
+// full, task runs in the DMA interrupt with that buffer
+// while the other one fills, so task must finish within
+// n sample periods.  Samples are 14-bit (0 to 16383);
+// shift right 4 to match BSP_Microphone_Input().
+// While streaming, the ADC belongs to the microphone, so
+// BSP_Joystick_Input(), BSP_Accelerometer_Input() and
+// BSP_Microphone_Input() must not be called.
+// Input: buf0, buf1 are two arrays of n samples
+//        n is samples per buffer, 1 to 1024
+//        freq is samples per second, 50 to 20,000
+//        task is a pointer to a user function
+//        priority is a number 0 to 6
+// Output: none
+// Assumes: timer A3 and DMA channel 7 are not otherwise used
+// comment: rate is accurate if BSP_Clock_GetFreq()/16/freq is an integer
+// comment: a running stream is restarted, a running scan is stopped
+void BSP_Microphone_StartStream(uint16_t *buf0, uint16_t *buf1, uint32_t n,
+  uint32_t freq, void(*task)(uint16_t *buf, uint32_t n), uint8_t priority){long sr;
+  uint32_t period;
+  if((n < 1) || (n > 1024) || (freq < 50) || (freq > 20000)){
+    return;                        // invalid input
+  }
+  if(priority > 6){
+    priority = 6;
+  }
+  sr = StartCritical();
+  MicBuf[0] = buf0;
+  MicBuf[1] = buf1;
+  MicN = n;
+  MicNext = 0;
+  MicTask = task;
+  TA3CTL &= ~0x0030;               // 1) halt Timer A3
+  NVIC_ICER0 = 0x01000000;         //    stop a scan, ADC14 is interrupt 24
+  AnalogScanning = 0;
+  NVIC_ICER1 = 0x00000002;         //    DMA_INT1 is interrupt 33
+  DMA_ENACLR = 1<<MICDMACH;
+  ADC14CTL0 &= ~0x00060002;        // 2) ADC14ENC = 0 and CONSEQx = 0 stop any sequence at once
+  while(ADC14CTL0&0x00010000){};   //    wait for BUSY to be zero
+  // 31-30 ADC14PDIV  predivider,            00b = Predivide by 1
+  // 29-27 ADC14SHSx  SHM source            111b = TA3_C1
+  // 26    ADC14SHP   SHM pulse-mode          1b = SAMPCON the sampling timer
+  // 25    ADC14ISSH  invert sample-and-hold  0b = not inverted
+  // 24-22 ADC14DIVx  clock divider         000b = /1
+  // 21-19 ADC14SSELx clock source select   100b = SMCLK
+  // 18-17 ADC14CONSEQx mode select          10b = Repeat-single-channel
+  // 15-12 ADC14SHT1x sample-and-hold time 0011b = 32 clocks
+  // 11-8  ADC14SHT0x sample-and-hold time 0011b = 32 clocks
+  // 7     ADC14MSC   multiple sample         0b = each conversion needs a timer edge
+  // 4     ADC14ON    ADC14 on                1b = powered up
+  // 1     ADC14ENC   enable conversion       0b = ADC14 disabled
+  // 0     ADC14SC    ADC14 start             0b = No start (yet)
+  ADC14CTL0 = 0x3C243310;          // 3) timer triggered, SMCLK, repeat one channel
+  ADC14CTL1 = (5 << 16)|0x00000030;// 4) STARTADDx = 5, 14-bit
+  ADC14MCTL5 = 0x0000008A;         // 5) 0 to 3.3V, channel 10
+  ADC14IER0 = 0;
+  ADC14IER1 = 0;                   //    DMA request, no interrupts
+  P4SEL0 |= 0x08;
+  P4SEL1 |= 0x08;                  // 6) analog mode on P4.3/A10
+  // 7) DMA channel 7, ping-pong between the two buffers
+  DMAPrimary = (uint32_t *)(((uint32_t)DMAMemory + 255)&~255);
+  DMA_CFG = 0x00000001;            //    master enable
+  DMA_CTLBASE = (uint32_t)DMAPrimary;
+  DMAAlternate = (uint32_t *)DMA_ATLBASE;
+  DMA_CH7_SRCCFG = 7;              //    ADC14 requests channel 7
+  // 31-30 DST_INC    destination increment  01b = half-word
+  // 29-28 DST_SIZE   destination size       01b = half-word
+  // 27-26 SRC_INC    source increment       11b = none
+  // 25-24 SRC_SIZE   source size            01b = half-word
+  // 17-14 R_POWER    arbitrate after       0000b = each transfer
+  // 13-4  N_MINUS_1  transfers minus one
+  // 2-0   CYCLE_CTRL mode                  011b = ping-pong
+  MicControl = 0x5D000003|((n - 1)<<4);
+  DMAPrimary[4*MICDMACH] = (uint32_t)&ADC14MEM5;
+  DMAPrimary[4*MICDMACH+1] = (uint32_t)&buf0[n-1];
+  DMAPrimary[4*MICDMACH+2] = MicControl;
+  DMAAlternate[4*MICDMACH] = (uint32_t)&ADC14MEM5;
+  DMAAlternate[4*MICDMACH+1] = (uint32_t)&buf1[n-1];
+  DMAAlternate[4*MICDMACH+2] = MicControl;
+  DMA_ALTCLR = 1<<MICDMACH;        //    start with the primary structure
+  DMA_USEBURSTCLR = 1<<MICDMACH;
+  DMA_REQMASKCLR = 1<<MICDMACH;
+  DMA_PRIOCLR = 1<<MICDMACH;
+  DMA_INT1_SRCCFG = 0x20|MICDMACH; //    DMA_INT1 on channel 7 done
+  DMA_ENASET = 1<<MICDMACH;
+  // 8) Timer A3 output 1 at freq, SMCLK/4 = bus clock/16
+  TA3CTL = 0x0280;                 //    SMCLK, /4, stop mode
+  TA3EX0 = 0x0000;                 //    no extra divide
+  period = BSP_Clock_GetFreq()/16/freq;
+  TA3CCR0 = period - 1;
+  TA3CCR1 = period/2;
+  TA3CCTL1 = 0x00E0;               //    output mode 7, reset/set
+// interrupts enabled in the main program after all devices initialized
+  NVIC_IPR8 = (NVIC_IPR8&0xFFFF00FF)|(priority<<13); // DMA_INT1 is interrupt 33
+  NVIC_ISER1 = 0x00000002;         //    enable interrupt 33 in NVIC
+  ADC14CTL0 |= 0x00000002;         // 9) enable conversions
+  TA3CTL |= 0x0014;                // 10) reset and start Timer A3 in up mode
+  EndCritical(sr);
+}
+
+// ------------BSP_Microphone_StopStream------------
+// Stop the timer, ADC and DMA started by
+// BSP_Microphone_StartStream() and return the ADC to
+// software-started conversions.  A partly full buffer
+// is dropped.
+// Input: none
+// Output: none
+void BSP_Microphone_StopStream(void){
+  TA3CTL &= ~0x0030;               // halt Timer A3
+  NVIC_ICER1 = 0x00000002;         // disable interrupt 33 in NVIC
+  DMA_ENACLR = 1<<MICDMACH;
+  adcinit();                       // software-started sequences again
+  ADC14CTL0 |= 0x00000002;         // enable
+}
+
+// A structure's CYCLE_CTRL reads 0 once the DMA has filled
+// its buffer.  Buffers finish in turn, so checking MicNext
+// first keeps the order even if both are done.
+// Lab1_Host/MicStreamModel.c tests this handoff on the PC.
+void DMA_INT1_IRQHandler(void){ uint32_t *done;
+  done = MicNext ? DMAAlternate : DMAPrimary;
+  while((done[4*MICDMACH+2]&0x07) == 0){
+    done[4*MICDMACH+1] = (uint32_t)&MicBuf[MicNext][MicN-1];
+    done[4*MICDMACH+2] = MicControl;  // re-arm for the next time around
+    (*MicTask)(MicBuf[MicNext], MicN);
+    MicNext = MicNext^1;
+    done = MicNext ? DMAAlternate : DMAPrimary;
+  }
+  DMA_ENASET = 1<<MICDMACH;        // restart if both buffers had filled
+}
+
 
 /* ********************** */
 /*      LCD Section       */
@@ -1974,6 +2277,8 @@ void BSP_LCD_OutUHex2(uint32_t n, int16_t textColor){
 
 int TimeIndex;               // horizontal position of next point to plot on graph (0 to 99)
 int32_t Ymax, Ymin, Yrange;  // vertical axis max, min, and range (units not specified)
+int32_t YScale;              // 100*65536/Yrange, so points are scaled without a divide
+uint32_t PlotClears;         // number of times the plot area has been cleared
 uint16_t PlotBGColor;        // background color of the plot used whenever clearing plot area
 
 // ------------BSP_LCD_Drawaxes------------
@@ -2001,8 +2306,10 @@ void BSP_LCD_Drawaxes(uint16_t axisColor, uint16_t bgColor, char *xLabel,
   Ymax = ymax;
   Ymin = ymin;
   Yrange = Ymax - Ymin;
+  YScale = (100*65536)/Yrange;
   TimeIndex = 0;
   PlotBGColor = bgColor;
+  PlotClears = PlotClears + 1;
   BSP_LCD_FillRect(0, 17, 111, 111, bgColor);
   BSP_LCD_DrawFastHLine(10, 117, 101, axisColor);
   BSP_LCD_DrawFastVLine(10, 17, 101, axisColor);
@@ -2047,8 +2354,12 @@ void BSP_LCD_Drawaxes(uint16_t axisColor, uint16_t bgColor, char *xLabel,
 //        color1 16-bit color for the point, which can be produced by BSP_LCD_Color565()
 // Output: none
 // Assumes: BSP_LCD_Init() and BSP_LCD_Drawaxes() have been called
+// 0 to 99 for ymin to ymax, without a divide
+int32_t static plotscale(int32_t data){
+  return ((int64_t)(data - Ymin)*YScale)>>16;
+}
 void BSP_LCD_PlotPoint(int32_t data1, uint16_t color1){
-  data1 = ((data1 - Ymin)*100)/Yrange;
+  data1 = plotscale(data1);
   if(data1 > 98){
     data1 = 98;
     color1 = LCD_RED;
@@ -2076,6 +2387,151 @@ void BSP_LCD_PlotIncrement(void){
   }
   BSP_LCD_DrawFastVLine(TimeIndex + 11, 17, 100, PlotBGColor);
 }
+
+// ------------BSP_LCD_PlotEnvInit------------
+// Set up a plot that draws the min to max range of
+// many samples in each column, for data that come faster
+// than columns can be drawn.  Each column only redraws the
+// pixels that differ from what was there one sweep ago, and
+// the scaling uses the multiply set up by
+// BSP_LCD_Drawaxes(), so a column costs at most a few
+// hundred bytes on the SPI no matter how many samples it
+// covers.  It moves the same column as
+// BSP_LCD_PlotIncrement(), so do not mix the two.
+// Input: p          pointer to the plot
+//        perColumn  number of samples in each column
+//        numTraces  1 or 2
+//        color1     16-bit color for the first trace
+//        color2     16-bit color for the second trace
+// Output: none
+// Assumes: BSP_LCD_Init() and BSP_LCD_Drawaxes() have been called
+void BSP_LCD_PlotEnvInit(plotEnvType *p, uint32_t perColumn, uint32_t numTraces,
+  uint16_t color1, uint16_t color2){ int i, j;
+  p->PerColumn = perColumn;
+  p->NumTraces = numTraces;
+  p->Count = 0;
+  p->Trace[0].Color = color1;
+  p->Trace[1].Color = color2;
+  for(j=0; j<2; j=j+1){
+    p->Trace[j].Min = 0x7FFFFFFF;
+    p->Trace[j].Max = -0x7FFFFFFF - 1;
+    for(i=0; i<100; i=i+1){
+      p->Trace[j].Top[i] = 1;     // nothing drawn, Top > Bottom
+      p->Trace[j].Bottom[i] = 0;
+    }
+  }
+  p->Clears = PlotClears;
+}
+
+// draw the finished column of every trace at TimeIndex,
+// erasing first so one trace does not erase another
+void static plotcolumn(plotEnvType *p){
+  int j, x = TimeIndex + 11;
+  int32_t lo, hi;
+  uint8_t top[2], bottom[2], oldTop, oldBottom;
+  uint16_t color[2];
+  if(p->Clears != PlotClears){    // axes redrawn, nothing left to erase
+    for(j=0; j<100; j=j+1){
+      p->Trace[0].Top[j] = p->Trace[1].Top[j] = 1;
+      p->Trace[0].Bottom[j] = p->Trace[1].Bottom[j] = 0;
+    }
+    p->Clears = PlotClears;
+  }
+  for(j=0; j<p->NumTraces; j=j+1){
+    lo = plotscale(p->Trace[j].Min);
+    hi = plotscale(p->Trace[j].Max);
+    color[j] = p->Trace[j].Color;
+    if(lo < 0){ lo = 0; color[j] = LCD_RED;}
+    if(lo > 98){ lo = 98; color[j] = LCD_RED;}
+    if(hi < 0){ hi = 0; color[j] = LCD_RED;}
+    if(hi > 98){ hi = 98; color[j] = LCD_RED;}
+    top[j] = 115 - hi;             // same 2 pixels as BSP_LCD_PlotPoint()
+    bottom[j] = 116 - lo;
+    oldTop = p->Trace[j].Top[TimeIndex];
+    oldBottom = p->Trace[j].Bottom[TimeIndex];
+    if(oldTop <= oldBottom){
+      if((oldBottom < top[j]) || (oldTop > bottom[j])){
+        BSP_LCD_DrawFastVLine(x, oldTop, oldBottom - oldTop + 1, PlotBGColor);
+      } else{
+        if(oldTop < top[j]){       // old span stuck out above
+          BSP_LCD_DrawFastVLine(x, oldTop, top[j] - oldTop, PlotBGColor);
+        }
+        if(oldBottom > bottom[j]){ // old span stuck out below
+          BSP_LCD_DrawFastVLine(x, bottom[j] + 1, oldBottom - bottom[j], PlotBGColor);
+        }
+      }
+    }
+    p->Trace[j].Top[TimeIndex] = top[j];
+    p->Trace[j].Bottom[TimeIndex] = bottom[j];
+    p->Trace[j].Min = 0x7FFFFFFF;
+    p->Trace[j].Max = -0x7FFFFFFF - 1;
+  }
+  for(j=0; j<p->NumTraces; j=j+1){
+    BSP_LCD_DrawFastVLine(x, top[j], bottom[j] - top[j] + 1, color[j]);
+  }
+  TimeIndex = TimeIndex + 1;
+  if(TimeIndex > 99){
+    TimeIndex = 0;
+  }
+  p->Count = 0;
+}
+
+// ------------BSP_LCD_PlotEnvBlock------------
+// Add a block of samples to an envelope plot, drawing a
+// column each time perColumn samples have been added.
+// The samples only cost a compare each until a column is
+// finished.
+// Input: p      pointer to the plot
+//        data1  array of n samples for the first trace
+//        data2  array of n samples for the second trace, or 0 for one trace
+//        n      number of samples
+// Output: number of columns drawn
+// Assumes: BSP_LCD_PlotEnvInit() has been called
+uint32_t BSP_LCD_PlotEnvBlock(plotEnvType *p, const int32_t *data1,
+  const int32_t *data2, uint32_t n){
+  uint32_t i, m, columns = 0;
+  int32_t min, max;
+  while(n){
+    m = p->PerColumn - p->Count;   // samples left in this column
+    if(m > n){
+      m = n;
+    }
+    min = p->Trace[0].Min; max = p->Trace[0].Max;
+    for(i=0; i<m; i=i+1){
+      if(data1[i] < min) min = data1[i];
+      if(data1[i] > max) max = data1[i];
+    }
+    p->Trace[0].Min = min; p->Trace[0].Max = max;
+    if(data2){
+      min = p->Trace[1].Min; max = p->Trace[1].Max;
+      for(i=0; i<m; i=i+1){
+        if(data2[i] < min) min = data2[i];
+        if(data2[i] > max) max = data2[i];
+      }
+      p->Trace[1].Min = min; p->Trace[1].Max = max;
+      data2 = data2 + m;
+    }
+    data1 = data1 + m;
+    n = n - m;
+    p->Count = p->Count + m;
+    if(p->Count == p->PerColumn){
+      plotcolumn(p);
+      columns = columns + 1;
+    }
+  }
+  return columns;
+}
+
+// ------------BSP_LCD_PlotEnvPut------------
+// Add one sample to each trace of an envelope plot.
+// Input: p      pointer to the plot
+//        data1  sample for the first trace
+//        data2  sample for the second trace, ignored for one trace
+// Output: 1 if a column was drawn, 0 if not
+// Assumes: BSP_LCD_PlotEnvInit() has been called
+uint32_t BSP_LCD_PlotEnvPut(plotEnvType *p, int32_t data1, int32_t data2){
+  return BSP_LCD_PlotEnvBlock(p, &data1, (p->NumTraces > 1) ? &data2 : 0, 1);
+}
 /* ********************** */
 /*   End of LCD Section   */
 /* ********************** */
@@ -2349,6 +2805,45 @@ void BSP_PeriodicTask_StopC(void){
   NVIC_ICER0 = 0x00001000;     // disable interrupt 12 in NVIC
 }
 
+// ***************** BSP_Alarm_Init ****************
+// Activate 16-bit Timer A2 in continuous mode to run a user
+// task once at a programmed time, rather than periodically
+// assumes SMCLK is 12MHz, using divide by 24, 500kHz (2 us)
+// Shares Timer A2 with BSP_PeriodicTask_InitC, use one or the other
+// Input:  task is a pointer to a user function
+//         delay is the number of 2 us counts until the first alarm
+//           1 to 65535 (at most 131 ms)
+//         priority is a number 0 to 6
+// Outputs: none
+void BSP_Alarm_Init(void(*task)(void), uint16_t delay, uint8_t priority){long sr;
+  if(priority > 6){
+    priority = 6;
+  }
+  sr = StartCritical();
+  PeriodicTaskC = task; // user function, run by TA2_0_IRQHandler
+  TA2CTL &= ~0x0030;    // halt Timer A2
+  TA2CTL = 0x0280;      // SMCLK, /4, stop mode
+  TA2EX0 = 0x0005;      // configure for input clock divider /6
+  TA2CCTL0 = 0x0010;    // compare mode, enable CCIFG interrupt
+  TA2CCR0 = delay;      // first alarm, TA2R is cleared below
+// interrupts enabled in the main program after all devices initialized
+  NVIC_IPR3 = (NVIC_IPR3&0xFFFFFF00)|(priority<<5);
+  NVIC_ISER0 = 0x00001000; // enable interrupt 12 in NVIC
+  TA2CTL |= 0x0024;        // reset and start Timer A2 in continuous mode
+  EndCritical(sr);
+}
+
+// ------------BSP_Alarm_Set------------
+// Schedule the next alarm relative to the time of the previous
+// alarm, so ISR latency does not accumulate.  Call this from
+// the user task to keep the alarm running.
+// Input: delay is the number of 2 us counts after the previous alarm
+//          1 to 65535 (at most 131 ms)
+// Output: none
+void BSP_Alarm_Set(uint16_t delay){
+  TA2CCR0 = TA2CCR0 + delay;   // 16-bit compare wraps with TA2R
+}
+
 void TA2_0_IRQHandler(void){
   TA2CCTL0 &= ~0x0001;          // acknowledge capture/compare interrupt TA2_0
   (*PeriodicTaskC)();           // execute user task
@@ -2357,37 +2852,86 @@ void TA2_0_IRQHandler(void){
 // ------------BSP_Time_Init------------
 // Activate a 32-bit timer to count the number of
 // microseconds since the timer was initialized.
+// Timer32 #2 counts at 3 MHz, and its interrupt extends
+// the count past 32 bits each time it wraps, which is
+// about every 23 minutes.
 // Input: none
 // Output: none
 // Assumes: BSP_Clock_InitFastest() has been called
 //          so clock = 48/16 = 3 MHz
+volatile uint32_t static TimeWraps;// number of times the timer has wrapped
+uint64_t static TimeBase;          // microseconds at the last wrap
+uint32_t static TimeBaseRem;       // 3 MHz counts at the last wrap beyond TimeBase, 0 to 2
 void BSP_Time_Init(void){long sr;
   sr = StartCritical();
+  TimeWraps = 0;
+  TimeBase = 0;
+  TimeBaseRem = 0;
   TIMER32_LOAD2 = 0xFFFFFFFF;      // timer reload value
   TIMER32_INTCLR2 = 0x00000001;    // clear Timer32 Timer 2 interrupt
   // bits31-8=X...X,   reserved
   // bit7=1,           timer enable
   // bit6=1,           timer in periodic mode
-  // bit5=0,           interrupt enable
+  // bit5=1,           interrupt enable
   // bit4=X,           reserved
   // bits3-2=01,       input clock divider /16
   // bit1=1,           32-bit counter
   // bit0=0,           wrapping mode
-  TIMER32_CONTROL2 = 0x000000C6;
+  TIMER32_CONTROL2 = 0x000000E6;
+// interrupts enabled in the main program after all devices initialized
+  NVIC_IPR6 = (NVIC_IPR6&0xFF00FFFF)|0x00C00000; // priority 6, Timer32 #2 is interrupt 26
+  NVIC_ISER0 = 0x04000000;         // enable interrupt 26 in NVIC
   EndCritical(sr);
 }
 
+void T32_INT2_IRQHandler(void){
+  TIMER32_INTCLR2 = 0x00000001;    // acknowledge Timer32 Timer 2 interrupt
+  // 2^32 counts at 3 MHz = 1,431,655,765 usec and 1 count
+  TimeBase = TimeBase + 1431655765;
+  TimeBaseRem = TimeBaseRem + 1;
+  if(TimeBaseRem == 3){
+    TimeBase = TimeBase + 1;
+    TimeBaseRem = 0;
+  }
+  TimeWraps = TimeWraps + 1;       // publish
+}
+
+// ------------BSP_Time_Get64------------
+// Return the system time in microseconds since
+// BSP_Time_Init(), as a 64-bit number that never rolls
+// over.  Safe to call from any thread or interrupt, even
+// with interrupts disabled, as long as they are not
+// disabled for 23 minutes.
+// Input: none
+// Output: system time in microseconds
+// Assumes: BSP_Time_Init() has been called
+uint64_t BSP_Time_Get64(void){
+  uint32_t wraps, rem, counts;
+  uint64_t base;
+  do{
+    wraps = TimeWraps;
+    base = TimeBase;
+    rem = TimeBaseRem;
+    counts = 0xFFFFFFFF - TIMER32_VALUE2;
+    if(TIMER32_RIS2&0x00000001){   // wrapped, but the interrupt has not run yet
+      counts = 0xFFFFFFFF - TIMER32_VALUE2; // read again after the wrap
+      base = base + 1431655765;
+      rem = rem + 1;
+    }
+  } while(wraps != TimeWraps);     // the interrupt ran while reading
+  return base + counts/3 + (counts%3 + rem)/3;
+}
+
 // ------------BSP_Time_Get------------
 // Return the system time in microseconds, which is the
-// number of 32-bit timer counts since the timer was
-// initialized.  This will work properly for at least 23
-// minutes after which it could roll over.
+// bottom 32 bits of BSP_Time_Get64().  It rolls over
+// every 71 minutes, but the difference of two readings
+// less than 71 minutes apart is always correct.
 // Input: none
 // Output: system time in microseconds
 // Assumes: BSP_Time_Init() has been called
 uint32_t BSP_Time_Get(void){
-  // 2*32/3,000,000 = 1431 seconds, about 23 minutes
-  return (0xFFFFFFFF - TIMER32_VALUE2)/3;
+  return (uint32_t)BSP_Time_Get64();
 }
 
 // ------------BSP_Delay1ms------------
@@ -2850,3 +3394,315 @@ int BSP_TempSensor_End(int32_t *sensorV, int32_t *localT){
     }
   }
 }
+
+// Queued I2C transactions run by the eUSCI B1 interrupt
+// Each transaction has a write phase and then a read phase,
+// each ended by the stop the eUSCI sends automatically after
+// UCB1TBCNT bytes.  The stop interrupt starts the next phase
+// or the next transaction, so the bus stays busy without the
+// processor waiting.
+i2cTransType static *I2CHead = 0;  // running transaction, 0 if idle
+i2cTransType static *I2CTail = 0;  // last transaction in the queue
+uint32_t static I2CPhase;          // 0 writing, 1 reading
+uint32_t static I2CIndex;          // bytes done in this phase
+
+// start the current phase of the transaction at I2CHead
+void static i2cphase(void){
+  i2cTransType *t = I2CHead;
+  UCB1CTLW0 |= 0x0001;             // hold the eUSCI module in reset mode
+  if(I2CPhase == 0){
+    UCB1TBCNT = t->TxCount;        // generate stop condition after this many bytes
+  } else{
+    UCB1TBCNT = t->RxCount;
+  }
+  UCB1CTLW0 &= ~0x0001;            // enable eUSCI module
+  UCB1I2CSA = t->Slave;            // I2CCSA[6:0] is slave address
+  I2CIndex = 0;
+  // bit7 CLTOIE, bit5 NACKIE, bit4 ALIE, bit3 STPIE, bit1 TXIE0, bit0 RXIE0
+  if(I2CPhase == 0){
+    UCB1IE = 0x00BA;               // enable interrupts after leaving reset
+    UCB1CTLW0 = ((UCB1CTLW0&~0x0004) // clear bit2 (UCTXSTP) for no transmit stop condition
+                                   // set bit1 (UCTXSTT) for transmit start condition
+                  | 0x0012);       // set bit4 (UCTR) for transmit mode
+  } else{
+    UCB1IE = 0x00B9;
+    UCB1CTLW0 = ((UCB1CTLW0&~0x0014) // clear bit4 (UCTR) for receive mode
+                                   // clear bit2 (UCTXSTP) for no transmit stop condition
+                  | 0x0002);       // set bit1 (UCTXSTT) for receive start condition
+  }
+}
+
+// start the transaction at I2CHead
+void static i2cstart(void){
+  if(I2CHead->TxCount){
+    I2CPhase = 0;
+  } else{
+    I2CPhase = 1;                  // read only
+  }
+  i2cphase();
+}
+
+// finish the transaction at I2CHead, start the next one,
+// then tell the caller
+void static i2cfinish(int16_t status){
+  i2cTransType *t = I2CHead;
+  I2CHead = t->Next;
+  if(I2CHead == 0){
+    I2CTail = 0;
+    UCB1IE = 0x0000;               // idle
+  } else{
+    i2cstart();                    // back to back
+  }
+  t->Status = status;
+  if(t->Done){
+    (*t->Done)(t);                 // may submit more transactions
+  }
+}
+
+// ------------BSP_I2C_Init------------
+// Initialize the I2C pins and the eUSCI B1 interrupt
+// for queued transactions.
+// Input: priority is interrupt priority (0 to 6)
+// Output: none
+void BSP_I2C_Init(uint32_t priority){long sr;
+  sr = StartCritical();
+  i2cinit();
+  I2CHead = I2CTail = 0;
+  NVIC_IPR5 = (NVIC_IPR5&0xFFFF00FF)|(priority<<13); // eUSCI B1 is interrupt 21
+  NVIC_ISER0 = 0x00200000;         // enable interrupt 21 in NVIC
+  EndCritical(sr);
+}
+
+// ------------BSP_I2C_Submit------------
+// Add a transaction to the end of the queue and start it
+// if the bus is idle.  Returns immediately; poll t->Status
+// or use t->Done to know when it has finished.  The
+// transaction must not be changed until then.
+// Can be called from a thread or an interrupt.
+// Input: t is pointer to the transaction
+// Output: 0 if queued, -1 if the byte counts are invalid
+// Assumes: BSP_I2C_Init() has been called
+int BSP_I2C_Submit(i2cTransType *t){long sr;
+  if((t->TxCount > 3) || (t->RxCount > 2) || ((t->TxCount + t->RxCount) == 0)){
+    return -1;
+  }
+  t->Status = 1;
+  t->Next = 0;
+  sr = StartCritical();
+  if(I2CTail){
+    I2CTail->Next = t;             // the stop interrupt will start it
+    I2CTail = t;
+  } else{
+    I2CHead = I2CTail = t;
+    i2cstart();
+  }
+  EndCritical(sr);
+  return 0;
+}
+
+void EUSCIB1_IRQHandler(void){ uint16_t ifg; uint8_t data;
+  i2cTransType *t = I2CHead;
+  ifg = UCB1IFG;
+  if(t == 0){
+    UCB1IE = 0x0000;               // nothing running
+    return;
+  }
+  if(ifg&0x00B0){                  // bit7 set on clock low timeout (UCCLTO); bit5 set on not-acknowledge; bit4 set on arbitration lost
+    i2cinit();                     // reset to known state, releases the bus, also clears UCB1IE
+    i2cfinish(-(int16_t)ifg);
+    return;
+  }
+  if(ifg&0x0001){                  // byte received
+    data = UCB1RXBUF&0xFF;         // reading clears RXIFG0
+    if(I2CIndex < t->RxCount){
+      t->Rx[I2CIndex] = data;
+      I2CIndex = I2CIndex + 1;
+    }
+  }
+  if(ifg&0x0002){                  // ready for a byte to send
+    if((I2CPhase == 0) && (I2CIndex < t->TxCount)){
+      UCB1TXBUF = t->Tx[I2CIndex]; // writing clears TXIFG0
+      I2CIndex = I2CIndex + 1;
+    } else{
+      UCB1IFG &= ~0x0002;          // all sent, stop is on its way
+    }
+  }
+  if(ifg&0x0008){                  // stop condition sent
+    UCB1IFG &= ~0x0008;
+    if((I2CPhase == 0) && t->RxCount){
+      I2CPhase = 1;                // now read
+      i2cphase();
+    } else{
+      i2cfinish(0);
+    }
+  }
+}
+
+// OPT3001 measurement with queued transactions
+// Start: write Low Limit, write Configuration and read it
+// back, as lightsensorstart() does, then enable the INT pin.
+// The INT pin interrupt reads Result and Configuration, and
+// the Configuration read queues the writes that clear and
+// set the latch, as lightsensorend() does.
+i2cTransType static LightTrans[4];
+void (*LightTask)(uint32_t light);
+void static lighttrans(i2cTransType *t, uint8_t tx0, uint8_t tx1, uint8_t tx2,
+                       uint8_t txCount, uint8_t rxCount, void (*done)(i2cTransType *t)){
+  t->Slave = 0x44;
+  t->Tx[0] = tx0; t->Tx[1] = tx1; t->Tx[2] = tx2;
+  t->TxCount = txCount;
+  t->RxCount = rxCount;
+  t->Done = done;
+}
+void static lightdone(i2cTransType *t){
+  uint16_t raw = (LightTrans[0].Rx[0]<<8) + LightTrans[0].Rx[1];
+  LightBusy = 0;
+  if(LightTrans[0].Status || t->Status){
+    return;                        // bus error, the result is not valid
+  }
+  (*LightTask)((1<<(raw>>12))*(raw&0x0FFF));
+}
+void static lightconfig(i2cTransType *t){
+  uint8_t high = t->Rx[0], low = t->Rx[1];
+  if(t->Status){
+    lightdone(t);                  // bus error, skip the latch
+    return;
+  }
+  // force the INT pin to clear by clearing and resetting the latch bit of the Configuration Register (0x01)
+  lighttrans(&LightTrans[2], 0x01, high, low&~0x10, 3, 0, 0);
+  lighttrans(&LightTrans[3], 0x01, high, low|0x10, 3, 0, &lightdone);
+  BSP_I2C_Submit(&LightTrans[2]);
+  BSP_I2C_Submit(&LightTrans[3]);
+}
+void static lightarm(i2cTransType *t){
+  if(LightTrans[0].Status || LightTrans[1].Status || t->Status){
+    LightBusy = 0;                 // not configured, so do not wait for INT
+    return;
+  }
+  P4IFG &= ~0x40;                  // clear any old edge
+  P4IE |= 0x40;                    // arm interrupt on P4.6
+  if(LIGHTINT == 0x00){
+    P4IFG |= 0x40;                 // already ready, so interrupt now
+  }
+}
+void PORT4_IRQHandler(void){
+  P4IE &= ~0x40;                   // disarm, one edge per measurement
+  P4IFG &= ~0x40;                  // acknowledge P4.6
+  lighttrans(&LightTrans[0], 0x00, 0, 0, 1, 2, 0);           // Result Register
+  lighttrans(&LightTrans[1], 0x01, 0, 0, 1, 2, &lightconfig);// Configuration Register
+  BSP_I2C_Submit(&LightTrans[0]);
+  BSP_I2C_Submit(&LightTrans[1]);
+}
+
+// ------------BSP_LightSensor_Request------------
+// Start an OPT3001 measurement without waiting.  The
+// INT pin (J1.8, P4.6) interrupts when the conversion is
+// ready, the result is read with queued transactions, and
+// then task is called from the I2C interrupt.  If the bus
+// fails, task is not called and the next request starts a new
+// measurement, so the caller should wait with a timeout.
+// Input: task is function called with light intensity (units 100*lux)
+//        priority is interrupt priority of the INT pin (0 to 6)
+// Output: 0 if started, -1 if a measurement is in progress
+// Assumes: BSP_LightSensor_Init() and BSP_I2C_Init() have been called
+int BSP_LightSensor_Request(void(*task)(uint32_t light), uint32_t priority){long sr;
+  sr = StartCritical();
+  if(LightBusy){
+    EndCritical(sr);
+    return -1;
+  }
+  LightBusy = 1;
+  EndCritical(sr);
+  LightTask = task;
+  P4IE &= ~0x40;                   // disarm interrupt on P4.6
+  P4IES |= 0x40;                   // P4.6 is falling edge event, INT is active low
+  NVIC_IPR9 = (NVIC_IPR9&0xFF00FFFF)|(priority<<21); // Port 4 is interrupt 38
+  NVIC_ISER1 = 0x00000040;         // enable interrupt 38 in NVIC
+  // INT pin active after each conversion completes, then 800 ms single-shot
+  lighttrans(&LightTrans[0], 0x02, 0xC0, 0x00, 3, 0, 0);
+  lighttrans(&LightTrans[1], 0x01, 0xCA, 0x10, 3, 0, 0);
+  // read Configuration Register to reset conversion ready
+  lighttrans(&LightTrans[2], 0x01, 0, 0, 0, 2, &lightarm); // pointer is already 0x01
+  BSP_I2C_Submit(&LightTrans[0]);
+  BSP_I2C_Submit(&LightTrans[1]);
+  BSP_I2C_Submit(&LightTrans[2]);
+  return 0;
+}
+
+// TMP006 measurement with queued transactions
+// Start: write Configuration, as tempsensorstart() does, then
+// enable the ~DRDY pin.  The ~DRDY interrupt reads Sensor
+// Voltage and Local Temperature, as tempsensorend() does.
+i2cTransType static TempTrans[2];
+void (*TempTask)(int32_t sensorV, int32_t localT);
+void static tempdone(i2cTransType *t){
+  int16_t volt = (TempTrans[0].Rx[0]<<8) + TempTrans[0].Rx[1];
+  int16_t temp = (TempTrans[1].Rx[0]<<8) + TempTrans[1].Rx[1];
+  TempBusy = 0;
+  if(TempTrans[0].Status || t->Status){
+    return;                        // bus error, the result is not valid
+  }
+  (*TempTask)(volt*15625, (temp>>2)*3125);
+}
+void static temparm(i2cTransType *t){
+  if(t->Status){
+    TempBusy = 0;                  // not configured, so do not wait for ~DRDY
+    return;
+  }
+  P3IFG &= ~0x40;                  // clear any old edge
+  P3IE |= 0x40;                    // arm interrupt on P3.6
+  if(TEMPINT == 0x00){
+    P3IFG |= 0x40;                 // already ready, so interrupt now
+  }
+}
+void PORT3_IRQHandler(void){
+  P3IE &= ~0x40;                   // disarm, one edge per measurement
+  P3IFG &= ~0x40;                  // acknowledge P3.6
+  TempTrans[0].Tx[0] = 0x00;       // pointer register 0x00 = Sensor Voltage Register
+  TempTrans[0].TxCount = 1;
+  TempTrans[0].RxCount = 2;
+  TempTrans[0].Done = 0;
+  TempTrans[1].Tx[0] = 0x01;       // pointer register 0x01 = Local Temperature Register
+  TempTrans[1].TxCount = 1;
+  TempTrans[1].RxCount = 2;
+  TempTrans[1].Done = &tempdone;
+  BSP_I2C_Submit(&TempTrans[0]);
+  BSP_I2C_Submit(&TempTrans[1]);
+}
+
+// ------------BSP_TempSensor_Request------------
+// Start a TMP006 measurement without waiting.  The
+// ~DRDY pin (J2.11, P3.6) interrupts when data are ready,
+// the results are read with queued transactions, and then
+// task is called from the I2C interrupt.  If the bus fails,
+// task is not called and the next request starts a new
+// measurement, so the caller should wait with a timeout.
+// Input: task is function called with sensor voltage (units 100*nV)
+//          and local temperature (units 100,000*C)
+//        priority is interrupt priority of the ~DRDY pin (0 to 6)
+// Output: 0 if started, -1 if a measurement is in progress
+// Assumes: BSP_TempSensor_Init() and BSP_I2C_Init() have been called
+int BSP_TempSensor_Request(void(*task)(int32_t sensorV, int32_t localT), uint32_t priority){long sr;
+  sr = StartCritical();
+  if(TempBusy){
+    EndCritical(sr);
+    return -1;
+  }
+  TempBusy = 1;
+  EndCritical(sr);
+  TempTask = task;
+  P3IE &= ~0x40;                   // disarm interrupt on P3.6
+  P3IES |= 0x40;                   // P3.6 is falling edge event, ~DRDY is active low
+  NVIC_IPR9 = (NVIC_IPR9&0xFFFF00FF)|(priority<<13); // Port 3 is interrupt 37
+  NVIC_ISER1 = 0x00000020;         // enable interrupt 37 in NVIC
+  TempTrans[0].Slave = TempTrans[1].Slave = 0x40;
+  // continuous conversion, 1 sample/sec, ~DRDY pin enabled
+  TempTrans[0].Tx[0] = 0x02;
+  TempTrans[0].Tx[1] = 0x75;
+  TempTrans[0].Tx[2] = 0x00;
+  TempTrans[0].TxCount = 3;
+  TempTrans[0].RxCount = 0;
+  TempTrans[0].Done = &temparm;
+  BSP_I2C_Submit(&TempTrans[0]);
+  return 0;
+}
@@ -337,6 +337,87 @@ void BSP_Microphone_Init(void);
 // Assumes: BSP_Microphone_Init() has been called
 void BSP_Microphone_Input(uint16_t *mic);
 
+// ------------BSP_Microphone_StartStream------------
+// Sample the microphone at a fixed rate with no software
+// run per sample.  Timer A3 output 1 triggers each ADC14
+// conversion of P4.3/A10 (repeat-single-channel mode), and
+// DMA channel 7 moves each result into RAM, filling buf0
+// then buf1 then buf0 again (ping-pong).  When a buffer is
+// full, task runs in the DMA interrupt with that buffer
+// while the other one fills, so task must finish within
+// n sample periods.  Samples are 14-bit (0 to 16383);
+// shift right 4 to match BSP_Microphone_Input().
+// While streaming, the ADC belongs to the microphone, so
+// BSP_Joystick_Input(), BSP_Accelerometer_Input() and
+// BSP_Microphone_Input() must not be called.
+// Input: buf0, buf1 are two arrays of n samples
+//        n is samples per buffer, 1 to 1024
+//        freq is samples per second, 50 to 20,000
+//        task is a pointer to a user function
+//        priority is a number 0 to 6
+// Output: none
+// Assumes: timer A3 and DMA channel 7 are not otherwise used
+// comment: rate is accurate if BSP_Clock_GetFreq()/16/freq is an integer
+void BSP_Microphone_StartStream(uint16_t *buf0, uint16_t *buf1, uint32_t n,
+  uint32_t freq, void(*task)(uint16_t *buf, uint32_t n), uint8_t priority);
+
+// ------------BSP_Microphone_StopStream------------
+// Stop the timer, ADC and DMA started by
+// BSP_Microphone_StartStream() and return the ADC to
+// software-started conversions.  A partly full buffer
+// is dropped.
+// Input: none
+// Output: none
+void BSP_Microphone_StopStream(void);
+
+// One scan of all six analog inputs, all 10-bit (0 to 1023)
+struct analogframe{
+  uint32_t Time;          // BSP_Time_Get() when the scan finished, in usec
+  uint32_t Count;         // scans since BSP_Analog_StartScan()
+  uint16_t JoyX, JoyY;    // joystick, J1.2/P6.0/A15 and J3.26/P4.4/A9
+  uint16_t AccX, AccY, AccZ; // accelerometer, A14, A13, A11
+  uint16_t Mic;           // microphone, J1.6/P4.3/A10
+};
+typedef struct analogframe analogFrameType;
+
+// ------------BSP_Analog_StartScan------------
+// Convert all six analog inputs of the BoosterPack in one
+// ADC14 repeat-sequence, MEM0 to MEM5, paced by Timer A3
+// output 1 (one conversion per timer edge, six edges per
+// scan).  At the end of each scan the ADC14 interrupt
+// stores the results in a frame.  While scanning,
+// BSP_Joystick_Input(), BSP_Accelerometer_Input() and
+// BSP_Microphone_Input() return values from the latest
+// frame instead of starting conversions, so tasks that
+// use different inputs no longer reprogram the ADC.
+// Input: freq is scans per second, 10 to 3,000
+//        priority is a number 0 to 6
+// Output: none
+// Assumes: BSP_Time_Init() has been called, timer A3 is not
+//          otherwise used (see BSP_Microphone_StartStream()),
+//          and the TExaS scope, which restarts the ADC at
+//          ADC14MEM6, is off
+// comment: rate is accurate if BSP_Clock_GetFreq()/96/freq is an integer
+void BSP_Analog_StartScan(uint32_t freq, uint8_t priority);
+
+// ------------BSP_Analog_StopScan------------
+// Stop scanning and return the ADC to software-started
+// conversions for each input.
+// Input: none
+// Output: none
+void BSP_Analog_StopScan(void);
+
+// ------------BSP_Analog_GetFrame------------
+// Copy the latest complete scan without disabling
+// interrupts.  The scan interrupt fills one of two frames
+// while the other is read, and the copy is retried if a
+// scan finished during it, so it can be called from any
+// thread or interrupt.
+// Input: frame is pointer to store the scan
+// Output: none
+// Assumes: BSP_Analog_StartScan() has been called
+void BSP_Analog_GetFrame(analogFrameType *frame);
+
 
 // ------------BSP_LCD_Init------------
 // Initialize the SPI and GPIO, which correspond with
@@ -592,6 +673,66 @@ void BSP_LCD_PlotPoint(int32_t data1, uint16_t color1);
 // Assumes: BSP_LCD_Init() and BSP_LCD_Drawaxes() have been called
 void BSP_LCD_PlotIncrement(void);
 
+// Envelope plot: each column shows the min to max range
+// of PerColumn samples of one or two traces
+struct plotenvtrace{
+  uint16_t Color;
+  int32_t Min, Max;         // of the samples in the column being collected
+  uint8_t Top[100];         // rows drawn in each column one sweep ago,
+  uint8_t Bottom[100];      //   nothing if Top > Bottom
+};
+struct plotenv{
+  uint32_t PerColumn;       // samples in each column
+  uint32_t Count;           // samples in the column being collected
+  uint32_t NumTraces;       // 1 or 2
+  uint32_t Clears;          // to notice when BSP_LCD_Drawaxes() clears the plot
+  struct plotenvtrace Trace[2];
+};
+typedef struct plotenv plotEnvType;
+
+// ------------BSP_LCD_PlotEnvInit------------
+// Set up a plot that draws the min to max range of
+// many samples in each column, for data that come faster
+// than columns can be drawn.  Each column only redraws the
+// pixels that differ from what was there one sweep ago, and
+// the scaling uses the multiply set up by
+// BSP_LCD_Drawaxes(), so a column costs at most a few
+// hundred bytes on the SPI no matter how many samples it
+// covers.  It moves the same column as
+// BSP_LCD_PlotIncrement(), so do not mix the two.
+// Input: p          pointer to the plot
+//        perColumn  number of samples in each column
+//        numTraces  1 or 2
+//        color1     16-bit color for the first trace
+//        color2     16-bit color for the second trace
+// Output: none
+// Assumes: BSP_LCD_Init() and BSP_LCD_Drawaxes() have been called
+void BSP_LCD_PlotEnvInit(plotEnvType *p, uint32_t perColumn, uint32_t numTraces,
+  uint16_t color1, uint16_t color2);
+
+// ------------BSP_LCD_PlotEnvBlock------------
+// Add a block of samples to an envelope plot, drawing a
+// column each time perColumn samples have been added.
+// The samples only cost a compare each until a column is
+// finished.
+// Input: p      pointer to the plot
+//        data1  array of n samples for the first trace
+//        data2  array of n samples for the second trace, or 0 for one trace
+//        n      number of samples
+// Output: number of columns drawn
+// Assumes: BSP_LCD_PlotEnvInit() has been called
+uint32_t BSP_LCD_PlotEnvBlock(plotEnvType *p, const int32_t *data1,
+  const int32_t *data2, uint32_t n);
+
+// ------------BSP_LCD_PlotEnvPut------------
+// Add one sample to each trace of an envelope plot.
+// Input: p      pointer to the plot
+//        data1  sample for the first trace
+//        data2  sample for the second trace, ignored for one trace
+// Output: 1 if a column was drawn, 0 if not
+// Assumes: BSP_LCD_PlotEnvInit() has been called
+uint32_t BSP_LCD_PlotEnvPut(plotEnvType *p, int32_t data1, int32_t data2);
+
 
 // ------------BSP_Clock_InitFastest------------
 // Configure the system clock to run at the fastest
@@ -663,19 +804,54 @@ void BSP_PeriodicTask_InitC(void(*task)(void), uint32_t freq, uint8_t priority);
 // Output: none
 void BSP_PeriodicTask_StopC(void);
 
+// ***************** BSP_Alarm_Init ****************
+// Activate 16-bit Timer A2 in continuous mode to run a user
+// task once at a programmed time, rather than periodically
+// assumes SMCLK is 12MHz, using divide by 24, 500kHz (2 us)
+// Shares Timer A2 with BSP_PeriodicTask_InitC, use one or the other
+// Input:  task is a pointer to a user function
+//         delay is the number of 2 us counts until the first alarm
+//           1 to 65535 (at most 131 ms)
+//         priority is a number 0 to 6
+// Outputs: none
+void BSP_Alarm_Init(void(*task)(void), uint16_t delay, uint8_t priority);
+
+// ------------BSP_Alarm_Set------------
+// Schedule the next alarm relative to the time of the previous
+// alarm, so ISR latency does not accumulate.  Call this from
+// the user task to keep the alarm running.
+// Input: delay is the number of 2 us counts after the previous alarm
+//          1 to 65535 (at most 131 ms)
+// Output: none
+void BSP_Alarm_Set(uint16_t delay);
+
 // ------------BSP_Time_Init------------
 // Activate a 32-bit timer to count the number of
 // microseconds since the timer was initialized.
+// Timer32 #2 counts at 3 MHz, and its interrupt extends
+// the count past 32 bits each time it wraps, which is
+// about every 23 minutes.
 // Input: none
 // Output: none
 // Assumes: BSP_Clock_InitFastest() has been called
 void BSP_Time_Init(void);
 
+// ------------BSP_Time_Get64------------
+// Return the system time in microseconds since
+// BSP_Time_Init(), as a 64-bit number that never rolls
+// over.  Safe to call from any thread or interrupt, even
+// with interrupts disabled, as long as they are not
+// disabled for 23 minutes.
+// Input: none
+// Output: system time in microseconds
+// Assumes: BSP_Time_Init() has been called
+uint64_t BSP_Time_Get64(void);
+
 // ------------BSP_Time_Get------------
 // Return the system time in microseconds, which is the
-// number of 32-bit timer counts since the timer was
-// initialized.  This will work properly for at least 23
-// minutes after which it could roll over.
+// bottom 32 bits of BSP_Time_Get64().  It rolls over
+// every 71 minutes, but the difference of two readings
+// less than 71 minutes apart is always correct.
 // Input: none
 // Output: system time in microseconds
 // Assumes: BSP_Time_Init() has been called
@@ -771,3 +947,70 @@ void BSP_TempSensor_Start(void);
 //         zero if measurement is not ready and pointers unchanged
 // Assumes: BSP_TempSensor_Init() has been called
 int BSP_TempSensor_End(int32_t *sensorV, int32_t *localT);
+
+// Interrupt-driven I2C transactions
+// A transaction writes TxCount bytes, then, after a stop,
+// reads RxCount bytes from the same slave.  Transactions are
+// queued and run back to back by the eUSCI B1 interrupt, so
+// the processor does not wait on the bus.  Done is called
+// from that interrupt when a transaction finishes; it may
+// submit more transactions or signal a semaphore.  The
+// blocking sensor functions above use the same bus, so do not
+// call them while transactions are queued.
+struct i2ctrans{
+  uint8_t Slave;            // 7-bit slave address
+  uint8_t TxCount;          // bytes to write, 0 to 3
+  uint8_t RxCount;          // bytes to read after the write, 0 to 2
+  uint8_t Tx[3];            // bytes to write
+  uint8_t Rx[2];            // bytes read, most significant first
+  volatile int16_t Status;  // 1 waiting or running, 0 done, -UCB1IFG on not-acknowledge, lost arbitration or clock low timeout
+  void (*Done)(struct i2ctrans *t); // called when finished, or 0
+  void *Arg;                // for Done to use
+  struct i2ctrans *Next;    // used by the queue
+};
+typedef struct i2ctrans i2cTransType;
+
+// ------------BSP_I2C_Init------------
+// Initialize the I2C pins and the eUSCI B1 interrupt
+// for queued transactions.
+// Input: priority is interrupt priority (0 to 6)
+// Output: none
+void BSP_I2C_Init(uint32_t priority);
+
+// ------------BSP_I2C_Submit------------
+// Add a transaction to the end of the queue and start it
+// if the bus is idle.  Returns immediately; poll t->Status
+// or use t->Done to know when it has finished.  The
+// transaction must not be changed until then.
+// Can be called from a thread or an interrupt.
+// Input: t is pointer to the transaction
+// Output: 0 if queued, -1 if the byte counts are invalid
+// Assumes: BSP_I2C_Init() has been called
+int BSP_I2C_Submit(i2cTransType *t);
+
+// ------------BSP_LightSensor_Request------------
+// Start an OPT3001 measurement without waiting.  The
+// INT pin (J1.8, P4.6) interrupts when the conversion is
+// ready, the result is read with queued transactions, and
+// then task is called from the I2C interrupt.  If the bus
+// fails, task is not called and the next request starts a new
+// measurement, so the caller should wait with a timeout.
+// Input: task is function called with light intensity (units 100*lux)
+//        priority is interrupt priority of the INT pin (0 to 6)
+// Output: 0 if started, -1 if a measurement is in progress
+// Assumes: BSP_LightSensor_Init() and BSP_I2C_Init() have been called
+int BSP_LightSensor_Request(void(*task)(uint32_t light), uint32_t priority);
+
+// ------------BSP_TempSensor_Request------------
+// Start a TMP006 measurement without waiting.  The
+// ~DRDY pin (J2.11, P3.6) interrupts when data are ready,
+// the results are read with queued transactions, and then
+// task is called from the I2C interrupt.  If the bus fails,
+// task is not called and the next request starts a new
+// measurement, so the caller should wait with a timeout.
+// Input: task is function called with sensor voltage (units 100*nV)
+//          and local temperature (units 100,000*C)
+//        priority is interrupt priority of the ~DRDY pin (0 to 6)
+// Output: 0 if started, -1 if a measurement is in progress
+// Assumes: BSP_TempSensor_Init() and BSP_I2C_Init() have been called
+int BSP_TempSensor_Request(void(*task)(int32_t sensorV, int32_t localT), uint32_t priority);
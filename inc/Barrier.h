@@ -0,0 +1,15 @@
+// Barrier.h
+// Compiler barrier for a single producer publishing to a reader
+// The compiler may not move memory accesses across BARRIER(),
+// so a producer that stores its data, then BARRIER(), then the
+// index or count makes the data visible before the index.  The
+// Cortex-M4 itself does not reorder the two stores.
+// Runs on MSP432 or a host computer
+
+#if defined(__ARMCC_VERSION) && (__ARMCC_VERSION < 6000000)
+#define BARRIER() __schedule_barrier()   // Keil ARM Compiler 5
+#elif defined(__GNUC__)
+#define BARRIER() __asm volatile("" ::: "memory") // gcc, clang, Keil 6
+#else
+#define BARRIER() __asm(" ")             // CCS, nothing moves past asm
+#endif
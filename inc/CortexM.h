@@ -15,6 +15,7 @@
 #define HFAULTSTAT      (*((volatile uint32_t *)0xE000ED2C))
 #define MMADDR          (*((volatile uint32_t *)0xE000ED34))
 #define FAULTADDR       (*((volatile uint32_t *)0xE000ED38))
+#define FPCCR           (*((volatile uint32_t *)0xE000EF34))
 
 //******DisableInterrupts************
 // sets the I bit in the PRIMASK to disable interrupts
@@ -0,0 +1,224 @@
+// DSP.c
+// Fixed-point signal processing kernels for the sensor tasks
+// On the Cortex-M4 the kernels use the dual 16-bit multiply
+// accumulate instructions (SMUAD, SMLAD, SMLALD) through the
+// CMSIS intrinsics, two samples per instruction.  Any other
+// compiler, such as gcc on a Linux host (ARM or not), gets
+// plain C that computes the same results bit for bit.
+// Runs on MSP432 or a host computer
+
+#include <stdint.h>
+#if defined(__TI_COMPILER_VERSION__) || defined(__ARMCC_VERSION) // CCS or Keil
+#include "../inc/msp432p401r.h"    // CMSIS core_cm4.h, __SMLAD() and friends
+#define DSP_SIMD 1
+#endif
+#include "DSP.h"
+
+// two adjacent samples as one 32-bit word, x[0] in the bottom half
+#define PAIR(p) (*(const int32_t *)(p))
+
+int32_t static sat16(int32_t x){
+#ifdef DSP_SIMD
+  return __SSAT(x, 16);
+#else
+  if(x > 32767){
+    return 32767;
+  }
+  if(x < -32768){
+    return -32768;
+  }
+  return x;
+#endif
+}
+
+//******DSP_Dot************
+// Dot product of two sample arrays
+// Inputs: x, y, arrays of n samples, 32-bit aligned
+//         n, number of samples, 0 to 65,536 (no overflow
+//           when |x[i]*y[i]| < 32,768)
+// Outputs: sum of x[i]*y[i]
+int32_t DSP_Dot(const int16_t *x, const int16_t *y, uint32_t n){
+  int32_t sum = 0;
+#ifdef DSP_SIMD
+  while(n >= 2){                 // x[0]*y[0] + x[1]*y[1] + sum
+    sum = (int32_t)__SMLAD(PAIR(x), PAIR(y), sum);
+    x = x + 2;
+    y = y + 2;
+    n = n - 2;
+  }
+#endif
+  while(n){
+    sum = sum + (*x)*(*y);
+    x = x + 1;
+    y = y + 1;
+    n = n - 1;
+  }
+  return sum;
+}
+
+//******DSP_SumSquares************
+// Sum of squares, for energy and RMS of a block
+// Inputs: x, array of n samples, 32-bit aligned
+//         n, number of samples
+// Outputs: sum of x[i]*x[i], can not overflow
+uint64_t DSP_SumSquares(const int16_t *x, uint32_t n){
+  uint64_t sum = 0;
+#ifdef DSP_SIMD
+  while(n >= 2){                 // 64-bit accumulate
+    sum = __SMLALD(PAIR(x), PAIR(x), sum);
+    x = x + 2;
+    n = n - 2;
+  }
+#endif
+  while(n){
+    sum = sum + (uint32_t)((*x)*(*x));
+    x = x + 1;
+    n = n - 1;
+  }
+  return sum;
+}
+
+//******DSP_Sum************
+// Sum of a block of samples
+// Inputs: x, array of n samples, 32-bit aligned
+//         n, number of samples, 0 to 65,536
+// Outputs: sum of x[i]
+int32_t DSP_Sum(const int16_t *x, uint32_t n){
+  int32_t sum = 0;
+#ifdef DSP_SIMD
+  while(n >= 2){                 // x[0]*1 + x[1]*1 + sum
+    sum = (int32_t)__SMLAD(PAIR(x), 0x00010001, sum);
+    x = x + 2;
+    n = n - 2;
+  }
+#endif
+  while(n){
+    sum = sum + *x;
+    x = x + 1;
+    n = n - 1;
+  }
+  return sum;
+}
+
+//******DSP_FIR_Init************
+// Set up a FIR filter with all past inputs 0
+// Inputs: f, pointer to the filter
+//         coef, NumTaps reversed Q15 coefficients
+//         state, array of numTaps+maxBlock samples, 32-bit aligned
+//         numTaps, filter length, even
+//         maxBlock, largest block, even
+// Outputs: none
+void DSP_FIR_Init(firType *f, const int16_t *coef, int16_t *state,
+                  uint32_t numTaps, uint32_t maxBlock){ uint32_t i;
+  f->Coef = coef;
+  f->State = state;
+  f->NumTaps = numTaps;
+  f->MaxBlock = maxBlock;
+  for(i=0; i<numTaps+maxBlock; i=i+1){
+    state[i] = 0;
+  }
+}
+
+//******DSP_FIR************
+// Filter one block of samples, rounding and saturating
+// each output to 16 bits
+// No overflow when the sum of |Coef[k]| is at most 65,535 (2.0)
+// Inputs: f, pointer to the filter
+//         in, n input samples
+//         out, space for n output samples (may be in)
+//         n, block size, even, 2 to MaxBlock
+// Outputs: none
+void DSP_FIR(firType *f, const int16_t *in, int16_t *out, uint32_t n){
+  int16_t *s = f->State;
+  const int16_t *c;
+  uint32_t keep = f->NumTaps - 1;  // past inputs kept between blocks
+  uint32_t i, k;
+  int32_t acc0, acc1;
+  for(i=0; i<n; i=i+1){
+    s[keep+i] = in[i];             // newest samples after the old ones
+  }
+  // output i is the sum of Coef[k]*s[i+k], two outputs per pass
+  for(i=0; i<n; i=i+2){
+    acc0 = 0x4000;                 // rounding for the Q15 shift
+    acc1 = 0x4000;
+    c = f->Coef;
+#ifdef DSP_SIMD
+    { int32_t p0, p1;              // aligned pairs s[i+k],s[i+k+1] and s[i+k+2],s[i+k+3]
+      p0 = PAIR(&s[i]);
+      for(k=0; k<f->NumTaps; k=k+2){
+        p1 = PAIR(&s[i+k+2]);
+        acc0 = (int32_t)__SMLAD(PAIR(c), p0, acc0);
+        // s[i+k+1],s[i+k+2] crossed with Coef[k],Coef[k+1]
+        acc1 = (int32_t)__SMLADX(PAIR(c), __PKHBT(p1, p0, 0), acc1);
+        p0 = p1;
+        c = c + 2;
+      }
+    }
+#else
+    for(k=0; k<f->NumTaps; k=k+1){
+      acc0 = acc0 + c[k]*s[i+k];
+      acc1 = acc1 + c[k]*s[i+k+1];
+    }
+#endif
+    out[i] = sat16(acc0>>15);
+    out[i+1] = sat16(acc1>>15);
+  }
+  for(k=0; k<keep; k=k+1){
+    s[k] = s[n+k];                 // oldest inputs needed by the next block
+  }
+}
+
+//******DSP_Biquad_Init************
+// Set up a biquad with all past values 0
+// Inputs: f, pointer to the section
+//         b0, b1, b2, a1, a2, Q14 coefficients
+// Outputs: none
+void DSP_Biquad_Init(biquadType *f, int16_t b0, int16_t b1, int16_t b2,
+                     int16_t a1, int16_t a2){
+  f->B0 = b0; f->B1 = b1; f->B2 = b2;
+  f->A1 = a1; f->A2 = a2;
+  f->X1 = f->X2 = f->Y1 = f->Y2 = 0;
+}
+
+//******DSP_Biquad************
+// Filter one block, rounding and saturating to 16 bits
+// Inputs: f, pointer to the section
+//         in, n input samples
+//         out, space for n output samples (may be in)
+//         n, number of samples
+// Outputs: none
+void DSP_Biquad(biquadType *f, const int16_t *in, int16_t *out, uint32_t n){
+  int32_t x0, x1 = f->X1, x2 = f->X2, y1 = f->Y1, y2 = f->Y2;
+  int64_t acc;                     // five full-scale products overflow 32 bits
+  while(n){                        // past values stay in registers
+    x0 = *in;
+    acc = 0x2000 + (int64_t)f->B0*x0 + (int64_t)f->B1*x1 + (int64_t)f->B2*x2
+                 - (int64_t)f->A1*y1 - (int64_t)f->A2*y2; // SMLAL on the M4
+    x2 = x1;
+    x1 = x0;
+    y2 = y1;
+    y1 = sat16((int32_t)(acc>>14)); // at most 5*2^30/2^14, fits
+    *out = y1;
+    in = in + 1;
+    out = out + 1;
+    n = n - 1;
+  }
+  f->X1 = x1; f->X2 = x2; f->Y1 = y1; f->Y2 = y2;
+}
+
+//******DSP_Decimate************
+// Average each group of factor samples into one (boxcar
+// filter and downsample), for example 8 kHz sound to 1 kHz
+// Inputs: in, n input samples, 32-bit aligned
+//         out, space for n/factor outputs (may be in)
+//         n, number of input samples, multiple of factor
+//         factor, even, 2 to 65,536
+// Outputs: number of outputs, n/factor
+uint32_t DSP_Decimate(const int16_t *in, int16_t *out, uint32_t n, uint32_t factor){
+  uint32_t j, count = n/factor;
+  for(j=0; j<count; j=j+1){
+    out[j] = DSP_Sum(in, factor)/(int32_t)factor;
+    in = in + factor;
+  }
+  return count;
+}
@@ -0,0 +1,106 @@
+// DSP.h
+// Fixed-point signal processing kernels for the sensor tasks
+// On the Cortex-M4 the kernels use the dual 16-bit multiply
+// accumulate instructions (SMUAD, SMLAD, SMLALD) through the
+// CMSIS intrinsics, two samples per instruction.  Any other
+// compiler, such as gcc on a Linux host (ARM or not), gets
+// plain C that computes the same results bit for bit.
+// Samples are int16_t.  Arrays passed to the kernels must be
+// 32-bit aligned, because samples are loaded two at a time.
+// Runs on MSP432 or a host computer
+
+//******DSP_Dot************
+// Dot product of two sample arrays
+// Inputs: x, y, arrays of n samples, 32-bit aligned
+//         n, number of samples, 0 to 65,536 (no overflow
+//           when |x[i]*y[i]| < 32,768)
+// Outputs: sum of x[i]*y[i]
+int32_t DSP_Dot(const int16_t *x, const int16_t *y, uint32_t n);
+
+//******DSP_SumSquares************
+// Sum of squares, for energy and RMS of a block
+// Inputs: x, array of n samples, 32-bit aligned
+//         n, number of samples
+// Outputs: sum of x[i]*x[i], can not overflow
+uint64_t DSP_SumSquares(const int16_t *x, uint32_t n);
+
+//******DSP_Sum************
+// Sum of a block of samples
+// Inputs: x, array of n samples, 32-bit aligned
+//         n, number of samples, 0 to 65,536
+// Outputs: sum of x[i]
+int32_t DSP_Sum(const int16_t *x, uint32_t n);
+
+// FIR filter, y[n] = sum of h[k]*x[n-k] for k = 0 to NumTaps-1
+// Coefficients are Q15 (32,767 is almost 1.0) and stored in
+// reverse order, h[NumTaps-1] first.  State holds the last
+// NumTaps-1 inputs followed by room for one block and one
+// spare sample, because outputs are made two at a time.
+struct fir{
+  const int16_t *Coef;    // NumTaps Q15 coefficients, reversed, 32-bit aligned
+  int16_t *State;         // NumTaps+MaxBlock samples, 32-bit aligned
+  uint32_t NumTaps;       // even, so each block stays aligned
+  uint32_t MaxBlock;      // largest block passed to DSP_FIR()
+};
+typedef struct fir firType;
+
+//******DSP_FIR_Init************
+// Set up a FIR filter with all past inputs 0
+// Inputs: f, pointer to the filter
+//         coef, NumTaps reversed Q15 coefficients
+//         state, array of numTaps+maxBlock samples, 32-bit aligned
+//         numTaps, filter length, even
+//         maxBlock, largest block, even
+// Outputs: none
+void DSP_FIR_Init(firType *f, const int16_t *coef, int16_t *state,
+                  uint32_t numTaps, uint32_t maxBlock);
+
+//******DSP_FIR************
+// Filter one block of samples, rounding and saturating
+// each output to 16 bits
+// No overflow when the sum of |Coef[k]| is at most 65,535 (2.0)
+// Inputs: f, pointer to the filter
+//         in, n input samples
+//         out, space for n output samples (may be in)
+//         n, block size, even, 2 to MaxBlock
+// Outputs: none
+void DSP_FIR(firType *f, const int16_t *in, int16_t *out, uint32_t n);
+
+// Second-order IIR section (biquad), direct form I
+// y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
+// Coefficients are Q14 (16,384 is 1.0), so |a1| can reach 2.
+// The recursion leaves no pairs of samples to work on at
+// once, so this kernel is scalar multiply-accumulate into 64
+// bits, since five full-scale Q14 products exceed 32 bits.
+struct biquad{
+  int16_t B0, B1, B2, A1, A2; // Q14 coefficients
+  int16_t X1, X2, Y1, Y2;     // past inputs and outputs
+};
+typedef struct biquad biquadType;
+
+//******DSP_Biquad_Init************
+// Set up a biquad with all past values 0
+// Inputs: f, pointer to the section
+//         b0, b1, b2, a1, a2, Q14 coefficients
+// Outputs: none
+void DSP_Biquad_Init(biquadType *f, int16_t b0, int16_t b1, int16_t b2,
+                     int16_t a1, int16_t a2);
+
+//******DSP_Biquad************
+// Filter one block, rounding and saturating to 16 bits
+// Inputs: f, pointer to the section
+//         in, n input samples
+//         out, space for n output samples (may be in)
+//         n, number of samples
+// Outputs: none
+void DSP_Biquad(biquadType *f, const int16_t *in, int16_t *out, uint32_t n);
+
+//******DSP_Decimate************
+// Average each group of factor samples into one (boxcar
+// filter and downsample), for example 8 kHz sound to 1 kHz
+// Inputs: in, n input samples, 32-bit aligned
+//         out, space for n/factor outputs (may be in)
+//         n, number of input samples, multiple of factor
+//         factor, even, 2 to 65,536
+// Outputs: number of outputs, n/factor
+uint32_t DSP_Decimate(const int16_t *in, int16_t *out, uint32_t n, uint32_t factor);
@@ -0,0 +1,131 @@
+// FixedMath.c
+// Integer math helpers shared by the labs
+// No divides, so run times do not depend on the input.
+// Runs on any microcontroller
+
+#include <stdint.h>
+#include "FixedMath.h"
+
+//******sqrt32************
+// Integer square root, bit by bit, 16 iterations
+// of a compare, a subtract and two shifts
+// Inputs: s, any 32-bit number
+// Outputs: floor(sqrt(s)), 0 to 65,535
+uint32_t sqrt32(uint32_t s){
+  uint32_t root = 0;      // result bits found so far, scaled by bit
+  uint32_t bit = 0x40000000; // 4^15, highest power of 4 in 32 bits
+  int n;
+  for(n = 16; n; --n){    // one result bit per iteration
+    if(s >= root + bit){
+      s = s - (root + bit);
+      root = (root>>1) + bit;
+    } else{
+      root = root>>1;
+    }
+    bit = bit>>2;
+  }
+  return root;
+}
+
+//******sqrt32_Newton************
+// Previous square root: 16 iterations of Newton's method,
+// each with two 32-bit divides.  Kept for comparison only;
+// the result can be one too large near perfect squares, and
+// is 0 for 128 inputs near 2^20, where t*t overflows and t
+// becomes 0 (a Cortex-M divide by 0 gives 0).
+// Inputs: s, 0 to 3*1023*1023
+// Outputs: approximately sqrt(s)
+uint32_t sqrt32_Newton(uint32_t s){
+  uint32_t t;          // t*t will become s
+  int n;               // loop counter
+  t = s/16+1;          // initial guess
+  for(n = 16; n; --n){ // will finish
+    if(t == 0){
+      return 0;        // same result as dividing by 0 on the Cortex-M
+    }
+    t = ((t*t+s)/t)/2;
+  }
+  return t;
+}
+
+//******RMS_Init************
+// Start a running RMS with no samples
+// Inputs: r, pointer to the state
+//         window, array of length samples for a sliding
+//           window, or 0 for one result per block
+//         length, samples per block or window, 1 to 65,535
+// Outputs: none
+void RMS_Init(rmsType *r, int16_t *window, uint32_t length){
+  r->Window = window;
+  r->Length = length;
+  r->Count = 0;
+  r->Index = 0;
+  r->Sum = 0;
+  r->SumSq = 0;
+  r->BlockSum = 0;
+  r->BlockSumSq = 0;
+}
+
+//******RMS_Put************
+// Add one sample, constant time
+// Inputs: r, pointer to the state
+//         x, sample, -32,768 to 32,767
+// Outputs: 1 if a block just finished (block mode), else 0
+uint32_t RMS_Put(rmsType *r, int32_t x){ int32_t old;
+  r->Sum = r->Sum + x;
+  r->SumSq = r->SumSq + (uint32_t)(x*x);
+  if(r->Window){              // sliding window
+    if(r->Count == r->Length){
+      old = r->Window[r->Index];  // drop the oldest sample
+      r->Sum = r->Sum - old;
+      r->SumSq = r->SumSq - (uint32_t)(old*old);
+    } else{
+      r->Count = r->Count + 1;
+    }
+    r->Window[r->Index] = x;
+    r->Index = r->Index + 1;
+    if(r->Index == r->Length){
+      r->Index = 0;
+    }
+    return 0;
+  }
+  r->Count = r->Count + 1;    // block
+  if(r->Count < r->Length){
+    return 0;
+  }
+  r->BlockSum = r->Sum;
+  r->BlockSumSq = r->SumSq;
+  r->Count = 0;
+  r->Sum = 0;
+  r->SumSq = 0;
+  return 1;
+}
+
+//******RMS_Get************
+// Root mean square of the samples about their mean: the
+// last full block, or the samples now in the sliding window
+// RMS_Put() must not run during RMS_Get(), so if RMS_Put()
+// is called from an interrupt, call this inside a critical
+// section.
+// The result is the exact floor of the RMS.  The rescan Task0
+// used before subtracted a truncated mean, so it read one
+// higher just above perfect squares (3 of 2000 blocks in
+// Lab1_Host/RmsTest.c).
+// Inputs: r, pointer to the state
+// Outputs: floor of the RMS, 0 if there are no samples yet
+uint32_t RMS_Get(rmsType *r){ uint64_t n, sum, sumsq;
+  if(r->Window){
+    n = r->Count;
+    sum = (uint64_t)((int64_t)r->Sum*r->Sum);
+    sumsq = r->SumSq;
+  } else{
+    n = r->Length;
+    sum = (uint64_t)((int64_t)r->BlockSum*r->BlockSum);
+    sumsq = r->BlockSumSq;
+  }
+  if(n == 0){
+    return 0;
+  }
+  // variance = (n*sum(x*x) - sum(x)^2)/n^2, never negative
+  return sqrt32((uint32_t)((n*sumsq - sum)/(n*n)));
+}
@@ -0,0 +1,70 @@
+// FixedMath.h
+// Integer math helpers shared by the labs
+// No divides, so run times do not depend on the input.
+// Runs on any microcontroller
+
+//******sqrt32************
+// Integer square root, bit by bit, 16 iterations
+// of a compare, a subtract and two shifts
+// Inputs: s, any 32-bit number
+// Outputs: floor(sqrt(s)), 0 to 65,535
+uint32_t sqrt32(uint32_t s);
+
+//******sqrt32_Newton************
+// Previous square root: 16 iterations of Newton's method,
+// each with two 32-bit divides.  Kept for comparison only;
+// the result can be one too large near perfect squares, and
+// is 0 for 128 inputs near 2^20, where t*t overflows and t
+// becomes 0 (a Cortex-M divide by 0 gives 0).
+// Inputs: s, 0 to 3*1023*1023
+// Outputs: approximately sqrt(s)
+uint32_t sqrt32_Newton(uint32_t s);
+
+// Running root mean square (standard deviation) of samples
+// In block mode one result is made every Length samples.  In
+// sliding mode the result covers the most recent Length
+// samples, kept in a caller-supplied window array.  Either
+// way each sample costs a few adds and one multiply, using
+// running sums of x and x*x; the square root is only taken
+// when the result is read.
+struct rms{
+  int16_t *Window;        // last Length samples, 0 in block mode
+  uint32_t Length;        // samples per block or window
+  uint32_t Count;         // samples in the running sums
+  uint32_t Index;         // next place in Window
+  int32_t Sum;            // sum of x
+  uint64_t SumSq;         // sum of x*x
+  int32_t BlockSum;       // sums of the last full block
+  uint64_t BlockSumSq;
+};
+typedef struct rms rmsType;
+
+//******RMS_Init************
+// Start a running RMS with no samples
+// Inputs: r, pointer to the state
+//         window, array of length samples for a sliding
+//           window, or 0 for one result per block
+//         length, samples per block or window, 1 to 65,535
+// Outputs: none
+void RMS_Init(rmsType *r, int16_t *window, uint32_t length);
+
+//******RMS_Put************
+// Add one sample, constant time
+// Inputs: r, pointer to the state
+//         x, sample, -32,768 to 32,767
+// Outputs: 1 if a block just finished (block mode), else 0
+uint32_t RMS_Put(rmsType *r, int32_t x);
+
+//******RMS_Get************
+// Root mean square of the samples about their mean: the
+// last full block, or the samples now in the sliding window
+// RMS_Put() must not run during RMS_Get(), so if RMS_Put()
+// is called from an interrupt, call this inside a critical
+// section.
+// The result is the exact floor of the RMS.  The rescan Task0
+// used before subtracted a truncated mean, so it read one
+// higher just above perfect squares (3 of 2000 blocks in
+// Lab1_Host/RmsTest.c).
+// Inputs: r, pointer to the state
+// Outputs: floor of the RMS, 0 if there are no samples yet
+uint32_t RMS_Get(rmsType *r);
@@ -0,0 +1,147 @@
+// History.c
+// Timestamped history of sensor samples
+// Runs on MSP432 or a host computer
+
+#include <stdint.h>
+#include "History.h"
+#include "Barrier.h"
+
+//******Hist_Init************
+// Start an empty history
+// Inputs: h, pointer to the history
+//         buf, array of size samples
+//         size, number of samples kept, power of 2
+// Outputs: none
+void Hist_Init(historyType *h, histSampleType *buf, uint32_t size){
+  h->Buf = buf;
+  h->Size = size;
+  h->Count = 0;
+}
+
+//******Hist_Put************
+// Add one sample, overwriting the oldest if full.
+// Call from one producer only.
+// Inputs: h, pointer to the history
+//         time, when the sample was taken, in usec
+//         value, the sample
+// Outputs: none
+void Hist_Put(historyType *h, uint32_t time, int32_t value){
+  histSampleType *s = &h->Buf[h->Count&(h->Size-1)];
+  s->Time = time;
+  s->Value = value;
+  BARRIER();
+  h->Count = h->Count + 1;         // publish after the data are stored
+}
+
+// copy sample number i; 1 if it was not overwritten while copying
+// (when Count is i+Size the producer may be writing over it)
+uint32_t static get(historyType *h, uint32_t i, histSampleType *s){
+  *s = h->Buf[i&(h->Size-1)];
+  return (h->Count - i) < h->Size;
+}
+
+//******Hist_Latest************
+// Copy the newest sample
+// Inputs: h, pointer to the history
+//         s, place to put the sample
+// Outputs: 1 if a sample was copied, 0 if the history is empty
+uint32_t Hist_Latest(historyType *h, histSampleType *s){ uint32_t count;
+  do{
+    count = h->Count;
+    if(count == 0){
+      return 0;
+    }
+  } while(get(h, count - 1, s) == 0);
+  return 1;
+}
+
+//******Hist_Window************
+// Copy the samples taken from time start up to, but not
+// including, time end, oldest first.  If the window holds
+// more than max samples, the newest max are copied.
+// Samples overwritten while copying are left out.
+// Inputs: h, pointer to the history
+//         start, end, window in usec
+//         out, array of max samples
+//         max, size of out
+// Outputs: number of samples copied
+uint32_t Hist_Window(historyType *h, uint32_t start, uint32_t end,
+                     histSampleType *out, uint32_t max){
+  uint32_t count, first, last, i, n;
+  histSampleType s;
+  count = h->Count;
+  last = count;                    // one past the newest sample in the window
+  // walk back from the newest sample, times are in order
+  while((count - last) < h->Size && last){
+    if(get(h, last - 1, &s) == 0){
+      return 0;                    // the producer lapped us
+    }
+    if((int32_t)(s.Time - end) < 0){
+      break;                       // before end
+    }
+    last = last - 1;
+  }
+  first = last;
+  while(((count - first) < h->Size) && first && ((last - first) < max)){
+    if(get(h, first - 1, &s) == 0){
+      break;                       // the rest has been overwritten
+    }
+    if((int32_t)(s.Time - start) < 0){
+      break;                       // before start
+    }
+    first = first - 1;
+  }
+  n = 0;
+  for(i=first; i!=last; i=i+1){
+    if(get(h, i, &out[n])){
+      n = n + 1;
+    }
+  }
+  return n;
+}
+
+//******Hist_Gaps************
+// Measure the time between the newest n samples, for the
+// jitter of a periodic task or the rate of a sensor
+// Inputs: h, pointer to the history
+//         n, number of samples, 2 to Size-1
+//         gaps, place for the results
+// Outputs: none
+void Hist_Gaps(historyType *h, uint32_t n, histGapsType *gaps){
+  uint32_t count, i, gap, sum = 0, have = 0;
+  histSampleType s, prev;
+  gaps->Number = 0;
+  gaps->Min = 0xFFFFFFFF;
+  gaps->Max = 0;
+  count = h->Count;
+  if(n > count){
+    n = count;
+  }
+  if(n >= h->Size){
+    n = h->Size - 1;
+  }
+  if(n < 2){
+    gaps->Min = gaps->Average = 0;
+    return;
+  }
+  for(i=count-n; i!=count; i=i+1){
+    if(get(h, i, &s) == 0){
+      have = 0;                    // overwritten, start again after it
+      continue;
+    }
+    if(have){
+      gap = s.Time - prev.Time;
+      if(gap < gaps->Min){
+        gaps->Min = gap;
+      }
+      if(gap > gaps->Max){
+        gaps->Max = gap;
+      }
+      sum = sum + gap;
+      gaps->Number = gaps->Number + 1;
+    }
+    prev = s;
+    have = 1;
+  }
+  gaps->Average = gaps->Number ? sum/gaps->Number : 0;
+}
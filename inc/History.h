@@ -0,0 +1,77 @@
+// History.h
+// Timestamped history of sensor samples
+// One producer (an ISR or a thread) puts {time, value}
+// pairs into a ring; any number of consumers read the most
+// recent samples or the samples in a time window without
+// disabling interrupts.  Times are BSP_Time_Get()
+// microseconds, compared by difference so a roll over of the
+// 32-bit time does not matter.
+// Runs on MSP432 or a host computer
+
+struct histsample{
+  uint32_t Time;          // usec
+  int32_t Value;
+};
+typedef struct histsample histSampleType;
+
+struct history{
+  histSampleType *Buf;    // Size samples
+  uint32_t Size;          // power of 2
+  volatile uint32_t Count;// samples ever put, written only by the producer
+};
+typedef struct history historyType;
+
+// statistics of the gaps between samples
+struct histgaps{
+  uint32_t Number;        // gaps measured
+  uint32_t Min;           // usec
+  uint32_t Max;           // usec
+  uint32_t Average;       // usec
+};
+typedef struct histgaps histGapsType;
+
+//******Hist_Init************
+// Start an empty history
+// Inputs: h, pointer to the history
+//         buf, array of size samples
+//         size, number of samples kept, power of 2
+// Outputs: none
+void Hist_Init(historyType *h, histSampleType *buf, uint32_t size);
+
+//******Hist_Put************
+// Add one sample, overwriting the oldest if full.
+// Call from one producer only.
+// Inputs: h, pointer to the history
+//         time, when the sample was taken, in usec
+//         value, the sample
+// Outputs: none
+void Hist_Put(historyType *h, uint32_t time, int32_t value);
+
+//******Hist_Latest************
+// Copy the newest sample
+// Inputs: h, pointer to the history
+//         s, place to put the sample
+// Outputs: 1 if a sample was copied, 0 if the history is empty
+uint32_t Hist_Latest(historyType *h, histSampleType *s);
+
+//******Hist_Window************
+// Copy the samples taken from time start up to, but not
+// including, time end, oldest first.  If the window holds
+// more than max samples, the newest max are copied.
+// Samples overwritten while copying are left out.
+// Inputs: h, pointer to the history
+//         start, end, window in usec
+//         out, array of max samples
+//         max, size of out
+// Outputs: number of samples copied
+uint32_t Hist_Window(historyType *h, uint32_t start, uint32_t end,
+                     histSampleType *out, uint32_t max);
+
+//******Hist_Gaps************
+// Measure the time between the newest n samples, for the
+// jitter of a periodic task or the rate of a sensor
+// Inputs: h, pointer to the history
+//         n, number of samples, 2 to Size-1
+//         gaps, place for the results
+// Outputs: none
+void Hist_Gaps(historyType *h, uint32_t n, histGapsType *gaps);
@@ -0,0 +1,215 @@
+// Pipeline.c
+// Sensor pipelines built from stages joined by FIFOs
+// Runs on MSP432 or a host computer
+
+#include <stdint.h>
+#include "Pipeline.h"
+#include "FixedMath.h"
+#include "Barrier.h"
+
+//******Pipe_Init************
+// Start an empty pipeline
+// Inputs: p, pointer to the pipeline
+//         clock, function returning an increasing time,
+//           such as BSP_Time_Get, or 0 for no timing
+// Outputs: none
+void Pipe_Init(pipelineType *p, uint32_t (*clock)(void)){
+  p->NumStages = 0;
+  p->Clock = clock;
+}
+
+//******Pipe_AddStage************
+// Add a stage.  Add stages from source to sink, so one
+// Pipe_Run() can carry a sample all the way through.
+// Inputs: p, pointer to the pipeline
+//         s, pointer to the stage's storage
+//         name, for reports
+//         fn, the stage function
+//         state, passed to fn
+// Outputs: 0 if success, -1 if the pipeline is full
+int Pipe_AddStage(pipelineType *p, pipeStageType *s, const char *name,
+                  pipeFnType fn, void *state){ int i;
+  if(p->NumStages == PIPEMAXSTAGES){
+    return -1;
+  }
+  s->Name = name;
+  s->Fn = fn;
+  s->State = state;
+  for(i=0; i<PIPEMAXOUT; i=i+1){
+    s->Next[i] = 0;
+  }
+  s->PutI = s->GetI = 0;
+  s->In = s->Out = s->Dropped = s->Blocked = 0;
+  s->Time = s->MaxTime = 0;
+  p->Stage[p->NumStages] = s;
+  p->NumStages = p->NumStages + 1;
+  return 0;
+}
+
+//******Pipe_Connect************
+// Send the results of one stage to another
+// Inputs: from, producing stage
+//         to, consuming stage
+// Outputs: 0 if success, -1 if from already feeds PIPEMAXOUT stages
+int Pipe_Connect(pipeStageType *from, pipeStageType *to){ int i;
+  for(i=0; i<PIPEMAXOUT; i=i+1){
+    if(from->Next[i] == 0){
+      from->Next[i] = to;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+//******Pipe_Put************
+// Give one sample to a stage, from a source.  One
+// producer per stage; safe from an ISR.
+// Inputs: s, pointer to the stage
+//         x, the sample
+// Outputs: 0 if success, -1 if the FIFO is full (counted in Dropped)
+int Pipe_Put(pipeStageType *s, int32_t x){
+  if((s->PutI - s->GetI) == PIPEFIFOSIZE){
+    s->Dropped = s->Dropped + 1;
+    return -1;
+  }
+  s->Fifo[s->PutI&(PIPEFIFOSIZE-1)] = x;
+  BARRIER();                      // sample stored before Pipe_Run() sees PutI
+  s->PutI = s->PutI + 1;          // publish after the data is stored
+  s->In = s->In + 1;
+  return 0;
+}
+
+// 1 if every stage fed by s has room for one more sample
+uint32_t static room(pipeStageType *s){ int i;
+  for(i=0; i<PIPEMAXOUT; i=i+1){
+    if(s->Next[i] && ((s->Next[i]->PutI - s->Next[i]->GetI) == PIPEFIFOSIZE)){
+      return 0;
+    }
+  }
+  return 1;
+}
+
+//******Pipe_Run************
+// Process every sample that can move, visiting stages in
+// the order they were added.  Call from one thread only.
+// Inputs: p, pointer to the pipeline
+// Outputs: number of samples processed by all stages
+uint32_t Pipe_Run(pipelineType *p){
+  pipeStageType *s;
+  uint32_t i, j, count = 0, start = 0, time;
+  int32_t out;
+  for(i=0; i<p->NumStages; i=i+1){
+    s = p->Stage[i];
+    while(s->GetI != s->PutI){
+      if(room(s) == 0){           // back pressure, try again next run
+        s->Blocked = s->Blocked + 1;
+        break;
+      }
+      if(p->Clock){
+        start = p->Clock();
+      }
+      j = s->Fn(s->State, s->Fifo[s->GetI&(PIPEFIFOSIZE-1)], &out);
+      if(p->Clock){
+        time = p->Clock() - start;
+        s->Time = s->Time + time;
+        if(time > s->MaxTime){
+          s->MaxTime = time;
+        }
+      }
+      s->GetI = s->GetI + 1;
+      count = count + 1;
+      if(j){
+        s->Out = s->Out + 1;
+        for(j=0; j<PIPEMAXOUT; j=j+1){
+          if(s->Next[j]){
+            Pipe_Put(s->Next[j], out);
+          }
+        }
+      }
+    }
+  }
+  return count;
+}
+
+//******Pipe_Sqrt************
+// Square root, for magnitude from x*x+y*y+z*z
+// state is not used
+uint32_t Pipe_Sqrt(void *state, int32_t in, int32_t *out){
+  *out = sqrt32(in);
+  return 1;
+}
+
+uint32_t Pipe_EWMA(void *state, int32_t in, int32_t *out){
+  pipeEWMAType *f = state;
+  if(f->Started == 0){
+    f->Value = in;                // the first sample is the best guess
+    f->Started = 1;
+  } else{
+    f->Value = ((int32_t)f->Alpha*in + (int32_t)(1023 - f->Alpha)*f->Value)/1024;
+  }
+  *out = f->Value;
+  return 1;
+}
+
+uint32_t Pipe_Decimate(void *state, int32_t in, int32_t *out){
+  pipeDecimateType *f = state;
+  f->Sum = f->Sum + in;
+  f->Count = f->Count + 1;
+  if(f->Count < f->Factor){
+    return 0;
+  }
+  *out = f->Sum/(int32_t)f->Factor;
+  f->Count = 0;
+  f->Sum = 0;
+  return 1;
+}
+
+uint32_t Pipe_RMS(void *state, int32_t in, int32_t *out){
+  if(RMS_Put(state, in) == 0){
+    return 0;
+  }
+  *out = RMS_Get(state);
+  return 1;
+}
+
+uint32_t Pipe_Scale(void *state, int32_t in, int32_t *out){
+  pipeScaleType *f = state;
+  *out = (in*f->Mul)/f->Div;
+  return 1;
+}
+
+uint32_t Pipe_Notify(void *state, int32_t in, int32_t *out){
+  pipeNotifyType *f = state;
+  f->Data = in;
+  if(f->Enabled && (f->Enabled(f->Index) == 0)){
+    return 0;                     // client has not asked for notifications
+  }
+  if(f->Send(f->Index) == 1){
+    f->Sent = f->Sent + 1;
+  } else{
+    f->Errors = f->Errors + 1;
+  }
+  return 0;
+}
+
+// store x in 4 bytes, little endian
+void static put32(uint8_t *pt, uint32_t x){
+  pt[0] = x;
+  pt[1] = x>>8;
+  pt[2] = x>>16;
+  pt[3] = x>>24;
+}
+
+uint32_t Pipe_Log(void *state, int32_t in, int32_t *out){
+  pipeLogType *f = state;
+  uint8_t record[PIPELOGSIZE];
+  record[0] = f->Tag;
+  put32(&record[1], f->Clock ? f->Clock() : 0);
+  put32(&record[5], in);
+  if(f->Write(f->File, record, PIPELOGSIZE) == 0){
+    f->Records = f->Records + 1;
+  } else{
+    f->Errors = f->Errors + 1;
+  }
+  return 0;
+}
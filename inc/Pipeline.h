@@ -0,0 +1,172 @@
+// Pipeline.h
+// Sensor pipelines built from stages joined by FIFOs
+// A source (an ISR or periodic thread) puts samples into the
+// first stage.  Pipe_Run(), called from one consumer thread,
+// moves samples through filter, decimate and detect stages
+// to sinks such as an LCD plot or a log.  A stage runs only
+// when every stage it feeds has room, so a slow sink backs
+// up the pipeline until the source sees a full FIFO, the
+// same -1 that OS_FIFO_Put() returns.  Nothing here touches
+// hardware, so the same graph runs on a host computer fed
+// from a recorded trace.
+// Runs on MSP432 or a host computer
+
+#define PIPEFIFOSIZE 32     // samples waiting at each stage, power of 2,
+                            // holds a 100 ms accelerometer block at 200 Hz
+#define PIPEMAXOUT    3     // stages fed by one stage, such as display, notify and log
+#define PIPEMAXSTAGES 8     // stages in one pipeline
+
+// Stage function
+// Inputs: state, the stage's private data
+//         in, one sample
+//         out, place for one result
+// Outputs: 1 if *out holds a result to pass on, 0 if not
+//          (a decimator or detector passes on fewer samples)
+typedef uint32_t (*pipeFnType)(void *state, int32_t in, int32_t *out);
+
+struct pipestage{
+  const char *Name;
+  pipeFnType Fn;
+  void *State;
+  struct pipestage *Next[PIPEMAXOUT]; // stages fed by this one, 0 if none
+  int32_t Fifo[PIPEFIFOSIZE];         // samples waiting for this stage
+  volatile uint32_t PutI;             // written only by the producer
+  volatile uint32_t GetI;             // written only by Pipe_Run()
+  // counters, cleared by Pipe_AddStage()
+  uint32_t In;            // samples accepted into the FIFO
+  uint32_t Out;           // results passed on
+  uint32_t Dropped;       // samples refused because the FIFO was full
+  uint32_t Blocked;       // times the stage waited for a full next stage
+  uint32_t Time;          // total clock ticks spent in Fn
+  uint32_t MaxTime;       // longest single call of Fn
+};
+typedef struct pipestage pipeStageType;
+
+struct pipeline{
+  pipeStageType *Stage[PIPEMAXSTAGES]; // in the order Pipe_Run() visits them
+  uint32_t NumStages;
+  uint32_t (*Clock)(void);             // increasing time for the counters, or 0
+};
+typedef struct pipeline pipelineType;
+
+//******Pipe_Init************
+// Start an empty pipeline
+// Inputs: p, pointer to the pipeline
+//         clock, function returning an increasing time,
+//           such as BSP_Time_Get, or 0 for no timing
+// Outputs: none
+void Pipe_Init(pipelineType *p, uint32_t (*clock)(void));
+
+//******Pipe_AddStage************
+// Add a stage.  Add stages from source to sink, so one
+// Pipe_Run() can carry a sample all the way through.
+// Inputs: p, pointer to the pipeline
+//         s, pointer to the stage's storage
+//         name, for reports
+//         fn, the stage function
+//         state, passed to fn
+// Outputs: 0 if success, -1 if the pipeline is full
+int Pipe_AddStage(pipelineType *p, pipeStageType *s, const char *name,
+                  pipeFnType fn, void *state);
+
+//******Pipe_Connect************
+// Send the results of one stage to another
+// Inputs: from, producing stage
+//         to, consuming stage
+// Outputs: 0 if success, -1 if from already feeds PIPEMAXOUT stages
+int Pipe_Connect(pipeStageType *from, pipeStageType *to);
+
+//******Pipe_Put************
+// Give one sample to a stage, from a source.  One
+// producer per stage; safe from an ISR.
+// Inputs: s, pointer to the stage
+//         x, the sample
+// Outputs: 0 if success, -1 if the FIFO is full (counted in Dropped)
+int Pipe_Put(pipeStageType *s, int32_t x);
+
+//******Pipe_Run************
+// Process every sample that can move, visiting stages in
+// the order they were added.  Call from one thread only.
+// Inputs: p, pointer to the pipeline
+// Outputs: number of samples processed by all stages
+uint32_t Pipe_Run(pipelineType *p);
+
+// Stages used by the labs
+
+//******Pipe_Sqrt************
+// Square root, for magnitude from x*x+y*y+z*z
+// state is not used
+uint32_t Pipe_Sqrt(void *state, int32_t in, int32_t *out);
+
+// Exponentially weighted moving average
+// Value = (Alpha*in + (1023-Alpha)*Value)/1024, first sample copied
+struct pipeewma{
+  uint32_t Alpha;         // 0 to 1023, higher follows faster
+  int32_t Value;
+  uint32_t Started;       // 0 until the first sample
+};
+typedef struct pipeewma pipeEWMAType;
+uint32_t Pipe_EWMA(void *state, int32_t in, int32_t *out);
+
+// Average each Factor samples into one
+struct pipedecimate{
+  uint32_t Factor;
+  uint32_t Count;
+  int32_t Sum;
+};
+typedef struct pipedecimate pipeDecimateType;
+uint32_t Pipe_Decimate(void *state, int32_t in, int32_t *out);
+
+// RMS of each block of samples, state is a rmsType from
+// RMS_Init() in FixedMath.h with no window
+uint32_t Pipe_RMS(void *state, int32_t in, int32_t *out);
+
+// Scale each sample, out = in*Mul/Div, for sensor units
+// in*Mul must fit in 32 bits
+struct pipescale{
+  int32_t Mul;
+  int32_t Div;
+};
+typedef struct pipescale pipeScaleType;
+uint32_t Pipe_Scale(void *state, int32_t in, int32_t *out);
+
+// Sinks for the Bluetooth and flash file system labs
+// They take the driver functions as pointers, so nothing here
+// depends on AP.c or eFile.c, and a host computer can pass in
+// stand-ins.
+
+// Bluetooth notify sink
+// Each sample is copied into Data, the user data given to
+// AP_AddNotifyCharacteristic(uuid, 4, &n.Data, ...), then
+// Send(Index) notifies the client.  Only one thread may talk
+// to the BLE module, so use notify sinks in one pipeline, or
+// guard Send with a mutex.
+struct pipenotify{
+  int32_t Data;           // characteristic value, 4 bytes little endian
+  uint32_t Index;         // notify characteristic number
+  uint16_t (*Enabled)(uint32_t i); // AP_GetNotifyCCCD, or 0 to always send
+  int (*Send)(uint32_t i);         // AP_SendNotification, APOK (1) if success
+  uint32_t Sent;          // notifications sent
+  uint32_t Errors;        // Send failed
+};
+typedef struct pipenotify pipeNotifyType;
+uint32_t Pipe_Notify(void *state, int32_t in, int32_t *out);
+
+// Log sink
+// Each sample becomes one PIPELOGSIZE-byte record
+//   Tag, then Time and the sample, 4 bytes each, little endian
+// written with Write(File, record, PIPELOGSIZE).  Write has the
+// form of OS_File_Write() in eFile.h, which packs records into
+// flash; a Tag that is not 0xFF keeps a record from looking
+// like the padding after OS_File_Flush().
+#define PIPELOGSIZE 9
+struct pipelog{
+  uint8_t (*Write)(uint16_t num, const uint8_t *ptr, uint32_t len); // 0 if success
+  uint16_t File;          // file number given to Write
+  uint8_t Tag;            // first byte of each record, not 0xFF
+  uint32_t (*Clock)(void);// time of each record, such as BSP_Time_Get, or 0
+  uint32_t Records;       // records written
+  uint32_t Errors;        // Write failed, such as disk full
+};
+typedef struct pipelog pipeLogType;
+uint32_t Pipe_Log(void *state, int32_t in, int32_t *out);